@@ -0,0 +1,19 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aCol;
+layout (location = 2) in vec2 aTex;
+// per instance, locations 3 to 6 are the columns of the model matrix
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in vec3 aTint;
+
+out vec3 vColor;
+out vec2 texCoord;
+
+uniform mat4 vp;
+
+void main()
+{
+    gl_Position = vp * aModel * vec4(aPos, 1.0);
+    vColor = aCol * aTint;
+    texCoord = aTex;
+}
@@ -7,10 +7,12 @@ const float borderThickness = 0.05;
 
 void main()
 {
-    float left = step(borderThickness, texCoord.x);
-    float bottom = step(borderThickness, texCoord.y);
-    float right = step(texCoord.x, 1 - borderThickness);
-    float top = step(texCoord.y, 1 - borderThickness);
+    // merged quads count texCoord up in tiles, the border is drawn around each of them
+    vec2 tile = fract(texCoord);
+    float left = step(borderThickness, tile.x);
+    float bottom = step(borderThickness, tile.y);
+    float right = step(tile.x, 1 - borderThickness);
+    float top = step(tile.y, 1 - borderThickness);
 
     vec3 mask = vec3(left * bottom * right * top);
 
@@ -141,6 +141,11 @@ void Camera::SetPos(const glm::vec3& pos) {
     m_CameraPos = pos;
 }
 
+void Camera::SetOrbitTarget(const glm::vec3& target) {
+    m_CameraPos += target - m_OrbitTarget;
+    m_OrbitTarget = target;
+}
+
 void Camera::Orbit(int xoffset, int yoffset) {
     /*
        this is fine, blender style orbit camera probably requires a completely different 
@@ -66,6 +66,8 @@ public:
     void Pan(int xoffset, int yoffset);
     void Zoom(int verticalScroll);
     void SetPos(const glm::vec3& pos);
+    // moves the camera along, so it keeps looking at the target the same way
+    void SetOrbitTarget(const glm::vec3& target);
     void FlipMode();
     void FlipType();
 
@@ -73,6 +75,10 @@ public:
         return m_CameraPos;
     }
 
+    inline const glm::vec3& GetOrbitTarget() const {
+        return m_OrbitTarget;
+    }
+
     inline const glm::vec3& GetFront() const {
         return m_CameraFront;
     }
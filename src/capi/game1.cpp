@@ -0,0 +1,156 @@
+#include "game1.h"
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include "core/batchEnv.h"
+#include "core/levelFile.h"
+#include "core/rules.h"
+
+struct game1_level {
+    LevelState state;
+};
+
+struct game1_env {
+    core::BatchEnv env;
+};
+
+static thread_local std::string lastError;
+
+static int fail(int code, std::string message) {
+    lastError = std::move(message);
+    return code;
+}
+
+// no exception is allowed to cross the C boundary
+template<typename F>
+static auto guarded(F&& fn, decltype(fn()) onError) -> decltype(fn()) {
+    try {
+        return fn();
+    } catch (const std::bad_alloc&) {
+        fail(GAME1_ERROR_OUT_OF_MEMORY, "out of memory");
+    } catch (const std::exception& e) {
+        fail(GAME1_ERROR_INVALID_ARGUMENT, e.what());
+    }
+    return onError;
+}
+
+extern "C" {
+
+    int game1_api_version(void) {
+        return GAME1_API_VERSION;
+    }
+
+    const char* game1_last_error(void) {
+        return lastError.c_str();
+    }
+
+    game1_level* game1_level_load(const char* path) {
+        if (path == nullptr) {
+            fail(GAME1_ERROR_INVALID_ARGUMENT, "path is NULL");
+            return nullptr;
+        }
+        return guarded([&]() -> game1_level* {
+            auto level = std::make_unique<game1_level>(core::makeLevelState(1));
+            std::string error;
+            if (!core::loadLevelFile(path, level->state, error)) {
+                fail(GAME1_ERROR_IO, error);
+                return nullptr;
+            }
+            return level.release();
+        }, nullptr);
+    }
+
+    game1_level* game1_level_parse(const char* text) {
+        if (text == nullptr) {
+            fail(GAME1_ERROR_INVALID_ARGUMENT, "text is NULL");
+            return nullptr;
+        }
+        return guarded([&]() -> game1_level* {
+            auto level = std::make_unique<game1_level>(core::makeLevelState(1));
+            std::istringstream in(text);
+            std::string error;
+            if (!core::readLevel(in, level->state, error)) {
+                fail(GAME1_ERROR_INVALID_ARGUMENT, error);
+                return nullptr;
+            }
+            return level.release();
+        }, nullptr);
+    }
+
+    void game1_level_free(game1_level* level) {
+        delete level;
+    }
+
+    int game1_level_side_length(const game1_level* level) {
+        if (level == nullptr)
+            return fail(GAME1_ERROR_INVALID_ARGUMENT, "level is NULL");
+        return level->state.tiles.GetSideLength();
+    }
+
+    game1_env* game1_env_create(const game1_level* level, int num_instances, int num_threads) {
+        if (level == nullptr || num_instances <= 0 || num_threads <= 0) {
+            fail(GAME1_ERROR_INVALID_ARGUMENT, "invalid level, instance or thread count");
+            return nullptr;
+        }
+        return guarded([&]() -> game1_env* {
+            return new game1_env{ core::BatchEnv(level->state, num_instances, num_threads) };
+        }, nullptr);
+    }
+
+    void game1_env_free(game1_env* env) {
+        delete env;
+    }
+
+    int game1_env_num_instances(const game1_env* env) {
+        if (env == nullptr)
+            return fail(GAME1_ERROR_INVALID_ARGUMENT, "env is NULL");
+        return env->env.GetNumInstances();
+    }
+
+    int game1_env_plane_words(const game1_env* env) {
+        if (env == nullptr)
+            return fail(GAME1_ERROR_INVALID_ARGUMENT, "env is NULL");
+        return env->env.GetPlaneWords();
+    }
+
+    int game1_env_bind(game1_env* env, const game1_observations* observations) {
+        if (env == nullptr || observations == nullptr)
+            return fail(GAME1_ERROR_INVALID_ARGUMENT, "env or observations is NULL");
+        env->env.Bind(core::BatchBuffers{
+            observations->x,
+            observations->z,
+            observations->orientation,
+            observations->dark,
+            observations->moved,
+            observations->done,
+            observations->light
+        });
+        return GAME1_OK;
+    }
+
+    int game1_env_reset(game1_env* env) {
+        if (env == nullptr)
+            return fail(GAME1_ERROR_INVALID_ARGUMENT, "env is NULL");
+        env->env.Reset();
+        return GAME1_OK;
+    }
+
+    int game1_env_reset_where(game1_env* env, const uint8_t* mask) {
+        if (env == nullptr || mask == nullptr)
+            return fail(GAME1_ERROR_INVALID_ARGUMENT, "env or mask is NULL");
+        for (int i = 0; i < env->env.GetNumInstances(); i++) {
+            if (mask[i])
+                env->env.Reset(i);
+        }
+        return GAME1_OK;
+    }
+
+    int game1_env_step(game1_env* env, const uint8_t* actions) {
+        if (env == nullptr || actions == nullptr)
+            return fail(GAME1_ERROR_INVALID_ARGUMENT, "env or actions is NULL");
+        env->env.Step(actions);
+        return GAME1_OK;
+    }
+
+}
@@ -0,0 +1,88 @@
+#ifndef GAME1_H
+#define GAME1_H
+
+/*
+    C interface of the game rules (libgame1).
+
+    Levels are loaded from the editor's text format, environments hold any number of
+    independent games on one level and step them all with one call. The observations
+    are written straight into arrays owned by the caller (game1_env_bind), so reading
+    them after a step needs no copy and no call.
+
+    Functions returning int give GAME1_OK or a negative error code, functions returning
+    a pointer give NULL on failure. game1_last_error() describes the last failure of
+    the calling thread. The ABI only ever grows, check game1_api_version().
+*/
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+/* GAME1_BUILD is only defined while building the library itself */
+#if defined(GAME1_BUILD)
+#define GAME1_API __declspec(dllexport)
+#else
+#define GAME1_API __declspec(dllimport)
+#endif
+#else
+#define GAME1_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GAME1_API_VERSION 1
+
+#define GAME1_OK 0
+#define GAME1_ERROR_INVALID_ARGUMENT -1
+#define GAME1_ERROR_IO -2
+#define GAME1_ERROR_OUT_OF_MEMORY -3
+
+/* actions, same values as the game's Rotation */
+#define GAME1_ROLL_DOWN 0
+#define GAME1_ROLL_UP 1
+#define GAME1_ROLL_LEFT 2
+#define GAME1_ROLL_RIGHT 3
+
+typedef struct game1_level game1_level;
+typedef struct game1_env game1_env;
+
+/* every pointer may be NULL, that observation then stays inside the library */
+typedef struct game1_observations {
+    int16_t* x; /* num_instances entries each */
+    int16_t* z;
+    uint8_t* orientation; /* 0..23 */
+    int32_t* dark; /* dark tiles left */
+    uint8_t* moved; /* the last step moved the cube */
+    uint8_t* done; /* the level is complete */
+    uint64_t* light; /* game1_env_plane_words() words per instance, bit set = light tile */
+} game1_observations;
+
+GAME1_API int game1_api_version(void);
+GAME1_API const char* game1_last_error(void);
+
+GAME1_API game1_level* game1_level_load(const char* path);
+/* same format as the level files, from memory */
+GAME1_API game1_level* game1_level_parse(const char* text);
+GAME1_API void game1_level_free(game1_level* level);
+GAME1_API int game1_level_side_length(const game1_level* level);
+
+/* num_threads counts the calling thread, 1 steps everything on the caller */
+GAME1_API game1_env* game1_env_create(const game1_level* level, int num_instances, int num_threads);
+GAME1_API void game1_env_free(game1_env* env);
+GAME1_API int game1_env_num_instances(const game1_env* env);
+/* the light planes cover the level plus a 1 tile border, row major with side_length + 2 bits per row */
+GAME1_API int game1_env_plane_words(const game1_env* env);
+/* the current state is moved into the arrays, they have to outlive the env or the next bind */
+GAME1_API int game1_env_bind(game1_env* env, const game1_observations* observations);
+GAME1_API int game1_env_reset(game1_env* env);
+/* resets the instances whose mask entry is not 0 */
+GAME1_API int game1_env_reset_where(game1_env* env, const uint8_t* mask);
+/* one GAME1_ROLL_* per instance */
+GAME1_API int game1_env_step(game1_env* env, const uint8_t* actions);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GAME1_H */
@@ -0,0 +1,185 @@
+#include "batchEnv.h"
+#include <algorithm>
+#include "rules.h"
+#include "tileRules.h"
+
+namespace core {
+
+    // below this a thread spends more time waking up than stepping
+    static constexpr int minInstancesPerThread = 1024;
+
+    // a change is stored as the instance's light bit
+    static_assert(onlyDarkLightChange());
+
+    // whether a toggleable tile ends up lit under each orientation
+    static constexpr std::array<bool, numOrientations> litTable = [] {
+        std::array<bool, numOrientations> lit = {};
+        for (int o = 0; o < numOrientations; o++)
+            lit[o] = onEnter(TileType::DARK_TILE, downFace((uint8_t)o)) == TileType::LIGHT_TILE;
+        return lit;
+    }();
+
+    BatchEnv::BatchEnv(const LevelState& level, int numInstances, int numThreads) :
+        m_Start(level),
+        m_HasTargets(level.tiles.Count(targetTiles()) > 0),
+        m_NumToggle(level.tiles.Count(tileBit(TileType::DARK_TILE) | tileBit(TileType::LIGHT_TILE))),
+        m_StartDark(level.tiles.Count(TileType::DARK_TILE)),
+        m_Layout(level.tiles.GetSideLength() + 2),
+        m_PaddedOffset(level.tiles.GetPaddedOffset()),
+        m_Words((m_Layout.GetNumCells() + 63) / 64),
+        m_NumInstances(numInstances),
+        m_Buffers{},
+        m_X(numInstances),
+        m_Z(numInstances),
+        m_Orientation(numInstances),
+        m_Dark(numInstances),
+        m_Moved(numInstances),
+        m_Done(numInstances),
+        m_Light((size_t)numInstances * m_Words),
+        m_Pool(numThreads)
+    {
+        // the level is copied into dense planes once, every instance steps over the whole of them
+        m_Blocked.assign((size_t)numRotations * m_Words, 0);
+        m_Toggle.assign(m_Words, 0);
+        m_Target.assign(m_Words, 0);
+        m_StartLight.assign(m_Words, 0);
+        const int paddedSide = level.tiles.GetSideLength() + 2;
+        for (int pz = 0; pz < paddedSide; pz++) {
+            for (int px = 0; px < paddedSide; px++) {
+                const TileType type = level.tiles.TypeAt(level.tiles.PaddedIndex(px - m_PaddedOffset, pz - m_PaddedOffset));
+                const bool wall = level.voxels.Blocks(px - m_PaddedOffset, pz - m_PaddedOffset);
+                const int ix = m_Layout.Index(px, pz);
+                const uint64_t bit = uint64_t(1) << (ix & 63);
+                for (int r = 0; r < numRotations; r++) {
+                    if (wall || !canEnter(type, static_cast<Rotation>(r)))
+                        m_Blocked[(size_t)r * m_Words + (ix >> 6)] |= bit;
+                }
+                if (type == TileType::DARK_TILE || type == TileType::LIGHT_TILE)
+                    m_Toggle[ix >> 6] |= bit;
+                if (type == TileType::LIGHT_TILE)
+                    m_StartLight[ix >> 6] |= bit;
+                if (tileInfo[(int)type].target)
+                    m_Target[ix >> 6] |= bit;
+            }
+        }
+        m_Buffers = { m_X.data(), m_Z.data(), m_Orientation.data(), m_Dark.data(),
+            m_Moved.data(), m_Done.data(), m_Light.data() };
+        Reset();
+    }
+
+    void BatchEnv::Reset() {
+        m_Pool.ParallelFor(m_NumInstances, minInstancesPerThread, [this](int begin, int end) {
+            for (int i = begin; i < end; i++)
+                Reset(i);
+        });
+    }
+
+    void BatchEnv::Reset(int instance) {
+        m_Buffers.x[instance] = m_Start.player.x;
+        m_Buffers.z[instance] = m_Start.player.z;
+        m_Buffers.orientation[instance] = m_Start.player.orientation;
+        m_Buffers.dark[instance] = m_StartDark;
+        m_Buffers.moved[instance] = 0;
+        m_Buffers.done[instance] = 0;
+        std::copy(m_StartLight.begin(), m_StartLight.end(), m_Buffers.light + (size_t)instance * m_Words);
+    }
+
+    template<typename T>
+    static void rebind(T*& current, T* target, size_t count) {
+        if (target == nullptr || target == current)
+            return;
+        std::copy(current, current + count, target);
+        current = target;
+    }
+
+    void BatchEnv::Bind(const BatchBuffers& buffers) {
+        const size_t n = m_NumInstances;
+        rebind(m_Buffers.x, buffers.x, n);
+        rebind(m_Buffers.z, buffers.z, n);
+        rebind(m_Buffers.orientation, buffers.orientation, n);
+        rebind(m_Buffers.dark, buffers.dark, n);
+        rebind(m_Buffers.moved, buffers.moved, n);
+        rebind(m_Buffers.done, buffers.done, n);
+        rebind(m_Buffers.light, buffers.light, n * m_Words);
+    }
+
+    void BatchEnv::Step(const uint8_t* actions) {
+        m_Pool.ParallelFor(m_NumInstances, minInstancesPerThread, [this, actions](int begin, int end) {
+            StepRange(actions, begin, end);
+        });
+    }
+
+    LevelState BatchEnv::GetState(int instance) const {
+        LevelState state = m_Start;
+        const uint64_t* light = m_Buffers.light + (size_t)instance * m_Words;
+        const int side = m_Start.tiles.GetSideLength();
+        m_Start.tiles.ForEach(TileType::DARK_TILE, [&](int tileIx) {
+            int bit = m_Layout.Index(tileIx % side + 1, tileIx / side + 1);
+            if ((light[bit >> 6] >> (bit & 63)) & 1)
+                state.tiles.Set(tileIx, TileType::LIGHT_TILE);
+        });
+        m_Start.tiles.ForEach(TileType::LIGHT_TILE, [&](int tileIx) {
+            int bit = m_Layout.Index(tileIx % side + 1, tileIx / side + 1);
+            if (!((light[bit >> 6] >> (bit & 63)) & 1))
+                state.tiles.Set(tileIx, TileType::DARK_TILE);
+        });
+        state.player = { m_Buffers.x[instance], m_Buffers.z[instance], m_Buffers.orientation[instance] };
+        return state;
+    }
+
+    void BatchEnv::StepRange(const uint8_t* actions, int begin, int end) {
+        // everything the loop reads is a local, so the compiler doesn't have to assume aliasing
+        const uint64_t* __restrict blocked = m_Blocked.data();
+        const uint64_t* __restrict toggle = m_Toggle.data();
+        const uint64_t* __restrict target = m_Target.data();
+        int16_t* __restrict xs = m_Buffers.x;
+        int16_t* __restrict zs = m_Buffers.z;
+        uint8_t* __restrict orientations = m_Buffers.orientation;
+        int32_t* __restrict darks = m_Buffers.dark;
+        uint8_t* __restrict moved = m_Buffers.moved;
+        uint8_t* __restrict done = m_Buffers.done;
+        uint64_t* __restrict lights = m_Buffers.light;
+        const RowMajorLayout layout = m_Layout;
+        const int offset = m_PaddedOffset;
+        const int words = m_Words;
+        const int numToggle = m_NumToggle;
+        const bool hasTargets = m_HasTargets;
+
+        for (int i = begin; i < end; i++) {
+            const int r = actions[i] & 3;
+            const int x = xs[i];
+            const int z = zs[i];
+            const int o = orientations[i];
+
+            const int tx = x + rollDx[r];
+            const int tz = z + rollDz[r];
+            const int to = layout.Index(tx + offset, tz + offset);
+            const int open = (int)(~(blocked[r * words + (to >> 6)] >> (to & 63)) & 1);
+
+            // a blocked roll keeps the old pose, the same way core::step() leaves the state alone
+            const int next = nextOrientation((uint8_t)o, static_cast<Rotation>(r));
+            const int nx = open ? tx : x;
+            const int nz = open ? tz : z;
+            const int pos = layout.Index(nx + offset, nz + offset);
+            xs[i] = (int16_t)nx;
+            zs[i] = (int16_t)nz;
+            orientations[i] = (uint8_t)(open ? next : o);
+
+            // landing on a toggleable tile: lit or not depends only on the face that ends up down
+            uint64_t* light = lights + (size_t)i * words + (to >> 6);
+            const uint64_t bit = uint64_t(1) << (to & 63);
+            const uint64_t apply = bit & toggle[to >> 6] & (uint64_t(0) - (uint64_t)open);
+            const uint64_t lit = uint64_t(0) - (uint64_t)litTable[next];
+            const uint64_t before = *light;
+            const uint64_t after = (before & ~apply) | (apply & lit);
+            *light = after;
+            const int dark = darks[i] + (int)((before & apply) != 0) - (int)((after & apply) != 0);
+            darks[i] = dark;
+
+            moved[i] = (uint8_t)open;
+            const int onTarget = (int)((target[pos >> 6] >> (pos & 63)) & 1);
+            done[i] = (uint8_t)(dark == 0 && (hasTargets ? onTarget : numToggle - dark > 0));
+        }
+    }
+
+}
@@ -0,0 +1,123 @@
+#ifndef BATCH_ENV_H
+#define BATCH_ENV_H
+
+#include <cstdint>
+#include <vector>
+#include "levelState.h"
+#include "threadPool.h"
+
+namespace core {
+    // where the per instance state lives, see BatchEnv::Bind()
+    struct BatchBuffers {
+        int16_t* x;
+        int16_t* z;
+        uint8_t* orientation;
+        int32_t* dark; // dark tiles left
+        uint8_t* moved; // outcome of the last Step(), 0 or 1
+        uint8_t* done;
+        uint64_t* light; // GetPlaneWords() words per instance, bit set = light tile
+    };
+
+    /*
+        N independent games on the same level, stepped together, for agents and tools.
+
+        Rolls never change which tiles can be entered or are targets, only whether a
+        toggleable tile is dark or light (tileRules.h asserts that). So the level layout is shared, and every instance only
+        owns its pose and one light bitplane (row major over the level and its border). The
+        state is kept as structure of arrays, one array per field indexed by instance,
+        which is also the layout the observation getters hand out.
+
+        Step() runs the same rules as core::step() in a branch free loop over the
+        instances, split across the thread pool.
+
+        The arrays are owned by the BatchEnv unless the caller hands in its own with
+        Bind(), then the state is stepped in place in the caller's memory and reading
+        the observations costs nothing.
+    */
+    class BatchEnv {
+    public:
+        BatchEnv(const LevelState& level, int numInstances, int numThreads = 1);
+
+        void Reset();
+        void Reset(int instance);
+        // one Rotation per instance
+        void Step(const uint8_t* actions);
+        // full state of one instance, for debugging and validation
+        LevelState GetState(int instance) const;
+        // moves the state into the given arrays (null ones stay where they are), which
+        // have to hold numInstances entries and outlive the BatchEnv or the next Bind()
+        void Bind(const BatchBuffers& buffers);
+
+        inline int GetNumInstances() const {
+            return m_NumInstances;
+        }
+
+        inline int GetNumThreads() const {
+            return m_Pool.GetNumThreads();
+        }
+
+        // observations, numInstances entries each
+        inline const int16_t* GetX() const {
+            return m_Buffers.x;
+        }
+
+        inline const int16_t* GetZ() const {
+            return m_Buffers.z;
+        }
+
+        inline const uint8_t* GetOrientation() const {
+            return m_Buffers.orientation;
+        }
+
+        inline const int32_t* GetDarkCount() const {
+            return m_Buffers.dark;
+        }
+
+        inline const uint8_t* GetMoved() const {
+            return m_Buffers.moved;
+        }
+
+        inline const uint8_t* GetDone() const {
+            return m_Buffers.done;
+        }
+
+        inline const uint64_t* GetLightPlanes() const {
+            return m_Buffers.light;
+        }
+
+        inline int GetPlaneWords() const {
+            return m_Words;
+        }
+
+    private:
+        void StepRange(const uint8_t* actions, int begin, int end);
+
+        // shared level layout
+        LevelState m_Start;
+        TilePlane m_Blocked; // numRotations planes, cells a roll in that direction can't land on, border included
+        TilePlane m_Toggle; // dark or light at the start
+        TilePlane m_Target;
+        TilePlane m_StartLight;
+        bool m_HasTargets;
+        int m_NumToggle;
+        int m_StartDark;
+        RowMajorLayout m_Layout; // of the planes, which are dense whatever the level storage
+        int m_PaddedOffset; // tile coordinate to padded coordinate
+        int m_Words;
+
+        // per instance, m_Buffers points either into these or at the caller's arrays
+        int m_NumInstances;
+        BatchBuffers m_Buffers;
+        std::vector<int16_t> m_X;
+        std::vector<int16_t> m_Z;
+        std::vector<uint8_t> m_Orientation;
+        std::vector<int32_t> m_Dark;
+        std::vector<uint8_t> m_Moved;
+        std::vector<uint8_t> m_Done;
+        std::vector<uint64_t> m_Light; // numInstances * m_Words
+
+        ThreadPool m_Pool;
+    };
+}
+
+#endif // BATCH_ENV_H
@@ -0,0 +1,98 @@
+#include "solver.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+namespace core {
+
+    namespace {
+        // one end of the search, its states numbered in BFS order like solveBfs()
+        struct SearchSide {
+            StateSet states;
+            std::vector<uint32_t> link; // the state it was found from, the state itself for the ones it started with
+            std::vector<Rotation> move; // the roll between the state and its link
+            std::vector<int64_t> layerStarts; // number of the first state of every layer, the last one is the frontier's
+
+            int64_t GetFrontierSize() const {
+                return states.GetSize() - layerStarts.back();
+            }
+        };
+    }
+
+    SolveResult solveBidirectional(const StateSpace& space, const SolveOptions& options) {
+        const auto start = std::chrono::steady_clock::now();
+        const int numWords = space.GetNumWords();
+        SolveResult result = { SolveStatus::UNSOLVABLE, {}, 0, 0, 0, 0.0 };
+        const int64_t expectedStates = std::min(options.expectedStates, options.maxStates) / 2;
+
+        SearchSide forward = { StateSet(numWords, expectedStates), { 0 }, { Rotation::DOWN }, { 0 } };
+        forward.states.Insert(space.GetStart());
+        SearchSide backward = { StateSet(numWords, expectedStates), {}, {}, { 0 } };
+        const std::vector<uint64_t> goals = space.GetGoalStates();
+        for (size_t i = 0; i < goals.size(); i += numWords) {
+            auto [ix, inserted] = backward.states.Insert(goals.data() + i);
+            if (inserted) {
+                backward.link.push_back((uint32_t)ix);
+                backward.move.push_back(Rotation::DOWN);
+            }
+        }
+
+        // where the two halves meet, as a state number on either side
+        int64_t meetForward = space.IsGoal(space.GetStart()) ? 0 : -1;
+        int64_t meetBackward = -1;
+        std::vector<uint64_t> current(numWords);
+        std::vector<uint64_t> next(2 * numRotations * numWords);
+        std::array<Rotation, 2 * numRotations> moves;
+        while (meetForward == -1 && result.status != SolveStatus::GAVE_UP &&
+                forward.GetFrontierSize() > 0 && backward.GetFrontierSize() > 0) {
+            const bool isForward = forward.GetFrontierSize() <= backward.GetFrontierSize();
+            SearchSide& side = isForward ? forward : backward;
+            const SearchSide& other = isForward ? backward : forward;
+            const int64_t layerEnd = side.states.GetSize();
+            for (int64_t ix = side.layerStarts.back(); ix < layerEnd && meetForward == -1; ix++) {
+                // copied, inserting may move the states
+                std::copy_n(side.states.Get(ix), numWords, current.data());
+                const int count = isForward ? space.Expand(current.data(), next.data(), moves.data()) :
+                    space.ExpandBackward(current.data(), next.data(), moves.data());
+                result.expanded++;
+                for (int i = 0; i < count; i++) {
+                    const uint64_t* state = next.data() + i * numWords;
+                    if (forward.states.GetSize() + backward.states.GetSize() >= options.maxStates &&
+                            side.states.Find(state) == -1) {
+                        result.status = SolveStatus::GAVE_UP;
+                        break;
+                    }
+                    auto [found, inserted] = side.states.Insert(state);
+                    if (!inserted)
+                        continue;
+                    side.link.push_back((uint32_t)ix);
+                    side.move.push_back(moves[i]);
+                    // both sides have every state up to their depth, so the first join is a shortest one
+                    const int64_t otherIx = other.states.Find(state);
+                    if (otherIx != -1) {
+                        meetForward = isForward ? found : otherIx;
+                        meetBackward = isForward ? otherIx : found;
+                        break;
+                    }
+                }
+                if (result.status == SolveStatus::GAVE_UP)
+                    break;
+            }
+            side.layerStarts.push_back(layerEnd);
+        }
+
+        if (meetForward != -1) {
+            result.status = SolveStatus::SOLVED;
+            for (int64_t ix = meetForward; ix != 0; ix = forward.link[ix])
+                result.moves.push_back(forward.move[ix]);
+            std::reverse(result.moves.begin(), result.moves.end());
+            for (int64_t ix = meetBackward; ix != -1 && backward.link[ix] != ix; ix = backward.link[ix])
+                result.moves.push_back(backward.move[ix]);
+        }
+        result.depth = (int)(forward.layerStarts.size() + backward.layerStarts.size()) - 2;
+        result.visited = forward.states.GetSize() + backward.states.GetSize();
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+}
@@ -0,0 +1,118 @@
+#include "chunkFile.h"
+#include <cstring>
+#include <fstream>
+#include "rules.h"
+
+static constexpr char chunkMagic[4] = { 'C', 'H', 'N', 'K' };
+static constexpr uint32_t chunkVersion = 1;
+
+template<typename T>
+static void write(std::ostream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+static bool read(std::istream& in, T& value) {
+    return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+static uint64_t headerSize() {
+    return sizeof(chunkMagic) + sizeof(uint32_t) + 2 * sizeof(int32_t) + 2 * sizeof(int16_t) +
+        sizeof(uint8_t) + numTileTypes * sizeof(int32_t);
+}
+
+namespace core {
+
+    bool saveChunkFile(const std::string& path, const LevelState& level) {
+        std::ofstream out(path, std::ios::binary);
+        if (!out)
+            return false;
+
+        const TileGrid& tiles = level.tiles;
+        out.write(chunkMagic, sizeof(chunkMagic));
+        write(out, chunkVersion);
+        write(out, (int32_t)tiles.GetSideLength());
+        write(out, (int32_t)TileChunk::side);
+        write(out, level.player.x);
+        write(out, level.player.z);
+        write(out, level.player.orientation);
+        for (int t = 0; t < numTileTypes; t++)
+            write(out, (int32_t)tiles.Count(static_cast<TileType>(t)));
+
+        // chunks without a tile are left out, they read as empty
+        uint64_t offset = headerSize() + tiles.GetNumChunks() * sizeof(uint64_t);
+        for (int chunkIx = 0; chunkIx < tiles.GetNumChunks(); chunkIx++) {
+            const TileChunk* chunk = tiles.GetChunk(chunkIx);
+            if (chunk == nullptr || chunk->numOccupied == 0) {
+                write(out, (uint64_t)0);
+            } else {
+                write(out, offset);
+                offset += TileChunk::numCells;
+            }
+        }
+
+        std::array<uint8_t, TileChunk::numCells> cells;
+        for (int chunkIx = 0; chunkIx < tiles.GetNumChunks(); chunkIx++) {
+            const TileChunk* chunk = tiles.GetChunk(chunkIx);
+            if (chunk == nullptr || chunk->numOccupied == 0)
+                continue;
+            TileGrid::PackChunk(*chunk, cells.data());
+            out.write(reinterpret_cast<const char*>(cells.data()), cells.size());
+        }
+
+        return (bool)out;
+    }
+
+    bool readChunkFileIndex(std::istream& in, ChunkFileIndex& index, std::string& error) {
+        char magic[4];
+        uint32_t version;
+        int32_t sideLength, chunkSide;
+        bool ok = in.read(magic, sizeof(magic)) && read(in, version) && read(in, sideLength) &&
+            read(in, chunkSide) && read(in, index.player.x) && read(in, index.player.z) &&
+            read(in, index.player.orientation);
+        for (int t = 0; ok && t < numTileTypes; t++) {
+            int32_t count;
+            ok = read(in, count);
+            index.counts[t] = count;
+        }
+        if (!ok || std::memcmp(magic, chunkMagic, sizeof(magic)) != 0) {
+            error = "not a chunk level file";
+            return false;
+        }
+        if (version != chunkVersion || chunkSide != TileChunk::side) {
+            error = "unsupported chunk file version";
+            return false;
+        }
+        if (sideLength <= 0 || sideLength > maxLevelSide) {
+            error = "bad side length";
+            return false;
+        }
+        index.sideLength = sideLength;
+        const int offset = sideLength / 2;
+        if (index.player.x < -offset || index.player.z < -offset ||
+                index.player.x >= sideLength - offset || index.player.z >= sideLength - offset) {
+            error = "player outside the grid";
+            return false;
+        }
+
+        const int chunksPerRow = (sideLength + 2 + TileChunk::side - 1) / TileChunk::side;
+        index.offsets.resize((size_t)chunksPerRow * chunksPerRow);
+        if (!in.read(reinterpret_cast<char*>(index.offsets.data()), index.offsets.size() * sizeof(uint64_t))) {
+            error = "truncated chunk index";
+            return false;
+        }
+
+        // every chunk has to be inside the file, checked once here so reads can't come up short
+        const uint64_t dataStart = (uint64_t)in.tellg();
+        in.seekg(0, std::ios::end);
+        const uint64_t fileSize = (uint64_t)in.tellg();
+        in.seekg((std::streamoff)dataStart);
+        for (uint64_t chunkOffset : index.offsets) {
+            if (chunkOffset != 0 && (chunkOffset < dataStart || chunkOffset + TileChunk::numCells > fileSize)) {
+                error = "chunk outside the file";
+                return false;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef CHUNK_FILE_H
+#define CHUNK_FILE_H
+
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+#include "levelState.h"
+
+namespace core {
+    /*
+        Binary level format for levels too big to be read at once, see ChunkStreamer.
+        Everything little endian:
+
+        header  "CHNK", version, side length, chunk side, player pose,
+                count of every tile type
+        index   file offset of every chunk of the padded grid (row major over the
+                chunks), 0 for chunks without a tile
+        chunks  TileChunk::numCells bytes each, one TileType per cell, row major
+
+        Cells are stored row major whatever the TileLayout of the build, so files work
+        with both. Only the tiles are in it, levels with voxels (walls, stacks) are saved
+        as text levels (levelFile.h).
+    */
+    struct ChunkFileIndex {
+        int sideLength;
+        CubePose player;
+        std::array<int, numTileTypes> counts;
+        std::vector<uint64_t> offsets; // one per chunk
+    };
+
+    // the level has to be whole, chunks that are unloaded would be saved as empty. Voxels are dropped
+    bool saveChunkFile(const std::string& path, const LevelState& level);
+    // reads the header and the index, leaves the stream at the end of the index
+    bool readChunkFileIndex(std::istream& in, ChunkFileIndex& index, std::string& error);
+}
+
+#endif // CHUNK_FILE_H
@@ -0,0 +1,229 @@
+#include "chunkMesher.h"
+#include <algorithm>
+#include "rules.h"
+#include "tileRules.h"
+
+static constexpr int chunkSide = VoxelChunk::side;
+
+// distance between two cells of a VoxelChunk along x, y (layers) and z
+static constexpr int cellStride[3] = { 1, VoxelChunk::layerCells, chunkSide };
+
+// the two axes a face spans, by the axis it faces along and its sign (0 for +, 1 for -),
+// picked so that u x v points out of the face and the corners come out counter clockwise
+static constexpr int faceAxes[3][2][2] = {
+    { { 1, 2 }, { 2, 1 } },
+    { { 2, 0 }, { 0, 2 } },
+    { { 0, 1 }, { 1, 0 } },
+};
+
+// a full cube, the only kind of voxel that hides the faces next to it
+static bool isSolid(uint8_t type) {
+    return type != (uint8_t)VoxelType::EMPTY && !core::isRamp(static_cast<VoxelType>(type));
+}
+
+static core::MeshShade faceShade(int axis, int sign) {
+    if (axis == 1)
+        return sign > 0 ? core::MeshShade::TOP : core::MeshShade::BOTTOM;
+    return axis == 0 ? core::MeshShade::SIDE_X : core::MeshShade::SIDE_Z;
+}
+
+// rectangles of equal non zero values in a nu by nv mask (row v starts at mask[v * nu]),
+// the mask is all zero afterwards. Without greedy every cell is its own rectangle
+template <typename F>
+static void mergeRectangles(uint8_t* mask, int nu, int nv, bool greedy, F&& emit) {
+    for (int v = 0; v < nv; v++) {
+        for (int u = 0; u < nu;) {
+            const uint8_t value = mask[v * nu + u];
+            if (value == 0) {
+                u++;
+                continue;
+            }
+            int w = 1;
+            int h = 1;
+            if (greedy) {
+                while (u + w < nu && mask[v * nu + u + w] == value)
+                    w++;
+                for (; v + h < nv; h++) {
+                    const uint8_t* row = mask + (v + h) * nu + u;
+                    if (std::any_of(row, row + w, [value](uint8_t m) { return m != value; }))
+                        break;
+                }
+            }
+            for (int j = 0; j < h; j++)
+                std::fill_n(mask + (v + j) * nu + u, w, 0);
+            emit(u, v, w, h, value);
+            u += w;
+        }
+    }
+}
+
+// axis aligned quad from a world corner, w cells along uAxis and h along vAxis
+static core::MeshQuad makeQuad(const int origin[3], int uAxis, int w, int vAxis, int h, uint8_t type, bool voxel,
+        core::MeshShade shade) {
+    core::MeshQuad quad = { {}, (uint16_t)w, (uint16_t)h, type, voxel, shade };
+    for (int c = 0; c < 4; c++) {
+        for (int a = 0; a < 3; a++)
+            quad.corners[c][a] = (int16_t)origin[a];
+    }
+    quad.corners[1][uAxis] += w;
+    quad.corners[2][uAxis] += w;
+    quad.corners[2][vAxis] += h;
+    quad.corners[3][vAxis] += h;
+    return quad;
+}
+
+namespace core {
+
+    // a ramp is drawn as its slope, the two triangles on its sides (as quads with the last
+    // corner twice), the high end and the bottom. Corners are given for a ramp rising
+    // towards +z as (side, up, forward) in 0..1 and turned to the ramp's direction
+    static void meshRamp(const VoxelGrid& voxels, int x, int layer, int z, VoxelType type, std::vector<MeshQuad>& quads) {
+        using Corners = std::array<std::array<int, 3>, 4>;
+        static constexpr Corners slope = {{ { 0, 0, 0 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 0, 0 } }};
+        static constexpr Corners back = {{ { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 } }};
+        static constexpr Corners left = {{ { 0, 0, 0 }, { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 1 } }};
+        static constexpr Corners right = {{ { 1, 0, 0 }, { 1, 1, 1 }, { 1, 0, 1 }, { 1, 0, 1 } }};
+        static constexpr Corners bottom = {{ { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 } }};
+
+        const Rotation rotation = rampRotation(type);
+        const int fx = rollDx[(int)rotation];
+        const int fz = rollDz[(int)rotation];
+        // turning about y keeps (side, up, forward) right handed like (x, y, z)
+        const int sx = fz;
+        const int sz = -fx;
+        const MeshShade forwardShade = fx != 0 ? MeshShade::SIDE_X : MeshShade::SIDE_Z;
+        const MeshShade sideShade = sx != 0 ? MeshShade::SIDE_X : MeshShade::SIDE_Z;
+
+        auto add = [&](const Corners& corners, MeshShade shade) {
+            MeshQuad quad = { {}, 1, 1, (uint8_t)type, true, shade };
+            for (int c = 0; c < 4; c++) {
+                const int a = 2 * corners[c][0] - 1;
+                const int b = 2 * corners[c][2] - 1;
+                quad.corners[c] = {
+                    (int16_t)(x + (1 + a * sx + b * fx) / 2),
+                    (int16_t)(layer + corners[c][1]),
+                    (int16_t)(z + (1 + a * sz + b * fz) / 2)
+                };
+            }
+            quads.push_back(quad);
+        };
+
+        add(slope, MeshShade::SLOPE);
+        add(left, sideShade);
+        add(right, sideShade);
+        if (!isSolid((uint8_t)voxels.Get(x + fx, layer, z + fz)))
+            add(back, forwardShade);
+        if (layer > 0 && !isSolid((uint8_t)voxels.Get(x, layer - 1, z)))
+            add(bottom, MeshShade::BOTTOM);
+    }
+
+    void meshChunk(const TileGrid& tiles, const VoxelGrid& voxels, int chunkIx, bool greedy, std::vector<MeshQuad>& quads) {
+        const int chunksPerRow = tiles.GetChunksPerRow();
+        const int side = tiles.GetSideLength();
+        const int offset = tiles.GetPaddedOffset();
+        // padded coords of the chunk's first cell
+        const int baseX = chunkIx % chunksPerRow * chunkSide;
+        const int baseZ = chunkIx / chunksPerRow * chunkSide;
+        std::array<uint8_t, chunkSide * chunkSide> mask = {};
+
+        // tiles, all facing up at y = 0. The mask is indexed [x][z] so u x v points up
+        tiles.ForEachInChunk(chunkIx, [&](int tileIx, TileType type) {
+            const int x = tileIx % side - offset + 1;
+            const int z = tileIx / side - offset + 1;
+            if (!voxels.Blocks(x, z))
+                mask[(x + offset - baseX) * chunkSide + z + offset - baseZ] = (uint8_t)type;
+        });
+        mergeRectangles(mask.data(), chunkSide, chunkSide, greedy, [&](int u, int v, int w, int h, uint8_t type) {
+            const int origin[3] = { baseX + v - offset, 0, baseZ + u - offset };
+            quads.push_back(makeQuad(origin, 2, w, 0, h, type, false, MeshShade::TOP));
+        });
+
+        const VoxelChunk* chunk = voxels.GetChunk(chunkIx);
+        if (chunk == nullptr || chunk->numSolid == 0)
+            return;
+
+        // chunk local coords, the neighbours can be in the next chunk
+        auto at = [&](int lx, int layer, int lz) -> uint8_t {
+            if (lx >= 0 && lz >= 0 && lx < chunkSide && lz < chunkSide) {
+                if (layer < 0 || layer >= VoxelGrid::numLayers)
+                    return (uint8_t)VoxelType::EMPTY;
+                return chunk->cells[layer * VoxelChunk::layerCells + lz * chunkSide + lx];
+            }
+            return (uint8_t)voxels.Get(baseX + lx - offset, layer, baseZ + lz - offset);
+        };
+
+        // layers above the highest voxel of the chunk are left out, most chunks are low
+        int numLayers = VoxelGrid::numLayers;
+        while (numLayers > 0) {
+            const uint8_t* layer = chunk->cells.data() + (numLayers - 1) * VoxelChunk::layerCells;
+            if (std::any_of(layer, layer + VoxelChunk::layerCells, [](uint8_t c) { return c != 0; }))
+                break;
+            numLayers--;
+        }
+        const int dims[3] = { chunkSide, numLayers, chunkSide };
+
+        // the faces of solid voxels, one slice of the chunk at a time for each of the 6 directions.
+        // Cells outside the grid are always empty, Set() ignores them
+        for (int axis = 0; axis < 3; axis++) {
+            for (int s = 0; s < 2; s++) {
+                const int sign = s == 0 ? 1 : -1;
+                const int uAxis = faceAxes[axis][s][0];
+                const int vAxis = faceAxes[axis][s][1];
+                const int nu = dims[uAxis];
+                const int nv = dims[vAxis];
+                for (int slice = 0; slice < dims[axis]; slice++) {
+                    // nothing is ever seen from under the floor
+                    if (axis == 1 && sign < 0 && slice == 0)
+                        continue;
+                    // neighbours in the next chunk over (or above the top layer) only on the last slice
+                    const int next = slice + sign;
+                    const bool inside = next >= 0 && next < dims[axis];
+                    bool any = false;
+                    for (int v = 0; v < nv; v++) {
+                        for (int u = 0; u < nu; u++) {
+                            const int cell = slice * cellStride[axis] + u * cellStride[uAxis] + v * cellStride[vAxis];
+                            const uint8_t type = chunk->cells[cell];
+                            if (!isSolid(type))
+                                continue;
+                            if (inside) {
+                                if (isSolid(chunk->cells[cell + sign * cellStride[axis]]))
+                                    continue;
+                            } else {
+                                int c[3];
+                                c[axis] = next;
+                                c[uAxis] = u;
+                                c[vAxis] = v;
+                                if (isSolid(at(c[0], c[1], c[2])))
+                                    continue;
+                            }
+                            mask[v * nu + u] = type;
+                            any = true;
+                        }
+                    }
+                    if (!any)
+                        continue;
+                    mergeRectangles(mask.data(), nu, nv, greedy, [&](int u, int v, int w, int h, uint8_t type) {
+                        int origin[3];
+                        origin[axis] = slice + (sign > 0);
+                        origin[uAxis] = u;
+                        origin[vAxis] = v;
+                        origin[0] += baseX - offset;
+                        origin[2] += baseZ - offset;
+                        quads.push_back(makeQuad(origin, uAxis, w, vAxis, h, type, true, faceShade(axis, sign)));
+                    });
+                }
+            }
+        }
+
+        for (int layer = 0; layer < numLayers; layer++) {
+            for (int lz = 0; lz < chunkSide; lz++) {
+                for (int lx = 0; lx < chunkSide; lx++) {
+                    const uint8_t type = chunk->cells[layer * VoxelChunk::layerCells + lz * chunkSide + lx];
+                    if (type != (uint8_t)VoxelType::EMPTY && !isSolid(type))
+                        meshRamp(voxels, baseX + lx - offset, layer, baseZ + lz - offset, static_cast<VoxelType>(type), quads);
+                }
+            }
+        }
+    }
+
+}
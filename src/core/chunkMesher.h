@@ -0,0 +1,41 @@
+#ifndef CHUNK_MESHER_H
+#define CHUNK_MESHER_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "levelState.h"
+
+namespace core {
+    // which way a quad faces, the renderer shades each differently
+    enum class MeshShade : uint8_t {
+        TOP,
+        SIDE_X,
+        SIDE_Z,
+        BOTTOM,
+        SLOPE
+    };
+
+    struct MeshQuad {
+        std::array<std::array<int16_t, 3>, 4> corners; // world coords, counter clockwise seen from the front
+        uint16_t width; // in tiles along corners 0 -> 1, the tile border repeats every tile
+        uint16_t height; // along corners 0 -> 3
+        uint8_t type; // TileType, or VoxelType for voxels
+        bool voxel;
+        MeshShade shade;
+    };
+
+    /*
+        Quads of one chunk of the level (the chunk index is the same in the TileGrid and
+        the VoxelGrid), appended to quads.
+
+        Only faces that can be seen are emitted: tiles under a voxel and voxel faces
+        against a block are left out. With greedy, faces in the same plane, facing the
+        same way and of the same type are merged into the largest rectangles a row by
+        row sweep finds (the classic greedy meshing), so a flat field of ground tiles or
+        a wall is a handful of quads instead of one per tile face. Ramps are not merged.
+    */
+    void meshChunk(const TileGrid& tiles, const VoxelGrid& voxels, int chunkIx, bool greedy, std::vector<MeshQuad>& quads);
+}
+
+#endif // CHUNK_MESHER_H
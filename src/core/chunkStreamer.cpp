@@ -0,0 +1,293 @@
+#include "chunkStreamer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "chunkFile.h"
+
+namespace core {
+
+    ChunkStreamer::ChunkStreamer() :
+        m_Config(),
+        m_Stats(),
+        m_Events(),
+        m_SwapPath(),
+        m_ChunksPerRow(0),
+        m_OnDisk(),
+        m_Loading(),
+        m_Source(),
+        m_Swap(),
+        m_SourceOffset(),
+        m_SwapOffset(),
+        m_SwapEnd(0),
+        m_Worker(),
+        m_Mutex(),
+        m_WorkReady(),
+        m_Idle(),
+        m_Requests(),
+        m_Done(),
+        m_Busy(0),
+        m_IoErrors(0),
+        m_Quit(false)
+    {
+    }
+
+    ChunkStreamer::~ChunkStreamer() {
+        Close();
+    }
+
+    bool ChunkStreamer::Open(const std::string& path, LevelState& level, std::string& error) {
+        Close();
+
+        m_Source.open(path, std::ios::binary);
+        if (!m_Source) {
+            error = "could not open " + path;
+            return false;
+        }
+        ChunkFileIndex index;
+        if (!readChunkFileIndex(m_Source, index, error)) {
+            m_Source.close();
+            return false;
+        }
+
+        m_SwapPath = path + ".swap";
+        m_Swap.open(m_SwapPath, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+        if (!m_Swap) {
+            error = "could not create " + m_SwapPath;
+            m_Source.close();
+            return false;
+        }
+
+        level.tiles = TileGrid(index.sideLength);
+        level.voxels = VoxelGrid(index.sideLength);
+        level.tiles.SetCounts(index.counts);
+        level.player = index.player;
+        m_ChunksPerRow = level.tiles.GetChunksPerRow();
+        m_SourceOffset = std::move(index.offsets);
+        m_SwapOffset.assign(m_SourceOffset.size(), -1);
+        m_SwapEnd = 0;
+        m_OnDisk.assign(m_SourceOffset.size(), 0);
+        m_Loading.assign(m_SourceOffset.size(), 0);
+        for (int chunkIx = 0; chunkIx < (int)m_SourceOffset.size(); chunkIx++) {
+            if (m_SourceOffset[chunkIx] != 0) {
+                m_OnDisk[chunkIx] = 1;
+                level.tiles.MarkUnloaded(chunkIx);
+            }
+        }
+
+        m_Stats = {};
+        m_Events = {};
+        m_Requests.clear();
+        m_Done.clear();
+        m_Busy = 0;
+        m_IoErrors = 0;
+        m_Quit = false;
+        m_Worker = std::thread(&ChunkStreamer::WorkerLoop, this);
+        return true;
+    }
+
+    void ChunkStreamer::Close() {
+        if (!IsOpen())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Quit = true;
+        }
+        m_WorkReady.notify_all();
+        m_Worker.join();
+
+        m_Source.close();
+        m_Swap.close();
+        std::remove(m_SwapPath.c_str());
+        m_Requests.clear();
+        m_Done.clear();
+        m_Busy = 0;
+    }
+
+    int ChunkStreamer::Distance(int chunkIx, int centerChunkX, int centerChunkZ) const {
+        return std::max(std::abs(chunkIx % m_ChunksPerRow - centerChunkX),
+                std::abs(chunkIx / m_ChunksPerRow - centerChunkZ));
+    }
+
+    void ChunkStreamer::Update(TileGrid& tiles, int centerX, int centerZ) {
+        if (!IsOpen())
+            return;
+
+        // the camera can be anywhere, ChunkAt() goes one tile past the grid
+        const int low = -tiles.GetPaddedOffset();
+        const int high = tiles.GetSideLength() - tiles.GetPaddedOffset() + 1;
+        const int center = tiles.ChunkAt(std::clamp(centerX, low, high), std::clamp(centerZ, low, high));
+        const int centerChunkX = center % m_ChunksPerRow;
+        const int centerChunkZ = center / m_ChunksPerRow;
+        const int keepRadius = m_Config.radius + m_Config.evictMargin;
+
+        // what the worker has read. Chunks the center moved away from in the meantime are
+        // dropped, they are still on disk as they were
+        std::vector<Request> done;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            done.swap(m_Done);
+            m_Stats.ioErrors = m_IoErrors;
+        }
+        const Clock::time_point now = Clock::now();
+        for (Request& request : done) {
+            m_Loading[request.chunkIx] = 0;
+            m_Stats.pending--;
+            if (!tiles.IsUnloaded(request.chunkIx) || Distance(request.chunkIx, centerChunkX, centerChunkZ) > keepRadius)
+                continue;
+            tiles.InsertChunk(request.chunkIx, request.chunk);
+            m_Stats.loads++;
+            m_Stats.loadLatency.Add(std::chrono::duration<double>(now - request.time).count());
+            m_Stats.readLatency.Add(std::chrono::duration<double>(request.readTime - request.time).count());
+            m_Events.changedChunks.push_back(request.chunkIx);
+        }
+
+        // evict. This goes over what the grid holds and not over some list of our own, so
+        // chunks the editor allocated or an undo checkpoint brought back go as well
+        std::vector<int> evict;
+        tiles.ForEachAllocatedChunk([&](const TileChunk& chunk) {
+            if (Distance(chunk.chunkIx, centerChunkX, centerChunkZ) > keepRadius)
+                evict.push_back(chunk.chunkIx);
+        });
+        std::vector<Request> stores;
+        for (int chunkIx : evict) {
+            TileChunk chunk = tiles.EvictChunk(chunkIx);
+            m_Stats.evictions++;
+            m_Events.changedChunks.push_back(chunkIx);
+            if (chunk.modified) {
+                m_OnDisk[chunkIx] = 1;
+                m_Events.modifiedEvicted = true;
+                m_Stats.writeBacks++;
+                stores.push_back({ chunkIx, true, chunk, now, now });
+            }
+        }
+
+        // load, nearest first
+        std::vector<std::pair<int, int>> wanted; // distance, chunk
+        const int radius = m_Config.radius;
+        for (int z = std::max(0, centerChunkZ - radius); z <= std::min(m_ChunksPerRow - 1, centerChunkZ + radius); z++) {
+            for (int x = std::max(0, centerChunkX - radius); x <= std::min(m_ChunksPerRow - 1, centerChunkX + radius); x++) {
+                const int chunkIx = z * m_ChunksPerRow + x;
+                if (m_OnDisk[chunkIx] && tiles.IsUnloaded(chunkIx) && !m_Loading[chunkIx])
+                    wanted.push_back({ Distance(chunkIx, centerChunkX, centerChunkZ), chunkIx });
+            }
+        }
+        std::sort(wanted.begin(), wanted.end());
+
+        if (!stores.empty() || !wanted.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                for (Request& request : stores)
+                    m_Requests.push_back(std::move(request));
+                for (auto [distance, chunkIx] : wanted) {
+                    Request request;
+                    request.chunkIx = chunkIx;
+                    request.store = false;
+                    request.time = now;
+                    m_Requests.push_back(std::move(request));
+                    m_Loading[chunkIx] = 1;
+                }
+                m_Busy += (int)(stores.size() + wanted.size());
+            }
+            m_Stats.pending += (int)wanted.size();
+            m_WorkReady.notify_one();
+        }
+
+        // the cube only ever rolls one tile, so these are what it could need next
+        static constexpr int dx[5] = { 0, 1, -1, 0, 0 };
+        static constexpr int dz[5] = { 0, 0, 0, 1, -1 };
+        for (int d = 0; d < 5; d++) {
+            if (!IsReady(tiles, centerX + dx[d], centerZ + dz[d])) {
+                m_Stats.stalls++;
+                break;
+            }
+        }
+
+        m_Stats.resident = tiles.GetNumAllocatedChunks();
+        m_Stats.maxResident = std::max(m_Stats.maxResident, m_Stats.resident);
+    }
+
+    void ChunkStreamer::Prefetch(TileGrid& tiles, int centerX, int centerZ) {
+        // nothing is waiting on these yet, so they are not stalls
+        const int64_t stalls = m_Stats.stalls;
+        Update(tiles, centerX, centerZ);
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Idle.wait(lock, [this] { return m_Busy == 0; });
+        }
+        Update(tiles, centerX, centerZ);
+        m_Stats.stalls = stalls;
+    }
+
+    bool ChunkStreamer::IsReady(const TileGrid& tiles, int tileX, int tileZ) const {
+        if (tiles.GetTileIndex(tileX, tileZ) == -1)
+            return true;
+        return !tiles.IsUnloaded(tiles.ChunkAt(tileX, tileZ));
+    }
+
+    StreamEvents ChunkStreamer::TakeEvents() {
+        StreamEvents events = std::move(m_Events);
+        m_Events = {};
+        return events;
+    }
+
+    bool ChunkStreamer::ReadChunk(int chunkIx, TileChunk& chunk) {
+        std::array<uint8_t, TileChunk::numCells> cells;
+        bool ok;
+        // a failed read leaves the stream failing, clearing it keeps that to the one chunk
+        if (m_SwapOffset[chunkIx] >= 0) {
+            m_Swap.clear();
+            m_Swap.seekg(m_SwapOffset[chunkIx]);
+            ok = (bool)m_Swap.read(reinterpret_cast<char*>(cells.data()), cells.size());
+        } else {
+            m_Source.clear();
+            m_Source.seekg((std::streamoff)m_SourceOffset[chunkIx]);
+            ok = (bool)m_Source.read(reinterpret_cast<char*>(cells.data()), cells.size());
+        }
+        // a chunk that can't be read comes in empty rather than never
+        if (!ok)
+            cells.fill((uint8_t)TileType::EMPTY_TILE);
+        TileGrid::UnpackChunk(cells.data(), chunk);
+        chunk.chunkIx = chunkIx;
+        return ok;
+    }
+
+    bool ChunkStreamer::WriteChunk(int chunkIx, const TileChunk& chunk) {
+        std::array<uint8_t, TileChunk::numCells> cells;
+        TileGrid::PackChunk(chunk, cells.data());
+        if (m_SwapOffset[chunkIx] < 0) {
+            m_SwapOffset[chunkIx] = m_SwapEnd;
+            m_SwapEnd += TileChunk::numCells;
+        }
+        m_Swap.clear();
+        m_Swap.seekp(m_SwapOffset[chunkIx]);
+        return (bool)m_Swap.write(reinterpret_cast<const char*>(cells.data()), cells.size());
+    }
+
+    void ChunkStreamer::WorkerLoop() {
+        while (true) {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_WorkReady.wait(lock, [this] { return m_Quit || !m_Requests.empty(); });
+                if (m_Quit)
+                    return;
+                request = std::move(m_Requests.front());
+                m_Requests.pop_front();
+            }
+
+            const bool ok = request.store ? WriteChunk(request.chunkIx, request.chunk) :
+                ReadChunk(request.chunkIx, request.chunk);
+            request.readTime = Clock::now();
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                if (!ok)
+                    m_IoErrors++;
+                if (!request.store)
+                    m_Done.push_back(std::move(request));
+                m_Busy--;
+            }
+            m_Idle.notify_all();
+        }
+    }
+}
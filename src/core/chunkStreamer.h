@@ -0,0 +1,143 @@
+#ifndef CHUNK_STREAMER_H
+#define CHUNK_STREAMER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "levelState.h"
+#include "moveQueue.h"
+
+namespace core {
+    struct StreamConfig {
+        int radius = 3; // chunks kept around the center, in chunks (Chebyshev distance)
+        int evictMargin = 1; // chunks are only evicted once they are this much further out
+    };
+
+    struct StreamStats {
+        LatencyStats loadLatency; // seconds from the request to the chunk being in the grid
+        LatencyStats readLatency; // seconds from the request to the worker having read it
+        int64_t loads;
+        int64_t evictions;
+        int64_t writeBacks; // evicted chunks that had changed, they go to the swap file
+        int64_t stalls; // updates where a tile next to the center was still on disk
+        int64_t ioErrors; // since Open(), a chunk that can't be read comes in empty
+        int pending; // loads requested and not in the grid yet
+        int resident; // chunks in memory
+        int maxResident;
+    };
+
+    struct StreamEvents {
+        std::vector<int> changedChunks; // loaded or evicted, the renderer redoes those
+        bool modifiedEvicted; // a changed chunk went to disk, undo can't reach past this
+    };
+
+    /*
+        Keeps the chunks of a chunk file (chunkFile.h) resident around a center, the
+        player or the editor camera, and nothing else.
+
+        Open() gives the level its size, pose and tile counts and marks every chunk with
+        tiles as unloaded (see TileGrid). Update() runs once per frame on the main
+        thread: it puts the chunks the worker thread has read into the grid, evicts the
+        ones past radius + evictMargin and asks for the missing ones inside radius,
+        nearest first. The worker only ever touches the files, the grid is only touched
+        by Update(), so there is no locking on the hot paths of the rules.
+
+        Chunks that changed since they were loaded (rolls, editor) are written to a
+        swap file next to the level when evicted and read back from there, the level
+        file itself is never written. Memory stays at (2 * (radius + evictMargin) + 1)^2
+        chunks at most, whatever the size of the level.
+    */
+    class ChunkStreamer {
+    public:
+        ChunkStreamer();
+        ~ChunkStreamer();
+
+        ChunkStreamer(const ChunkStreamer&) = delete;
+        ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+        bool Open(const std::string& path, LevelState& level, std::string& error);
+        // drops the swap file, whatever was only in there is gone
+        void Close();
+        // center in centered tile coords
+        void Update(TileGrid& tiles, int centerX, int centerZ);
+        // Update() and wait for every chunk inside the radius, for when the level is
+        // opened and nothing else can happen before they are in
+        void Prefetch(TileGrid& tiles, int centerX, int centerZ);
+        // whether the tile can be read and written right now
+        bool IsReady(const TileGrid& tiles, int tileX, int tileZ) const;
+        StreamEvents TakeEvents();
+
+        inline bool IsOpen() const {
+            return m_Worker.joinable();
+        }
+
+        inline const StreamConfig& GetConfig() const {
+            return m_Config;
+        }
+
+        inline void SetConfig(const StreamConfig& config) {
+            m_Config = config;
+        }
+
+        inline const StreamStats& GetStats() const {
+            return m_Stats;
+        }
+
+        inline void ResetStats() {
+            m_Stats.loadLatency = {};
+            m_Stats.readLatency = {};
+            m_Stats.loads = m_Stats.evictions = m_Stats.writeBacks = m_Stats.stalls = 0;
+            m_Stats.maxResident = m_Stats.resident;
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Request {
+            int chunkIx;
+            bool store; // write chunk to the swap file, otherwise read it
+            TileChunk chunk;
+            Clock::time_point time;
+            Clock::time_point readTime;
+        };
+
+        void WorkerLoop();
+        bool ReadChunk(int chunkIx, TileChunk& chunk);
+        bool WriteChunk(int chunkIx, const TileChunk& chunk);
+        // Chebyshev distance in chunks
+        int Distance(int chunkIx, int centerChunkX, int centerChunkZ) const;
+
+        StreamConfig m_Config;
+        StreamStats m_Stats;
+        StreamEvents m_Events;
+        std::string m_SwapPath;
+        int m_ChunksPerRow;
+        std::vector<uint8_t> m_OnDisk; // chunk has tiles in the level or the swap file
+        std::vector<uint8_t> m_Loading;
+
+        // worker side, only touched by the worker once it runs
+        std::ifstream m_Source;
+        std::fstream m_Swap;
+        std::vector<uint64_t> m_SourceOffset; // 0 for chunks without a tile
+        std::vector<int64_t> m_SwapOffset; // -1 until the chunk is written back once
+        int64_t m_SwapEnd;
+
+        std::thread m_Worker;
+        std::mutex m_Mutex;
+        std::condition_variable m_WorkReady;
+        std::condition_variable m_Idle;
+        std::deque<Request> m_Requests; // oldest first, so a read after a write sees it
+        std::vector<Request> m_Done; // loads, waiting for Update()
+        int m_Busy; // requests queued or being run
+        int64_t m_IoErrors;
+        bool m_Quit;
+    };
+}
+
+#endif // CHUNK_STREAMER_H
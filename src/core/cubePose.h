@@ -0,0 +1,167 @@
+#ifndef CUBE_POSE_H
+#define CUBE_POSE_H
+
+#include <array>
+#include <cstdint>
+#include "levelState.h"
+
+// The cube can only ever be in one of 24 orientations, so instead of shuffling a
+// std::array<Face, 6> around on every roll the orientation is an index into tables
+// that are built once at compile time by walking turn() from the identity.
+// Orientation 0 is the identity (U up, F front).
+
+namespace core {
+    static constexpr int numOrientations = 24;
+    static constexpr int numRotations = 4;
+
+    constexpr void turn(std::array<Face, 6>& state, Rotation rotation) {
+        switch (rotation) {
+            case Rotation::DOWN:
+                {
+                    Face temp = state[0];
+                    state[0] = state[3];
+                    state[3] = state[2];
+                    state[2] = state[1];
+                    state[1] = temp;
+                }
+                break;
+            case Rotation::UP:
+                {
+                    Face temp = state[0];
+                    state[0] = state[1];
+                    state[1] = state[2];
+                    state[2] = state[3];
+                    state[3] = temp;
+                }
+                break;
+            case Rotation::LEFT:
+                {
+                    Face temp = state[0];
+                    state[0] = state[5];
+                    state[5] = state[2];
+                    state[2] = state[4];
+                    state[4] = temp;
+                }
+                break;
+            case Rotation::RIGHT:
+                {
+                    Face temp = state[0];
+                    state[0] = state[4];
+                    state[4] = state[2];
+                    state[2] = state[5];
+                    state[5] = temp;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    struct OrientationTables {
+        std::array<std::array<Face, 6>, numOrientations> faces; // face sitting at each Orientation
+        std::array<std::array<uint8_t, numRotations>, numOrientations> next; // indexed by Rotation
+        std::array<std::array<uint8_t, numRotations>, numOrientations> prev; // inverse of next, for undo
+        std::array<Face, numOrientations> downFace;
+        // column major 4x4 rotations (no translation) mapping the cube mesh to the orientation
+        std::array<std::array<float, 16>, numOrientations> matrices;
+    };
+
+    constexpr OrientationTables buildOrientationTables() {
+        OrientationTables tables = {};
+        tables.faces[0] = { Face::U, Face::F, Face::D, Face::B, Face::L, Face::R };
+
+        // breadth first over the rolls, every new face layout gets the next free index
+        int count = 1;
+        for (int i = 0; i < count; i++) {
+            for (int r = 0; r < numRotations; r++) {
+                std::array<Face, 6> rolled = tables.faces[i];
+                turn(rolled, static_cast<Rotation>(r));
+
+                int j = 0;
+                while (j < count && tables.faces[j] != rolled)
+                    j++;
+                if (j == count)
+                    tables.faces[count++] = rolled;
+                tables.next[i][r] = static_cast<uint8_t>(j);
+            }
+        }
+
+        for (int i = 0; i < numOrientations; i++) {
+            for (int r = 0; r < numRotations; r++)
+                tables.prev[tables.next[i][r]][r] = static_cast<uint8_t>(i);
+        }
+
+        // Face and Orientation share the same order, so both map to the same unit normal
+        constexpr int normals[6][3] = {
+            {  0,  1,  0 }, // U / UP
+            {  0,  0,  1 }, // F / FRONT
+            {  0, -1,  0 }, // D / DOWN
+            {  0,  0, -1 }, // B / BACK
+            { -1,  0,  0 }, // L / LEFT
+            {  1,  0,  0 }, // R / RIGHT
+        };
+
+        for (int i = 0; i < numOrientations; i++) {
+            tables.downFace[i] = tables.faces[i][(int)Orientation::DOWN];
+
+            std::array<float, 16>& m = tables.matrices[i];
+            m[15] = 1.0f;
+            // the rotation takes the normal of each face to the normal of the slot it sits in,
+            // so the columns come straight from the faces pointing along +x, +y and +z
+            for (int slot = 0; slot < 6; slot++) {
+                const int* faceNormal = normals[(int)tables.faces[i][slot]];
+                for (int col = 0; col < 3; col++) {
+                    if (faceNormal[col] == 1) {
+                        for (int row = 0; row < 3; row++)
+                            m[col * 4 + row] = (float)normals[slot][row];
+                    }
+                }
+            }
+        }
+
+        return tables;
+    }
+
+    inline constexpr OrientationTables orientationTables = buildOrientationTables();
+
+    // every slot of the table has to be a distinct layout with all six faces in it
+    constexpr bool validOrientationTables() {
+        for (int i = 0; i < numOrientations; i++) {
+            int seen = 0;
+            for (Face face : orientationTables.faces[i])
+                seen |= 1 << (int)face;
+            if (seen != 0b111111)
+                return false;
+            for (int j = 0; j < i; j++) {
+                if (orientationTables.faces[i] == orientationTables.faces[j])
+                    return false;
+            }
+        }
+        return true;
+    }
+    static_assert(validOrientationTables(), "the orientation walk must reach 24 distinct layouts");
+
+    constexpr uint8_t nextOrientation(uint8_t orientation, Rotation rotation) {
+        return orientationTables.next[orientation][(int)rotation];
+    }
+
+    // orientation the cube had before rolling into this one
+    constexpr uint8_t prevOrientation(uint8_t orientation, Rotation rotation) {
+        return orientationTables.prev[orientation][(int)rotation];
+    }
+
+    constexpr Face downFace(uint8_t orientation) {
+        return orientationTables.downFace[orientation];
+    }
+
+    // -1 if the layout is not a real cube orientation (e.g. a corrupted level file)
+    constexpr int orientationFromFaces(const std::array<Face, 6>& faces) {
+        for (int i = 0; i < numOrientations; i++) {
+            if (orientationTables.faces[i] == faces)
+                return i;
+        }
+        return -1;
+    }
+}
+
+#endif // CUBE_POSE_H
@@ -0,0 +1,140 @@
+#include "cubeSwarm.h"
+#include <algorithm>
+#include <numeric>
+#include "rules.h"
+#include "tileRules.h"
+
+namespace core {
+
+    CubeSwarm::CubeSwarm(bool solid, bool togglesTiles) :
+        m_Solid(solid),
+        m_TogglesTiles(solid && togglesTiles)
+    {
+    }
+
+    void CubeSwarm::Clear(const LevelState& level) {
+        m_X.clear();
+        m_Z.clear();
+        m_Orientation.clear();
+        m_Moved.clear();
+        m_Rotation.clear();
+        m_ChangedTiles.clear();
+        const size_t words = (size_t)level.tiles.GetNumChunks() * (TileChunk::numCells / 64);
+        m_Occupied.assign(m_Solid ? words : 0, 0);
+        m_Waiting.assign(m_Solid ? words : 0, 0);
+    }
+
+    int CubeSwarm::Add(const LevelState& level, const CubePose& pose) {
+        const TileGrid& tiles = level.tiles;
+        if (tiles.GetTileIndex(pose.x, pose.z) == -1)
+            return -1;
+        const int paddedIx = tiles.PaddedIndex(pose.x, pose.z);
+        if (tiles.TypeAt(paddedIx) == TileType::EMPTY_TILE || level.voxels.Blocks(pose.x, pose.z))
+            return -1;
+        if (m_Solid) {
+            if (TestBit(m_Occupied, paddedIx) || (pose.x == level.player.x && pose.z == level.player.z))
+                return -1;
+            FlipBit(m_Occupied, paddedIx);
+        }
+        m_X.push_back(pose.x);
+        m_Z.push_back(pose.z);
+        m_Orientation.push_back(pose.orientation);
+        m_Moved.push_back(0);
+        m_Rotation.push_back(0);
+        return GetNumCubes() - 1;
+    }
+
+    bool CubeSwarm::IsOccupied(const LevelState& level, int tileX, int tileZ) const {
+        if (!m_Solid || level.tiles.GetTileIndex(tileX, tileZ) == -1)
+            return false;
+        return TestBit(m_Occupied, level.tiles.PaddedIndex(tileX, tileZ));
+    }
+
+    int CubeSwarm::Step(LevelState& level, const uint8_t* actions) {
+        m_Order.resize(m_X.size());
+        std::iota(m_Order.begin(), m_Order.end(), 0);
+        return Resolve(level, actions);
+    }
+
+    int CubeSwarm::StepAll(LevelState& level, Rotation rotation) {
+        m_Actions.assign(m_X.size(), (uint8_t)rotation);
+        // the cube furthest along the roll first, then no cube waits for one behind it
+        const int dx = rollDx[(int)rotation];
+        const int dz = rollDz[(int)rotation];
+        m_Order.resize(m_X.size());
+        std::iota(m_Order.begin(), m_Order.end(), 0);
+        std::sort(m_Order.begin(), m_Order.end(), [&](int a, int b) {
+            return m_X[a] * dx + m_Z[a] * dz > m_X[b] * dx + m_Z[b] * dz;
+        });
+        return Resolve(level, m_Actions.data());
+    }
+
+    int CubeSwarm::Resolve(LevelState& level, const uint8_t* actions) {
+        TileGrid& tiles = level.tiles;
+        m_ChangedTiles.clear();
+        const int playerIx = tiles.PaddedIndex(level.player.x, level.player.z);
+        if (m_Solid) {
+            for (int i : m_Order)
+                FlipBit(m_Waiting, tiles.PaddedIndex(m_X[i], m_Z[i]));
+        }
+
+        // 1 moved, 0 blocked, -1 has to wait for the cube on its target
+        auto tryMove = [&](int i) {
+            const Rotation rotation = static_cast<Rotation>(actions[i] & 3);
+            m_Rotation[i] = (uint8_t)rotation;
+            const int x = m_X[i] + rollDx[(int)rotation];
+            const int z = m_Z[i] + rollDz[(int)rotation];
+            const int target = tiles.PaddedIndex(x, z);
+            const TileType before = tiles.TypeAt(target);
+            if (!canEnter(before, rotation) || level.voxels.Blocks(x, z))
+                return 0;
+            if (m_Solid) {
+                if (target == playerIx)
+                    return 0;
+                if (TestBit(m_Occupied, target))
+                    return TestBit(m_Waiting, target) ? -1 : 0;
+                FlipBit(m_Occupied, tiles.PaddedIndex(m_X[i], m_Z[i]));
+                FlipBit(m_Occupied, target);
+            }
+            m_X[i] = (int16_t)x;
+            m_Z[i] = (int16_t)z;
+            m_Orientation[i] = nextOrientation(m_Orientation[i], rotation);
+            if (m_TogglesTiles) {
+                const TileType after = onEnter(before, downFace(m_Orientation[i]));
+                if (after != before) {
+                    tiles.Replace(target, before, after);
+                    m_ChangedTiles.push_back(tiles.GetTileIndex(x, z));
+                }
+            }
+            return 1;
+        };
+
+        // passes over the cubes that had to wait until one gets none of them moving,
+        // those are waiting on each other in a cycle and stay where they are
+        int numMoved = 0;
+        size_t numLeft = m_Order.size() + 1;
+        while (!m_Order.empty() && m_Order.size() < numLeft) {
+            numLeft = m_Order.size();
+            m_Deferred.clear();
+            for (int i : m_Order) {
+                const int from = m_Solid ? tiles.PaddedIndex(m_X[i], m_Z[i]) : 0;
+                const int outcome = tryMove(i);
+                if (outcome < 0) {
+                    m_Deferred.push_back(i);
+                    continue;
+                }
+                if (m_Solid)
+                    FlipBit(m_Waiting, from);
+                m_Moved[i] = (uint8_t)outcome;
+                numMoved += outcome;
+            }
+            m_Order.swap(m_Deferred);
+        }
+        for (int i : m_Order) {
+            FlipBit(m_Waiting, tiles.PaddedIndex(m_X[i], m_Z[i]));
+            m_Moved[i] = 0;
+        }
+        return numMoved;
+    }
+
+}
@@ -0,0 +1,118 @@
+#ifndef CUBE_SWARM_H
+#define CUBE_SWARM_H
+
+#include <cstdint>
+#include <vector>
+#include "levelState.h"
+
+namespace core {
+    /*
+        Cubes on the level besides the player, stepped together.
+
+        The poses are kept as structure of arrays like in BatchEnv, but unlike there all
+        cubes share one level: solid cubes can't roll onto each other or onto the player,
+        and they toggle the tiles they land on if asked to. Who stands where is one bit
+        per cell of the level, on the TileGrid's padded index, so a collision check is a
+        single load next to the one the rules already do for the tile.
+
+        Step() resolves the cubes in order. A cube whose target is taken by a cube that
+        hasn't been resolved yet waits for it, so a row of cubes rolling the same way
+        moves as a whole, while two cubes swapping places or heading for the same tile
+        don't get through. StepAll() goes from the front of the row to the back, so it
+        takes a single pass.
+
+        Ghost cubes (solid = false) only follow the level layout: they pass through each
+        other and the player and never change tiles, for showing replays next to the game.
+    */
+    class CubeSwarm {
+    public:
+        explicit CubeSwarm(bool solid = true, bool togglesTiles = true);
+
+        // removes all cubes and fits the occupancy bits to the level. Has to come before the
+        // first Add() and again whenever the level is replaced by one of another size
+        void Clear(const LevelState& level);
+        // index of the new cube, -1 if the pose is outside the level, off the tiles, or taken
+        int Add(const LevelState& level, const CubePose& pose);
+        // one Rotation per cube, returns how many cubes moved. Tiles changed by the cubes are in GetChangedTiles()
+        int Step(LevelState& level, const uint8_t* actions);
+        int StepAll(LevelState& level, Rotation rotation);
+
+        // taken by a solid cube, the player isn't counted
+        bool IsOccupied(const LevelState& level, int tileX, int tileZ) const;
+
+        inline CubePose GetPose(int cube) const {
+            return { m_X[cube], m_Z[cube], m_Orientation[cube] };
+        }
+
+        inline int GetNumCubes() const {
+            return (int)m_X.size();
+        }
+
+        inline bool IsSolid() const {
+            return m_Solid;
+        }
+
+        // ghosts never toggle tiles
+        inline void SetTogglesTiles(bool togglesTiles) {
+            m_TogglesTiles = m_Solid && togglesTiles;
+        }
+
+        // numCubes entries each
+        inline const int16_t* GetX() const {
+            return m_X.data();
+        }
+
+        inline const int16_t* GetZ() const {
+            return m_Z.data();
+        }
+
+        inline const uint8_t* GetOrientation() const {
+            return m_Orientation.data();
+        }
+
+        // outcome of the last step, 0 or 1
+        inline const uint8_t* GetMoved() const {
+            return m_Moved.data();
+        }
+
+        // Rotation each cube was given in the last step, with GetMoved() this is what rolls are animated from
+        inline const uint8_t* GetRotation() const {
+            return m_Rotation.data();
+        }
+
+        // tile indices changed by the last step
+        inline const std::vector<int>& GetChangedTiles() const {
+            return m_ChangedTiles;
+        }
+
+    private:
+        int Resolve(LevelState& level, const uint8_t* actions);
+
+        inline bool TestBit(const std::vector<uint64_t>& bits, int paddedIx) const {
+            return (bits[paddedIx >> 6] >> (paddedIx & 63)) & 1;
+        }
+
+        inline void FlipBit(std::vector<uint64_t>& bits, int paddedIx) {
+            bits[paddedIx >> 6] ^= uint64_t(1) << (paddedIx & 63);
+        }
+
+        bool m_Solid;
+        bool m_TogglesTiles;
+
+        // per cube
+        std::vector<int16_t> m_X;
+        std::vector<int16_t> m_Z;
+        std::vector<uint8_t> m_Orientation;
+        std::vector<uint8_t> m_Moved;
+        std::vector<uint8_t> m_Rotation;
+
+        std::vector<uint64_t> m_Occupied; // padded index of the level, bit set = solid cube there
+        std::vector<uint64_t> m_Waiting; // cubes of the current step that haven't been resolved yet
+        std::vector<int> m_Order; // cubes in the order the step resolves them
+        std::vector<int> m_Deferred;
+        std::vector<uint8_t> m_Actions; // StepAll()'s rotation for every cube
+        std::vector<int> m_ChangedTiles;
+    };
+}
+
+#endif // CUBE_SWARM_H
@@ -0,0 +1,115 @@
+#include "entityStore.h"
+
+namespace core {
+
+    // entities per block, so that a block of every column of an archetype is about this big
+    static constexpr size_t blockBytes = 16 * 1024;
+
+    EntityStore::EntityStore() :
+        m_NumEntities(0)
+    {
+    }
+
+    int EntityStore::FindArchetype(uint64_t mask) const {
+        auto it = m_ArchetypeOf.find(mask);
+        return it == m_ArchetypeOf.end() ? -1 : it->second;
+    }
+
+    int EntityStore::AddArchetype(uint64_t mask, std::vector<int> types,
+            std::vector<std::unique_ptr<ComponentColumn>> columns) {
+        size_t rowBytes = 0;
+        for (const std::unique_ptr<ComponentColumn>& column : columns)
+            rowBytes += column->GetElementSize();
+
+        auto archetype = std::make_unique<Archetype>();
+        archetype->mask = mask;
+        archetype->rowsPerBlock = (int)std::clamp(blockBytes / std::max(rowBytes, size_t(1)), size_t(1), blockBytes);
+        std::fill(std::begin(archetype->columnOf), std::end(archetype->columnOf), -1);
+        for (size_t i = 0; i < columns.size(); i++) {
+            archetype->columnOf[types[i]] = (int)i;
+            archetype->columns.push_back(columns[i]->MakeEmpty(archetype->rowsPerBlock));
+        }
+        archetype->types = std::move(types);
+
+        m_Archetypes.push_back(std::move(archetype));
+        m_ArchetypeOf[mask] = (int)m_Archetypes.size() - 1;
+        return (int)m_Archetypes.size() - 1;
+    }
+
+    int EntityStore::ArchetypeFor(uint64_t fromMask, uint64_t mask) {
+        const int existing = FindArchetype(mask);
+        if (existing != -1)
+            return existing;
+        const Archetype& from = *m_Archetypes[FindArchetype(fromMask)];
+        std::vector<int> types;
+        std::vector<std::unique_ptr<ComponentColumn>> columns;
+        for (size_t i = 0; i < from.types.size(); i++) {
+            if (mask & (uint64_t(1) << from.types[i])) {
+                types.push_back(from.types[i]);
+                columns.push_back(from.columns[i]->MakeEmpty(1));
+            }
+        }
+        return AddArchetype(mask, std::move(types), std::move(columns));
+    }
+
+    Entity EntityStore::AddRow(int archetypeIx) {
+        uint32_t slot;
+        if (m_FreeSlots.empty()) {
+            slot = (uint32_t)m_Records.size();
+            m_Records.push_back({ 1, -1, 0 });
+        } else {
+            slot = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+        Archetype& archetype = *m_Archetypes[archetypeIx];
+        const Entity entity = (Entity)m_Records[slot].generation << 32 | slot;
+        m_Records[slot].archetype = archetypeIx;
+        m_Records[slot].row = (int)archetype.entities.size();
+        archetype.entities.push_back(entity);
+        m_NumEntities++;
+        return entity;
+    }
+
+    void EntityStore::RemoveRow(Archetype& archetype, int row) {
+        for (const std::unique_ptr<ComponentColumn>& column : archetype.columns)
+            column->SwapRemove(row);
+        const Entity last = archetype.entities.back();
+        archetype.entities[row] = last;
+        archetype.entities.pop_back();
+        if (row < (int)archetype.entities.size())
+            m_Records[(uint32_t)last].row = row;
+    }
+
+    void EntityStore::MoveEntity(Entity entity, int archetypeIx) {
+        Record& record = m_Records[(uint32_t)entity];
+        Archetype& from = *m_Archetypes[record.archetype];
+        Archetype& to = *m_Archetypes[archetypeIx];
+        for (size_t i = 0; i < from.types.size(); i++) {
+            const int column = to.columnOf[from.types[i]];
+            if (column != -1)
+                from.columns[i]->MoveRowTo(record.row, *to.columns[column]);
+        }
+        const int row = record.row;
+        record.archetype = archetypeIx;
+        record.row = (int)to.entities.size();
+        to.entities.push_back(entity);
+        RemoveRow(from, row);
+    }
+
+    bool EntityStore::Destroy(Entity entity) {
+        if (Find(entity) == nullptr)
+            return false;
+        Record& record = m_Records[(uint32_t)entity];
+        RemoveRow(*m_Archetypes[record.archetype], record.row);
+        record.generation++;
+        record.archetype = -1;
+        m_FreeSlots.push_back((uint32_t)entity);
+        m_NumEntities--;
+        return true;
+    }
+
+    bool EntityStore::IsAlive(Entity entity) const {
+        return Find(entity) != nullptr;
+    }
+
+}
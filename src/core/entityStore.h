@@ -0,0 +1,333 @@
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "threadPool.h"
+
+namespace core {
+    // generation << 32 | slot, 0 is never an entity
+    using Entity = uint64_t;
+
+    static constexpr int maxComponentTypes = 64;
+
+    inline int nextComponentType() {
+        static std::atomic<int> counter = 0;
+        const int type = counter++;
+        assert(type < maxComponentTypes);
+        return type;
+    }
+
+    // every component type gets a number on first use, the order differs between runs
+    template <typename T>
+    inline int componentType() {
+        static const int type = nextComponentType();
+        return type;
+    }
+
+    // one component type of one archetype, without knowing the type
+    class ComponentColumn {
+    public:
+        virtual ~ComponentColumn() = default;
+        // an empty column of the same type, for another archetype
+        virtual std::unique_ptr<ComponentColumn> MakeEmpty(int rowsPerBlock) const = 0;
+        // appends row of this column to other, which has to hold the same type, and leaves a moved from value
+        virtual void MoveRowTo(int row, ComponentColumn& other) = 0;
+        // the last row takes the place of row
+        virtual void SwapRemove(int row) = 0;
+        virtual size_t GetElementSize() const = 0;
+    };
+
+    /*
+        Values of one component type, in blocks of rowsPerBlock that never move once
+        allocated. A block is a plain array, the same rows as the blocks of the other
+        columns of the archetype, so a system gets one pointer per component per block.
+    */
+    template <typename T>
+    class Column final : public ComponentColumn {
+    public:
+        explicit Column(int rowsPerBlock) :
+            m_RowsPerBlock(rowsPerBlock),
+            m_Size(0)
+        { }
+
+        ~Column() override {
+            while (m_Size > 0)
+                PopBack();
+        }
+
+        Column(const Column&) = delete;
+        Column& operator=(const Column&) = delete;
+
+        inline T& At(int row) {
+            return BlockData(row / m_RowsPerBlock)[row % m_RowsPerBlock];
+        }
+
+        inline T* BlockData(int block) {
+            return std::launder(reinterpret_cast<T*>(m_Blocks[block].get()));
+        }
+
+        template <typename... Args>
+        T& PushBack(Args&&... args) {
+            if (m_Size == (int)m_Blocks.size() * m_RowsPerBlock)
+                m_Blocks.push_back(std::make_unique<Slot[]>(m_RowsPerBlock));
+            T* value = new (&m_Blocks[m_Size / m_RowsPerBlock][m_Size % m_RowsPerBlock]) T(std::forward<Args>(args)...);
+            m_Size++;
+            return *value;
+        }
+
+        void PopBack() {
+            At(m_Size - 1).~T();
+            m_Size--;
+        }
+
+        std::unique_ptr<ComponentColumn> MakeEmpty(int rowsPerBlock) const override {
+            return std::make_unique<Column<T>>(rowsPerBlock);
+        }
+
+        void MoveRowTo(int row, ComponentColumn& other) override {
+            static_cast<Column<T>&>(other).PushBack(std::move(At(row)));
+        }
+
+        void SwapRemove(int row) override {
+            if (row != m_Size - 1)
+                At(row) = std::move(At(m_Size - 1));
+            PopBack();
+        }
+
+        size_t GetElementSize() const override {
+            return sizeof(T);
+        }
+
+    private:
+        struct alignas(T) Slot {
+            std::byte bytes[sizeof(T)];
+        };
+
+        int m_RowsPerBlock;
+        int m_Size;
+        std::vector<std::unique_ptr<Slot[]>> m_Blocks;
+    };
+
+    /*
+        Entities made of components, stored by archetype.
+
+        All entities with the same set of component types share an archetype, which keeps
+        every component in a column of its own (structure of arrays), in blocks of about
+        16 KB worth of entities. A system names the components it needs and runs over
+        the matching archetypes block by block, on dense arrays, without looking at
+        entities it has no interest in. Blocks are independent of each other, so
+        ParallelEachBlock() hands them out to the threads of a ThreadPool.
+
+        An Entity is a stable handle: a slot plus a generation, so a destroyed entity's
+        handle stops working instead of pointing at whatever took its place. Where its
+        components live changes when a component is added or removed (the entity moves
+        to another archetype), and when another entity of the same archetype is destroyed
+        and this one was the last, which fills the hole. Nothing else moves them, so an
+        entity that is alone in its archetype, like the level or the camera, keeps its
+        components at the same address for good.
+
+        Creating, destroying and changing entities while iterating is not allowed.
+    */
+    class EntityStore {
+    public:
+        EntityStore();
+
+        EntityStore(const EntityStore&) = delete;
+        EntityStore& operator=(const EntityStore&) = delete;
+
+        template <typename... Ts>
+        Entity Create(Ts&&... components) {
+            const uint64_t mask = MaskOf<std::decay_t<Ts>...>();
+            assert(std::popcount(mask) == sizeof...(Ts) && "one component of each type");
+            int archetypeIx = FindArchetype(mask);
+            if (archetypeIx == -1) {
+                std::vector<std::unique_ptr<ComponentColumn>> columns;
+                (columns.push_back(std::make_unique<Column<std::decay_t<Ts>>>(1)), ...);
+                archetypeIx = AddArchetype(mask, { componentType<std::decay_t<Ts>>()... }, std::move(columns));
+            }
+            Archetype& archetype = *m_Archetypes[archetypeIx];
+            (ColumnOf<std::decay_t<Ts>>(archetype).PushBack(std::forward<Ts>(components)), ...);
+            return AddRow(archetypeIx);
+        }
+
+        // false if it was gone already
+        bool Destroy(Entity entity);
+        bool IsAlive(Entity entity) const;
+
+        // null if the entity is gone or has no T
+        template <typename T>
+        T* Get(Entity entity) {
+            const Record* record = Find(entity);
+            if (record == nullptr)
+                return nullptr;
+            Archetype& archetype = *m_Archetypes[record->archetype];
+            if (!(archetype.mask & MaskOf<T>()))
+                return nullptr;
+            return &ColumnOf<T>(archetype).At(record->row);
+        }
+
+        template <typename T>
+        bool Has(Entity entity) const {
+            const Record* record = Find(entity);
+            return record != nullptr && (m_Archetypes[record->archetype]->mask & MaskOf<T>());
+        }
+
+        // gives the entity a T, or replaces the one it has
+        template <typename T>
+        T& Add(Entity entity, T component) {
+            assert(IsAlive(entity));
+            if (T* existing = Get<T>(entity))
+                return *existing = std::move(component);
+            const Record& record = *Find(entity);
+            const Archetype& from = *m_Archetypes[record.archetype];
+            int archetypeIx = FindArchetype(from.mask | MaskOf<T>());
+            if (archetypeIx == -1) {
+                std::vector<int> types = from.types;
+                std::vector<std::unique_ptr<ComponentColumn>> columns;
+                for (const std::unique_ptr<ComponentColumn>& column : from.columns)
+                    columns.push_back(column->MakeEmpty(1));
+                types.push_back(componentType<T>());
+                columns.push_back(std::make_unique<Column<T>>(1));
+                archetypeIx = AddArchetype(from.mask | MaskOf<T>(), std::move(types), std::move(columns));
+            }
+            ColumnOf<T>(*m_Archetypes[archetypeIx]).PushBack(std::move(component));
+            MoveEntity(entity, archetypeIx);
+            return *Get<T>(entity);
+        }
+
+        // false if the entity is gone or had no T
+        template <typename T>
+        bool Remove(Entity entity) {
+            if (!Has<T>(entity))
+                return false;
+            const uint64_t mask = m_Archetypes[Find(entity)->archetype]->mask & ~MaskOf<T>();
+            MoveEntity(entity, ArchetypeFor(m_Archetypes[Find(entity)->archetype]->mask, mask));
+            return true;
+        }
+
+        // fn(count, entities, Ts*...) once per block of every archetype with all of Ts, the arrays have count entries
+        template <typename... Ts, typename F>
+        void EachBlock(F&& fn) {
+            const uint64_t mask = MaskOf<Ts...>();
+            for (const std::unique_ptr<Archetype>& archetype : m_Archetypes) {
+                if ((archetype->mask & mask) != mask)
+                    continue;
+                const int size = (int)archetype->entities.size();
+                const int rows = archetype->rowsPerBlock;
+                for (int block = 0; block * rows < size; block++) {
+                    fn(std::min(rows, size - block * rows), archetype->entities.data() + block * rows,
+                            ColumnOf<Ts>(*archetype).BlockData(block)...);
+                }
+            }
+        }
+
+        // fn(entity, Ts&...) for every entity with all of Ts
+        template <typename... Ts, typename F>
+        void Each(F&& fn) {
+            EachBlock<Ts...>([&](int count, const Entity* entities, Ts*... components) {
+                for (int i = 0; i < count; i++)
+                    fn(entities[i], components[i]...);
+            });
+        }
+
+        // EachBlock() with the blocks spread over the pool's threads, fn has to be fine with that
+        template <typename... Ts, typename F>
+        void ParallelEachBlock(ThreadPool& pool, F&& fn) {
+            const uint64_t mask = MaskOf<Ts...>();
+            m_Blocks.clear();
+            for (const std::unique_ptr<Archetype>& archetype : m_Archetypes) {
+                if ((archetype->mask & mask) != mask)
+                    continue;
+                for (int block = 0; block * archetype->rowsPerBlock < (int)archetype->entities.size(); block++)
+                    m_Blocks.push_back({ archetype.get(), block });
+            }
+            pool.ParallelFor((int)m_Blocks.size(), 1, [&](int begin, int end) {
+                for (int i = begin; i < end; i++) {
+                    Archetype& archetype = *m_Blocks[i].archetype;
+                    const int first = m_Blocks[i].block * archetype.rowsPerBlock;
+                    fn(std::min(archetype.rowsPerBlock, (int)archetype.entities.size() - first),
+                            archetype.entities.data() + first, ColumnOf<Ts>(archetype).BlockData(m_Blocks[i].block)...);
+                }
+            });
+        }
+
+        inline int GetNumEntities() const {
+            return m_NumEntities;
+        }
+
+        inline int GetNumArchetypes() const {
+            return (int)m_Archetypes.size();
+        }
+
+    private:
+        struct Archetype {
+            uint64_t mask;
+            int rowsPerBlock;
+            std::vector<int> types; // component type of each column
+            std::vector<std::unique_ptr<ComponentColumn>> columns;
+            int columnOf[maxComponentTypes]; // -1 for types it doesn't have
+            std::vector<Entity> entities; // per row
+        };
+
+        struct Record {
+            uint32_t generation; // bumped when the entity is destroyed
+            int archetype; // -1 while the slot is free
+            int row;
+        };
+
+        struct BlockRef {
+            Archetype* archetype;
+            int block;
+        };
+
+        template <typename... Ts>
+        static uint64_t MaskOf() {
+            return (uint64_t(0) | ... | (uint64_t(1) << componentType<Ts>()));
+        }
+
+        template <typename T>
+        static Column<T>& ColumnOf(Archetype& archetype) {
+            return static_cast<Column<T>&>(*archetype.columns[archetype.columnOf[componentType<T>()]]);
+        }
+
+        inline const Record* Find(Entity entity) const {
+            const uint32_t slot = (uint32_t)entity;
+            if (slot >= m_Records.size() || m_Records[slot].generation != (uint32_t)(entity >> 32) ||
+                    m_Records[slot].archetype == -1)
+                return nullptr;
+            return &m_Records[slot];
+        }
+
+        int FindArchetype(uint64_t mask) const;
+        // the columns are made with 1 row per block, it picks the real number
+        int AddArchetype(uint64_t mask, std::vector<int> types, std::vector<std::unique_ptr<ComponentColumn>> columns);
+        // the archetype of mask, made from the columns of the one of fromMask (a superset) if it is new
+        int ArchetypeFor(uint64_t fromMask, uint64_t mask);
+        // a new entity for the row just pushed to every column of the archetype
+        Entity AddRow(int archetypeIx);
+        // moves the entity's components to another archetype, one that has all of them or fewer. Any
+        // column only the target has must have been pushed already
+        void MoveEntity(Entity entity, int archetypeIx);
+        // removes a row from every column of the archetype, the last row takes its place
+        void RemoveRow(Archetype& archetype, int row);
+
+        std::vector<std::unique_ptr<Archetype>> m_Archetypes;
+        std::unordered_map<uint64_t, int> m_ArchetypeOf; // by mask
+        std::vector<Record> m_Records;
+        std::vector<uint32_t> m_FreeSlots;
+        std::vector<BlockRef> m_Blocks; // of the current ParallelEachBlock()
+        int m_NumEntities;
+    };
+}
+
+#endif // ENTITY_STORE_H
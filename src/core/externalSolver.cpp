@@ -0,0 +1,486 @@
+#include "solver.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace core {
+
+    namespace {
+        // files sort states by their last word first, so the words that change least lead
+        bool stateLess(const uint64_t* a, const uint64_t* b, int numWords) {
+            for (int w = numWords - 1; w >= 0; w--) {
+                if (a[w] != b[w])
+                    return a[w] < b[w];
+            }
+            return false;
+        }
+
+        /*
+            Writes a sorted run of distinct states. Each one is the number of leading words it
+            shares with the one before (left out with a single word), the difference in the
+            first word that isn't shared, then the rest of the words, all as varints.
+        */
+        class RunWriter {
+        public:
+            RunWriter(const std::filesystem::path& path, int numWords, size_t bufferBytes) :
+                m_File(path, std::ios::binary),
+                m_Buffer(bufferBytes),
+                m_Previous(numWords, 0),
+                m_NumWords(numWords)
+            {
+            }
+
+            void Write(const uint64_t* state) {
+                if (m_Used + (size_t)(m_NumWords + 1) * 10 > m_Buffer.size())
+                    Flush();
+                int w = m_NumWords - 1;
+                while (w > 0 && state[w] == m_Previous[w])
+                    w--;
+                if (m_NumWords > 1)
+                    PutVarint((uint64_t)(m_NumWords - 1 - w));
+                PutVarint(state[w] - m_Previous[w]);
+                for (int low = w - 1; low >= 0; low--)
+                    PutVarint(state[low]);
+                std::copy_n(state, m_NumWords, m_Previous.data());
+                m_Count++;
+            }
+
+            // false if anything failed to get to the file
+            bool Close() {
+                Flush();
+                m_File.close();
+                return !m_File.fail();
+            }
+
+            int64_t GetCount() const { return m_Count; }
+            int64_t GetBytes() const { return m_Bytes; }
+
+        private:
+            void PutVarint(uint64_t value) {
+                while (value >= 0x80) {
+                    m_Buffer[m_Used++] = (uint8_t)(value | 0x80);
+                    value >>= 7;
+                }
+                m_Buffer[m_Used++] = (uint8_t)value;
+            }
+
+            void Flush() {
+                m_File.write(reinterpret_cast<const char*>(m_Buffer.data()), (std::streamsize)m_Used);
+                m_Bytes += (int64_t)m_Used;
+                m_Used = 0;
+            }
+
+            std::ofstream m_File;
+            std::vector<uint8_t> m_Buffer;
+            size_t m_Used = 0;
+            std::vector<uint64_t> m_Previous;
+            int m_NumWords;
+            int64_t m_Count = 0;
+            int64_t m_Bytes = 0;
+        };
+
+        // reads back what a RunWriter wrote, a buffer at a time
+        class RunReader {
+        public:
+            RunReader(const std::filesystem::path& path, int numWords, size_t bufferBytes) :
+                m_File(path, std::ios::binary),
+                m_MaxRecord((size_t)(numWords + 1) * 10),
+                m_Buffer(bufferBytes + m_MaxRecord),
+                m_Current(numWords, 0),
+                m_NumWords(numWords),
+                m_Failed(!m_File.is_open())
+            {
+            }
+
+            // false at the end of the file, or if it couldn't be read (see Failed())
+            bool Next() {
+                if (m_End - m_Pos < m_MaxRecord && !m_Done)
+                    Refill();
+                if (m_Pos == m_End)
+                    return false;
+                const int shared = m_NumWords > 1 ? (int)GetVarint() : 0;
+                const int w = m_NumWords - 1 - std::min(shared, m_NumWords - 1);
+                m_Current[w] += GetVarint();
+                for (int low = w - 1; low >= 0; low--)
+                    m_Current[low] = GetVarint();
+                // a record cut short ran into whatever was left past the end
+                if (m_Pos > m_End) {
+                    m_Failed = true;
+                    m_Pos = m_End;
+                    return false;
+                }
+                return true;
+            }
+
+            const uint64_t* Get() const { return m_Current.data(); }
+            bool Failed() const { return m_Failed; }
+            int64_t GetBytes() const { return m_Bytes; }
+
+        private:
+            uint64_t GetVarint() {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7) {
+                    const uint8_t byte = m_Buffer[m_Pos++];
+                    value |= (uint64_t)(byte & 0x7F) << shift;
+                    if (byte < 0x80)
+                        break;
+                }
+                return value;
+            }
+
+            void Refill() {
+                const size_t left = m_End - m_Pos;
+                std::copy(m_Buffer.begin() + m_Pos, m_Buffer.begin() + m_End, m_Buffer.begin());
+                m_Pos = 0;
+                m_End = left;
+                if (m_Failed) {
+                    m_Done = true;
+                    return;
+                }
+                const size_t wanted = m_Buffer.size() - m_MaxRecord - left;
+                m_File.read(reinterpret_cast<char*>(m_Buffer.data() + left), (std::streamsize)wanted);
+                const size_t got = (size_t)m_File.gcount();
+                m_End += got;
+                m_Bytes += (int64_t)got;
+                if (got < wanted) {
+                    m_Done = true;
+                    m_Failed = m_File.bad();
+                }
+            }
+
+            std::ifstream m_File;
+            size_t m_MaxRecord; // bytes of the longest state, the buffer keeps at least that much in it while it can
+            std::vector<uint8_t> m_Buffer;
+            size_t m_Pos = 0;
+            size_t m_End = 0;
+            bool m_Done = false;
+            std::vector<uint64_t> m_Current;
+            int m_NumWords;
+            bool m_Failed;
+            int64_t m_Bytes = 0;
+        };
+
+        // the distinct states of a few sorted files, in order
+        class MergedStream {
+        public:
+            MergedStream(const std::vector<std::filesystem::path>& paths, int numWords, size_t bufferBytes) :
+                m_Current(numWords, 0),
+                m_NumWords(numWords)
+            {
+                m_Readers.reserve(paths.size());
+                for (const std::filesystem::path& path : paths) {
+                    m_Readers.emplace_back(path, numWords, bufferBytes);
+                    if (m_Readers.back().Next())
+                        PushReader((int)m_Readers.size() - 1);
+                }
+            }
+
+            bool Next() {
+                while (!m_Heap.empty()) {
+                    std::pop_heap(m_Heap.begin(), m_Heap.end(), Later{ this });
+                    const int top = m_Heap.back();
+                    m_Heap.pop_back();
+                    RunReader& reader = m_Readers[top];
+                    const bool repeated = m_HasCurrent &&
+                        std::equal(m_Current.begin(), m_Current.end(), reader.Get());
+                    std::copy_n(reader.Get(), m_NumWords, m_Current.data());
+                    if (reader.Next())
+                        PushReader(top);
+                    if (!repeated) {
+                        m_HasCurrent = true;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            const uint64_t* Get() const { return m_Current.data(); }
+
+            bool Failed() const {
+                return std::any_of(m_Readers.begin(), m_Readers.end(), [](const RunReader& r) { return r.Failed(); });
+            }
+
+            int64_t GetBytes() const {
+                int64_t bytes = 0;
+                for (const RunReader& reader : m_Readers)
+                    bytes += reader.GetBytes();
+                return bytes;
+            }
+
+        private:
+            // heap order, the reader with the smallest state on top
+            struct Later {
+                const MergedStream* stream;
+                bool operator()(int a, int b) const {
+                    return stateLess(stream->m_Readers[b].Get(), stream->m_Readers[a].Get(), stream->m_NumWords);
+                }
+            };
+
+            void PushReader(int ix) {
+                m_Heap.push_back(ix);
+                std::push_heap(m_Heap.begin(), m_Heap.end(), Later{ this });
+            }
+
+            std::vector<RunReader> m_Readers;
+            std::vector<int> m_Heap;
+            std::vector<uint64_t> m_Current;
+            bool m_HasCurrent = false;
+            int m_NumWords;
+        };
+
+        // a directory of its own for the files of one search, gone with everything in it afterwards
+        class TempDirectory {
+        public:
+            explicit TempDirectory(const std::string& parent) {
+                static std::atomic<int> counter = 0;
+                std::error_code error;
+                const std::filesystem::path base = parent.empty() ? std::filesystem::temp_directory_path(error) :
+                    std::filesystem::path(parent);
+                if (error)
+                    return;
+                const auto ticks = std::chrono::system_clock::now().time_since_epoch().count();
+                m_Path = base / ("core-solve-" + std::to_string(ticks) + "-" + std::to_string(counter++));
+                m_Created = std::filesystem::create_directory(m_Path, error) && !error;
+            }
+
+            ~TempDirectory() {
+                std::error_code error;
+                if (m_Created)
+                    std::filesystem::remove_all(m_Path, error);
+            }
+
+            TempDirectory(const TempDirectory&) = delete;
+            TempDirectory& operator=(const TempDirectory&) = delete;
+
+            bool IsCreated() const { return m_Created; }
+            std::filesystem::path File(const std::string& name) const { return m_Path / name; }
+
+        private:
+            std::filesystem::path m_Path;
+            bool m_Created = false;
+        };
+
+        // merges the files into one, adding the traffic to layer. False if any of it failed
+        bool mergeFiles(const std::vector<std::filesystem::path>& inputs, const std::filesystem::path& output,
+                int numWords, size_t bufferBytes, ExternalLayer& layer) {
+            MergedStream stream(inputs, numWords, bufferBytes);
+            RunWriter writer(output, numWords, bufferBytes);
+            while (stream.Next())
+                writer.Write(stream.Get());
+            const bool written = writer.Close();
+            layer.bytesRead += stream.GetBytes();
+            layer.bytesWritten += writer.GetBytes();
+            return written && !stream.Failed();
+        }
+
+        void removeFiles(const std::vector<std::filesystem::path>& paths) {
+            std::error_code error;
+            for (const std::filesystem::path& path : paths)
+                std::filesystem::remove(path, error);
+        }
+    }
+
+    SolveResult solveExternal(const StateSpace& space, const SolveOptions& options, std::vector<ExternalLayer>* layers) {
+        const auto start = std::chrono::steady_clock::now();
+        const int numWords = space.GetNumWords();
+        SolveResult result = { SolveStatus::UNSOLVABLE, {}, 0, 1, 0, 0.0 };
+        if (layers != nullptr)
+            layers->clear();
+        auto finish = [&]() {
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return result;
+        };
+        if (!space.HasGoal())
+            return finish();
+        if (space.IsGoal(space.GetStart())) {
+            result.status = SolveStatus::SOLVED;
+            return finish();
+        }
+        const TempDirectory directory(options.tempDirectory);
+        if (!directory.IsCreated()) {
+            result.status = SolveStatus::FAILED;
+            return finish();
+        }
+
+        // half of the memory sorts successors, the other half holds the buffers of one merge.
+        // Bigger buffers mean longer sequential reads, more of them mean fewer merge passes
+        const int64_t maxMemory = std::max<int64_t>(options.maxMemory, int64_t(1) << 20);
+        const size_t bufferBytes = (size_t)std::clamp<int64_t>(maxMemory / 64, 4 << 10, 1 << 20);
+        const int fanIn = (int)std::max<int64_t>(4, maxMemory / 2 / (int64_t)bufferBytes - 2);
+        const size_t sortCapacity = (size_t)(maxMemory / 2 / (numWords * 8 + (numWords > 1 ? 4 : 0)));
+        int numFiles = 0;
+        auto newFile = [&](const char* kind) { return directory.File(kind + std::to_string(numFiles++)); };
+
+        // every layer stays, the walk back needs them. seen is what a new layer is checked against:
+        // layer files, and merged copies of the older ones once there would be too many to open at once
+        std::vector<std::filesystem::path> layerFiles = { newFile("layer") };
+        RunWriter first(layerFiles[0], numWords, bufferBytes);
+        first.Write(space.GetStart());
+        bool ok = first.Close();
+        std::vector<std::filesystem::path> seen = layerFiles;
+
+        std::vector<uint64_t> buffer;
+        buffer.reserve(sortCapacity * numWords);
+        std::vector<uint32_t> order;
+        std::vector<uint64_t> successors(numRotations * numWords);
+        std::array<Rotation, numRotations> moves;
+        std::vector<uint64_t> goal;
+        while (ok) {
+            ExternalLayer layer = { result.depth, 0, 0, 0, 0 };
+            std::vector<std::filesystem::path> runs;
+            // sorts the buffer and writes it out without repeats
+            auto spill = [&]() {
+                const size_t count = buffer.size() / numWords;
+                RunWriter writer(runs.emplace_back(newFile("run")), numWords, bufferBytes);
+                if (numWords == 1) {
+                    std::sort(buffer.begin(), buffer.end());
+                    for (size_t i = 0; i < count; i++) {
+                        if (i == 0 || buffer[i] != buffer[i - 1])
+                            writer.Write(&buffer[i]);
+                    }
+                } else {
+                    order.resize(count);
+                    for (size_t i = 0; i < count; i++)
+                        order[i] = (uint32_t)i;
+                    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                        return stateLess(&buffer[(size_t)a * numWords], &buffer[(size_t)b * numWords], numWords);
+                    });
+                    for (size_t i = 0; i < count; i++) {
+                        const uint64_t* state = &buffer[(size_t)order[i] * numWords];
+                        if (i == 0 || stateLess(&buffer[(size_t)order[i - 1] * numWords], state, numWords))
+                            writer.Write(state);
+                    }
+                }
+                buffer.clear();
+                ok = writer.Close() && ok;
+                layer.bytesWritten += writer.GetBytes();
+            };
+
+            RunReader frontier(layerFiles.back(), numWords, bufferBytes);
+            while (goal.empty() && frontier.Next()) {
+                const int count = space.Expand(frontier.Get(), successors.data(), moves.data());
+                result.expanded++;
+                for (int i = 0; i < count; i++) {
+                    const uint64_t* successor = successors.data() + i * numWords;
+                    // a goal can't have been seen before, the search would have stopped there
+                    if (space.IsGoal(successor)) {
+                        goal.assign(successor, successor + numWords);
+                        break;
+                    }
+                    if (buffer.size() == sortCapacity * numWords)
+                        spill();
+                    buffer.insert(buffer.end(), successor, successor + numWords);
+                }
+            }
+            ok = ok && !frontier.Failed();
+            layer.bytesRead += frontier.GetBytes();
+            layer.depth = result.depth + 1;
+            if (!goal.empty() || !ok) {
+                // the rest of the layer isn't needed, the goal is the only state it gets
+                layer.states = goal.empty() ? 0 : 1;
+                buffer.clear();
+                removeFiles(runs);
+                layer.runs = (int)runs.size();
+                if (layers != nullptr)
+                    layers->push_back(layer);
+                if (ok)
+                    result.depth++;
+                break;
+            }
+            if (!buffer.empty())
+                spill();
+            layer.runs = (int)runs.size();
+
+            // merge passes until the runs and the seen files can all be read at once
+            const int maxRuns = fanIn / 2;
+            while (ok && (int)runs.size() > maxRuns) {
+                const size_t count = std::min<size_t>(fanIn, runs.size());
+                const std::vector<std::filesystem::path> inputs(runs.begin(), runs.begin() + count);
+                runs.erase(runs.begin(), runs.begin() + count);
+                ok = mergeFiles(inputs, runs.emplace_back(newFile("run")), numWords, bufferBytes, layer);
+                removeFiles(inputs);
+            }
+
+            // the new layer is every successor that isn't in seen, both streams are sorted
+            int64_t newStates = 0;
+            if (ok) {
+                MergedStream candidates(runs, numWords, bufferBytes);
+                MergedStream previous(seen, numWords, bufferBytes);
+                RunWriter next(layerFiles.emplace_back(newFile("layer")), numWords, bufferBytes);
+                bool hasPrevious = previous.Next();
+                while (candidates.Next()) {
+                    while (hasPrevious && stateLess(previous.Get(), candidates.Get(), numWords))
+                        hasPrevious = previous.Next();
+                    if (hasPrevious && std::equal(candidates.Get(), candidates.Get() + numWords, previous.Get()))
+                        continue;
+                    next.Write(candidates.Get());
+                }
+                ok = next.Close() && !candidates.Failed() && !previous.Failed();
+                newStates = next.GetCount();
+                layer.bytesRead += candidates.GetBytes() + previous.GetBytes();
+                layer.bytesWritten += next.GetBytes();
+            }
+            removeFiles(runs);
+            layer.states = newStates;
+
+            if (ok && newStates > 0) {
+                result.depth++;
+                result.visited += newStates;
+                seen.push_back(layerFiles.back());
+                if ((int)seen.size() > fanIn - maxRuns) {
+                    const std::vector<std::filesystem::path> inputs = std::move(seen);
+                    seen = { newFile("seen") };
+                    ok = mergeFiles(inputs, seen[0], numWords, bufferBytes, layer);
+                    // the first one may be an older merge, the layers stay
+                    if (inputs[0].filename().string().starts_with("seen"))
+                        removeFiles({ inputs[0] });
+                }
+            }
+            if (layers != nullptr)
+                layers->push_back(layer);
+            if (newStates == 0 || result.visited >= options.maxStates) {
+                if (newStates > 0)
+                    result.status = SolveStatus::GAVE_UP;
+                break;
+            }
+        }
+
+        if (ok && !goal.empty()) {
+            // the layer before has a state that rolls into the goal, the one before that a state that
+            // rolls into it, and so on back to the start
+            ExternalLayer walk = { -1, 0, 0, 0, 0 };
+            std::vector<uint64_t> target = goal;
+            for (int d = result.depth - 1; d >= 0 && ok; d--) {
+                RunReader reader(layerFiles[d], numWords, bufferBytes);
+                bool matched = false;
+                while (!matched && reader.Next()) {
+                    const int count = space.Expand(reader.Get(), successors.data(), moves.data());
+                    for (int i = 0; i < count && !matched; i++) {
+                        if (std::equal(target.begin(), target.end(), successors.data() + i * numWords)) {
+                            result.moves.push_back(moves[i]);
+                            std::copy_n(reader.Get(), numWords, target.data());
+                            matched = true;
+                        }
+                    }
+                }
+                walk.bytesRead += reader.GetBytes();
+                ok = matched && !reader.Failed();
+            }
+            std::reverse(result.moves.begin(), result.moves.end());
+            if (layers != nullptr)
+                layers->push_back(walk);
+            if (ok)
+                result.status = SolveStatus::SOLVED;
+        }
+        if (!ok) {
+            result.status = SolveStatus::FAILED;
+            result.moves.clear();
+        }
+        return finish();
+    }
+
+}
@@ -0,0 +1,179 @@
+#include "solver.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include "patternDatabase.h"
+
+namespace core {
+
+    SolveResult solveAStar(const StateSpace& space, const PatternDatabase& heuristic, const SolveOptions& options) {
+        const auto start = std::chrono::steady_clock::now();
+        const int numWords = space.GetNumWords();
+        SolveResult result = { SolveStatus::UNSOLVABLE, {}, 0, 1, 0, 0.0 };
+
+        struct OpenEntry {
+            uint32_t ix;
+            int g; // moves to the state when it was put on the list, stale if it got a shorter way since
+        };
+        StateSet states(numWords, std::min(options.expectedStates, options.maxStates));
+        std::vector<int> g;
+        std::vector<uint32_t> parent;
+        std::vector<Rotation> moveTo;
+        std::vector<uint8_t> closed;
+        std::vector<std::vector<OpenEntry>> open; // by f
+
+        const int startEstimate = heuristic.Estimate(space.GetStart());
+        if (space.HasGoal() && startEstimate != PatternDatabase::unreachable) {
+            states.Insert(space.GetStart());
+            g.push_back(0);
+            parent.push_back(0);
+            moveTo.push_back(Rotation::DOWN);
+            closed.push_back(0);
+            open.resize(startEstimate + 1);
+            open[startEstimate].push_back({ 0, 0 });
+        }
+
+        int64_t found = -1;
+        std::vector<uint64_t> current(numWords);
+        std::vector<uint64_t> successors(numRotations * numWords);
+        std::array<Rotation, numRotations> moves;
+        for (size_t f = 0; f < open.size() && found == -1 && result.status != SolveStatus::GAVE_UP; f++) {
+            while (!open[f].empty() && found == -1) {
+                const OpenEntry entry = open[f].back();
+                open[f].pop_back();
+                if (closed[entry.ix] || entry.g != g[entry.ix])
+                    continue;
+                // copied, inserting may move the states
+                std::copy_n(states.Get(entry.ix), numWords, current.data());
+                if (space.IsGoal(current.data())) {
+                    found = entry.ix;
+                    break;
+                }
+                closed[entry.ix] = 1;
+                result.expanded++;
+
+                const int count = space.Expand(current.data(), successors.data(), moves.data());
+                for (int i = 0; i < count; i++) {
+                    const uint64_t* successor = successors.data() + i * numWords;
+                    const int estimate = heuristic.Estimate(successor);
+                    if (estimate == PatternDatabase::unreachable)
+                        continue;
+                    if (states.GetSize() >= options.maxStates && states.Find(successor) == -1) {
+                        result.status = SolveStatus::GAVE_UP;
+                        break;
+                    }
+                    const int nextG = entry.g + 1;
+                    auto [ix, inserted] = states.Insert(successor);
+                    if (inserted) {
+                        g.push_back(nextG);
+                        parent.push_back(entry.ix);
+                        moveTo.push_back(moves[i]);
+                        closed.push_back(0);
+                    } else if (closed[ix] || nextG >= g[ix]) {
+                        continue;
+                    } else {
+                        g[ix] = nextG;
+                        parent[ix] = entry.ix;
+                        moveTo[ix] = moves[i];
+                    }
+                    // the estimate never drops by more than a move, so f never goes below the current one
+                    const size_t nextF = (size_t)(nextG + estimate);
+                    if (nextF >= open.size())
+                        open.resize(nextF + 1);
+                    open[nextF].push_back({ (uint32_t)ix, nextG });
+                }
+                if (result.status == SolveStatus::GAVE_UP)
+                    break;
+            }
+        }
+
+        if (found != -1) {
+            result.status = SolveStatus::SOLVED;
+            for (int64_t ix = found; ix != 0; ix = parent[ix])
+                result.moves.push_back(moveTo[ix]);
+            std::reverse(result.moves.begin(), result.moves.end());
+            result.depth = (int)result.moves.size();
+        }
+        result.visited = states.GetSize();
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    namespace {
+        struct IdaSearch {
+            const StateSpace& space;
+            const PatternDatabase& heuristic;
+            int64_t maxExpanded;
+            int numWords;
+            int bound;
+            int nextBound; // smallest f over the bound seen this round
+            std::vector<uint64_t> stack; // the root, then numRotations successors per depth
+            std::vector<Rotation> path;
+            SolveResult& result;
+
+            // true once a goal is found (path holds the moves) or the search has to give up. The state
+            // is at offset in the stack, which may grow (and move) deeper down
+            bool Search(size_t offset, int g, int estimate) {
+                if (g + estimate > bound) {
+                    nextBound = std::min(nextBound, g + estimate);
+                    return false;
+                }
+                if (space.IsGoal(stack.data() + offset))
+                    return true;
+                if (result.expanded >= maxExpanded) {
+                    result.status = SolveStatus::GAVE_UP;
+                    return true;
+                }
+                result.expanded++;
+
+                const size_t base = (size_t)numWords + (size_t)g * numRotations * numWords;
+                if (stack.size() < base + numRotations * numWords)
+                    stack.resize(base + numRotations * numWords);
+                std::array<Rotation, numRotations> moves;
+                const int count = space.Expand(stack.data() + offset, stack.data() + base, moves.data());
+                result.visited += count;
+                for (int i = 0; i < count; i++) {
+                    const size_t successor = base + i * numWords;
+                    const int nextEstimate = heuristic.Estimate(stack.data() + successor);
+                    if (nextEstimate == PatternDatabase::unreachable)
+                        continue;
+                    path.push_back(moves[i]);
+                    if (Search(successor, g + 1, nextEstimate))
+                        return true;
+                    path.pop_back();
+                }
+                return false;
+            }
+        };
+    }
+
+    SolveResult solveIdaStar(const StateSpace& space, const PatternDatabase& heuristic, const SolveOptions& options) {
+        const auto start = std::chrono::steady_clock::now();
+        SolveResult result = { SolveStatus::UNSOLVABLE, {}, 0, 1, 0, 0.0 };
+
+        const int startEstimate = heuristic.Estimate(space.GetStart());
+        if (space.HasGoal() && startEstimate != PatternDatabase::unreachable) {
+            IdaSearch search = { space, heuristic, options.maxStates, space.GetNumWords(), startEstimate, 0,
+                std::vector<uint64_t>(space.GetStart(), space.GetStart() + space.GetNumWords()), {}, result };
+            while (true) {
+                search.nextBound = PatternDatabase::unreachable;
+                result.depth = search.bound;
+                if (search.Search(0, 0, startEstimate)) {
+                    if (result.status != SolveStatus::GAVE_UP) {
+                        result.status = SolveStatus::SOLVED;
+                        result.moves = search.path;
+                    }
+                    break;
+                }
+                // nothing got cut off, every line ended in a dead end. Without a visited set a round can't
+                // tell that it went through every state, so on levels with loops this never happens
+                if (search.nextBound == PatternDatabase::unreachable)
+                    break;
+                search.bound = search.nextBound;
+            }
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+}
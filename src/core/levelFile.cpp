@@ -0,0 +1,243 @@
+#include "levelFile.h"
+#include <cstdlib>
+#include <fstream>
+#include <string_view>
+#include <vector>
+#include "rules.h"
+#include "tileRules.h"
+
+// numbers of a "(a,b,c)" line
+static std::vector<float> parseTuple(const std::string& line) {
+    std::vector<float> numbers;
+    const char* c = line.c_str();
+    while (*c != '\0') {
+        if (*c == '(' || *c == ')' || *c == ',' || *c == ' ') {
+            c++;
+            continue;
+        }
+        char* end;
+        float value = std::strtof(c, &end);
+        if (end == c)
+            return {};
+        numbers.push_back(value);
+        c = end;
+    }
+    return numbers;
+}
+
+namespace core {
+
+    char tileGlyph(TileType type) {
+        return tileInfo[(int)type].glyph;
+    }
+
+    int tileFromGlyph(char c) {
+        for (int t = 0; t < numTileTypes; t++) {
+            if (tileInfo[t].glyph == c)
+                return t;
+        }
+        return -1;
+    }
+
+    int voxelFromGlyph(char c) {
+        for (int t = 0; t < numVoxelTypes; t++) {
+            if (voxelInfo[t].glyph == c)
+                return t;
+        }
+        return -1;
+    }
+
+    // "@x,z:glyphs", one column of voxels from layer 0 up
+    static bool readVoxelColumn(const std::string& line, VoxelGrid& voxels, std::string& error) {
+        const char* c = line.c_str() + 1;
+        char* end;
+        const long x = std::strtol(c, &end, 10);
+        if (end == c || *end != ',') {
+            error = "voxel column is invalid";
+            return false;
+        }
+        c = end + 1;
+        const long z = std::strtol(c, &end, 10);
+        if (end == c || *end != ':') {
+            error = "voxel column is invalid";
+            return false;
+        }
+        const int low = -(voxels.GetPaddedOffset() - 1);
+        if (x < low || z < low || x >= low + voxels.GetSideLength() || z >= low + voxels.GetSideLength()) {
+            error = "voxel column is outside the grid";
+            return false;
+        }
+        const std::string_view glyphs(end + 1);
+        if ((int)glyphs.size() > VoxelGrid::numLayers) {
+            error = "voxel column is too high";
+            return false;
+        }
+        for (int layer = 0; layer < (int)glyphs.size(); layer++) {
+            const int type = voxelFromGlyph(glyphs[layer]);
+            if (type == -1) {
+                error = "voxel column is invalid";
+                return false;
+            }
+            voxels.Set((int)x, layer, (int)z, static_cast<VoxelType>(type));
+        }
+        return true;
+    }
+
+    bool readLevel(std::istream& in, LevelState& level, std::string& error) {
+        std::string line;
+        std::vector<float> position;
+        std::vector<float> faces;
+        // rows go straight into the grid, which is created once the first one gives the size
+        LevelState loaded;
+        int rowLength = 0;
+        int numRows = 0;
+        int lineCounter = 0;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+
+            if (lineCounter == 0) {
+                position = parseTuple(line);
+            } else if (lineCounter == 1) {
+                faces = parseTuple(line);
+            } else if (line.starts_with('@')) {
+                if (rowLength == 0 || numRows != rowLength) {
+                    error = "voxel column before the end of the tile map";
+                    return false;
+                }
+                if (!readVoxelColumn(line, loaded.voxels, error))
+                    return false;
+            } else if (!line.starts_with('[') && !line.empty()) {
+                if (rowLength == 0) {
+                    for (char c : line)
+                        rowLength += tileFromGlyph(c) != -1;
+                    if (rowLength == 0) {
+                        lineCounter++;
+                        continue;
+                    }
+                    // checked before the grid exists, its chunk directory alone grows with the side squared
+                    if (rowLength > maxLevelSide) {
+                        error = "tile map wider than " + std::to_string(maxLevelSide) + " tiles";
+                        return false;
+                    }
+                    loaded = makeLevelState(rowLength);
+                }
+
+                int rowTiles = 0;
+                for (char c : line) {
+                    int tile = tileFromGlyph(c);
+                    if (tile == -1)
+                        continue;
+                    if (rowTiles < rowLength && numRows < rowLength)
+                        loaded.tiles.Set(numRows * rowLength + rowTiles, static_cast<TileType>(tile));
+                    rowTiles++;
+                }
+                if (rowTiles != rowLength) {
+                    error = "tile map is not square";
+                    return false;
+                }
+                numRows++;
+            }
+            lineCounter++;
+        }
+
+        if (position.size() != 3) {
+            error = "player position is invalid";
+            return false;
+        }
+        if (faces.size() != 6) {
+            error = "player rotation is invalid";
+            return false;
+        }
+        if (rowLength == 0 || numRows != rowLength) {
+            error = "tile map is not square";
+            return false;
+        }
+
+        std::array<Face, 6> playerFaces;
+        for (int i = 0; i < 6; i++)
+            playerFaces[i] = static_cast<Face>((int)faces[i]);
+        int orientation = orientationFromFaces(playerFaces);
+        if (orientation == -1) {
+            error = "player rotation is not a cube orientation";
+            return false;
+        }
+
+        // the y coordinate is kept in the file but the cube always sits on the ground
+        const int x = (int)position[0];
+        const int z = (int)position[2];
+        if (loaded.tiles.GetTileIndex(x, z) == -1) {
+            error = "player position is outside the grid";
+            return false;
+        }
+        // the level is only touched once the whole file turned out fine
+        loaded.player = CubePose{ (int16_t)x, (int16_t)z, (uint8_t)orientation };
+        level = std::move(loaded);
+        return true;
+    }
+
+    bool loadLevelFile(const std::string& path, LevelState& level, std::string& error) {
+        std::ifstream in(path);
+        if (!in) {
+            error = "failed to read " + path;
+            return false;
+        }
+        return readLevel(in, level, error);
+    }
+
+    void writeLevel(std::ostream& out, const LevelState& level) {
+        out << "(" << level.player.x << "," << 0 << "," << level.player.z << ")\n";
+
+        const std::array<Face, 6>& playerFaces = orientationTables.faces[level.player.orientation];
+        out << "(";
+        for (int i = 0; i < 6; i++) {
+            out << (int)playerFaces[i];
+            if (i != 5)
+                out << ",";
+        }
+        out << ")\n";
+
+        const int sideLength = level.tiles.GetSideLength();
+        std::string row(sideLength, '.');
+        for (int z = 0; z < sideLength; z++) {
+            for (int x = 0; x < sideLength; x++)
+                row[x] = tileGlyph(level.tiles.Get(z * sideLength + x));
+            out << row << "\n";
+        }
+
+        // chunk by chunk, most of a big level has none
+        const VoxelGrid& voxels = level.voxels;
+        const int chunksPerRow = voxels.GetChunksPerRow();
+        for (int chunkIx = 0; chunkIx < voxels.GetNumChunks(); chunkIx++) {
+            const VoxelChunk* chunk = voxels.GetChunk(chunkIx);
+            if (chunk == nullptr || chunk->numSolid == 0)
+                continue;
+            for (int cz = 0; cz < VoxelChunk::side; cz++) {
+                for (int cx = 0; cx < VoxelChunk::side; cx++) {
+                    int height = 0;
+                    for (int layer = 0; layer < VoxelGrid::numLayers; layer++) {
+                        if (chunk->cells[layer * VoxelChunk::layerCells + cz * VoxelChunk::side + cx] != (uint8_t)VoxelType::EMPTY)
+                            height = layer + 1;
+                    }
+                    if (height == 0)
+                        continue;
+                    const int x = chunkIx % chunksPerRow * VoxelChunk::side + cx - voxels.GetPaddedOffset();
+                    const int z = chunkIx / chunksPerRow * VoxelChunk::side + cz - voxels.GetPaddedOffset();
+                    out << "@" << x << "," << z << ":";
+                    for (int layer = 0; layer < height; layer++)
+                        out << voxelInfo[chunk->cells[layer * VoxelChunk::layerCells + cz * VoxelChunk::side + cx]].glyph;
+                    out << "\n";
+                }
+            }
+        }
+    }
+
+    bool saveLevelFile(const std::string& path, const LevelState& level) {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        writeLevel(out, level);
+        return (bool)out;
+    }
+
+}
@@ -0,0 +1,36 @@
+#ifndef LEVEL_FILE_H
+#define LEVEL_FILE_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include "levelState.h"
+
+namespace core {
+    /*
+        Text level format written by the editor:
+
+            (x,y,z)             player position, y is ignored
+            (f0,f1,f2,f3,f4,f5) Face sitting at each Orientation
+            ##D.L               one line of tile glyphs per row, sideLength rows
+            @x,z:#.v            voxels of one column, from layer 0 up, after the rows
+
+        Glyphs are . # D L O T for EMPTY, GROUND, DARK, LIGHT, TARGET_OFF and TARGET_ON
+        (the rest are in core::tileInfo). The side length comes from the tile rows.
+        Voxel columns are in centered tile coords like the player, with the glyphs of
+        core::voxelInfo, levels without voxels have no such line. Lines starting with
+        '[' are the model matrix older editors saved, they are skipped.
+    */
+    bool readLevel(std::istream& in, LevelState& level, std::string& error);
+    bool loadLevelFile(const std::string& path, LevelState& level, std::string& error);
+    void writeLevel(std::ostream& out, const LevelState& level);
+    bool saveLevelFile(const std::string& path, const LevelState& level);
+
+    char tileGlyph(TileType type);
+    // -1 if c is not a tile glyph
+    int tileFromGlyph(char c);
+    // -1 if c is not a voxel glyph
+    int voxelFromGlyph(char c);
+}
+
+#endif // LEVEL_FILE_H
@@ -0,0 +1,71 @@
+#include "levelPublisher.h"
+#include <algorithm>
+#include <limits>
+
+namespace core {
+
+    LevelPublisher::LevelPublisher() :
+        m_Current(nullptr),
+        m_Epoch(1),
+        m_Readers(),
+        m_Retired(),
+        m_NumPublished(0)
+    {
+        for (ReaderSlot& slot : m_Readers) {
+            slot.epoch.store(0);
+            slot.used.store(false);
+        }
+    }
+
+    LevelPublisher::~LevelPublisher() {
+        delete m_Current.load();
+    }
+
+    void LevelPublisher::Publish(const LevelState& level) {
+        const LevelVersion* version = new LevelVersion{ level, ++m_NumPublished };
+        const LevelVersion* previous = m_Current.exchange(version);
+        // a reader that sees the new epoch loads the current version after it, so only readers
+        // of this epoch or an older one can have the previous version
+        const uint64_t epoch = m_Epoch.fetch_add(1);
+        if (previous != nullptr)
+            m_Retired.push_back({ std::unique_ptr<const LevelVersion>(previous), epoch });
+        Reclaim();
+    }
+
+    int LevelPublisher::Reclaim() {
+        uint64_t oldest = std::numeric_limits<uint64_t>::max();
+        for (const ReaderSlot& slot : m_Readers) {
+            const uint64_t epoch = slot.epoch.load();
+            if (epoch != 0)
+                oldest = std::min(oldest, epoch);
+        }
+
+        const size_t before = m_Retired.size();
+        std::erase_if(m_Retired, [oldest](const Retired& retired) {
+            return retired.epoch < oldest;
+        });
+        return (int)(before - m_Retired.size());
+    }
+
+    int LevelPublisher::RegisterReader() {
+        for (int i = 0; i < maxReaders; i++) {
+            bool expected = false;
+            if (m_Readers[i].used.compare_exchange_strong(expected, true))
+                return i;
+        }
+        return -1;
+    }
+
+    void LevelPublisher::UnregisterReader(int reader) {
+        m_Readers[reader].epoch.store(0);
+        m_Readers[reader].used.store(false);
+    }
+
+    LevelPublisher::ReadGuard LevelPublisher::Read(int reader) {
+        // both sequentially consistent: the epoch has to be visible before the version is loaded
+        std::atomic<uint64_t>& epoch = m_Readers[reader].epoch;
+        epoch.store(m_Epoch.load());
+        return ReadGuard(&epoch, m_Current.load());
+    }
+
+}
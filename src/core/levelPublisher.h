@@ -0,0 +1,118 @@
+#ifndef LEVEL_PUBLISHER_H
+#define LEVEL_PUBLISHER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "levelState.h"
+
+namespace core {
+    // a published level, never changed afterwards
+    struct LevelVersion {
+        LevelState level;
+        uint64_t number; // 1 for the first one published
+    };
+
+    /*
+        Hands immutable versions of the level from the thread that edits it to background
+        readers (solvers, autosave, thumbnails), read-copy-update style.
+
+        Publish() copies the level, which only copies chunk pointers (see TileGrid), and
+        swaps it in as the current version with one atomic exchange. A reader announces
+        the epoch it starts in, in a slot of its own, and then loads the current version,
+        so neither side ever takes a lock or waits for the other: readers keep using
+        whatever version they got while newer ones are published. A version that was
+        replaced is retired with the epoch it was replaced in and freed by the publishing
+        thread once every reader that could still see it has moved on (epoch based
+        reclamation), which a Publish() checks at the cost of one load per reader slot.
+    */
+    class LevelPublisher {
+    public:
+        static constexpr int maxReaders = 64;
+
+        // the version a Read() got, valid until the guard is gone
+        class ReadGuard {
+        public:
+            ReadGuard(std::atomic<uint64_t>* epoch, const LevelVersion* version) :
+                m_Epoch(epoch),
+                m_Version(version)
+            { }
+
+            ~ReadGuard() {
+                if (m_Epoch != nullptr)
+                    m_Epoch->store(0, std::memory_order_release);
+            }
+
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard& operator=(const ReadGuard&) = delete;
+
+            ReadGuard(ReadGuard&& other) noexcept :
+                m_Epoch(other.m_Epoch),
+                m_Version(other.m_Version)
+            {
+                other.m_Epoch = nullptr;
+            }
+
+            // null before the first Publish()
+            inline const LevelVersion* Get() const {
+                return m_Version;
+            }
+
+            inline const LevelVersion* operator->() const {
+                return m_Version;
+            }
+
+        private:
+            std::atomic<uint64_t>* m_Epoch;
+            const LevelVersion* m_Version;
+        };
+
+        LevelPublisher();
+        // every reader has to be unregistered by then
+        ~LevelPublisher();
+
+        LevelPublisher(const LevelPublisher&) = delete;
+        LevelPublisher& operator=(const LevelPublisher&) = delete;
+
+        // publishing side, one thread only
+        void Publish(const LevelState& level);
+        // frees the retired versions no reader can see anymore, returns how many. Publish() calls it too
+        int Reclaim();
+
+        inline uint64_t GetNumPublished() const {
+            return m_NumPublished;
+        }
+
+        // replaced versions a reader may still be using
+        inline int GetNumRetired() const {
+            return (int)m_Retired.size();
+        }
+
+        // reading side, any thread. Every reading thread takes a slot, -1 if they are all taken
+        int RegisterReader();
+        void UnregisterReader(int reader);
+        // one guard per reader at a time
+        ReadGuard Read(int reader);
+
+    private:
+        struct alignas(64) ReaderSlot {
+            std::atomic<uint64_t> epoch; // 0 while not reading
+            std::atomic<bool> used;
+        };
+
+        struct Retired {
+            std::unique_ptr<const LevelVersion> version;
+            uint64_t epoch; // readers that started in a later one can't have it
+        };
+
+        std::atomic<const LevelVersion*> m_Current;
+        std::atomic<uint64_t> m_Epoch;
+        std::array<ReaderSlot, maxReaders> m_Readers;
+        std::vector<Retired> m_Retired;
+        uint64_t m_NumPublished;
+    };
+}
+
+#endif // LEVEL_PUBLISHER_H
@@ -0,0 +1,59 @@
+#ifndef LEVEL_STATE_H
+#define LEVEL_STATE_H
+
+#include <array>
+#include <cstdint>
+#include "tileGrid.h"
+#include "voxelGrid.h"
+
+// plain game data shared by the headless core, the game and the editor.
+// nothing in here is allowed to depend on SDL, OpenGL or glm.
+
+enum class Rotation {
+    DOWN,
+    UP,
+    LEFT,
+    RIGHT
+};
+
+enum class Orientation {
+    UP,
+    FRONT,
+    DOWN,
+    BACK,
+    LEFT,
+    RIGHT
+};
+
+enum class Face {
+    U, F, D, B, L, R
+};
+
+struct TilePos {
+    int x;
+    int z;
+};
+
+// position and orientation of the cube, see cubePose.h for the orientation tables
+struct CubePose {
+    int16_t x; // tile coords, the grid is centered around (0, 0)
+    int16_t z;
+    uint8_t orientation; // 5 bits used, one of the 24 cube orientations
+};
+
+constexpr bool operator==(const CubePose& a, const CubePose& b) {
+    return a.x == b.x && a.z == b.z && a.orientation == b.orientation;
+}
+
+// exact and cheap to hash, used as a key by anything that searches over poses
+constexpr uint64_t packPose(const CubePose& pose) {
+    return (uint64_t)(uint16_t)pose.x << 21 | (uint64_t)(uint16_t)pose.z << 5 | pose.orientation;
+}
+
+struct LevelState {
+    TileGrid tiles;
+    CubePose player; // always inside the grid, the rules rely on it
+    VoxelGrid voxels; // same side length as the tiles
+};
+
+#endif // LEVEL_STATE_H
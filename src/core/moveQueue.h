@@ -0,0 +1,87 @@
+#ifndef MOVE_QUEUE_H
+#define MOVE_QUEUE_H
+
+#include <array>
+#include <algorithm>
+#include "levelState.h"
+
+namespace core {
+    struct QueuedMove {
+        Rotation rotation;
+        double pressTime; // seconds, same clock the caller uses to start the roll
+    };
+
+    // Fixed size ring buffer of the rolls requested while the cube is still rolling.
+    // Small on purpose: buffering more than a few moves ahead feels like input lag.
+    class MoveQueue {
+    public:
+        static constexpr int capacity = 4;
+
+        MoveQueue() :
+            m_Moves{},
+            m_Head(0),
+            m_Size(0)
+        { }
+
+        inline bool Push(const QueuedMove& move) {
+            if (m_Size == capacity)
+                return false;
+            m_Moves[(m_Head + m_Size) % capacity] = move;
+            m_Size++;
+            return true;
+        }
+
+        inline bool Pop(QueuedMove& move) {
+            if (m_Size == 0)
+                return false;
+            move = m_Moves[m_Head];
+            m_Head = (m_Head + 1) % capacity;
+            m_Size--;
+            return true;
+        }
+
+        inline void Clear() {
+            m_Head = 0;
+            m_Size = 0;
+        }
+
+        // i = 0 is the next move to be played
+        inline const QueuedMove& Get(int i) const {
+            return m_Moves[(m_Head + i) % capacity];
+        }
+
+        inline int Size() const {
+            return m_Size;
+        }
+
+        inline bool Empty() const {
+            return m_Size == 0;
+        }
+
+    private:
+        std::array<QueuedMove, capacity> m_Moves;
+        int m_Head;
+        int m_Size;
+    };
+
+    // time between a key press and the cube actually starting to roll, in seconds
+    struct LatencyStats {
+        double last;
+        double max;
+        double total;
+        int count;
+
+        inline void Add(double latency) {
+            last = latency;
+            max = std::max(max, latency);
+            total += latency;
+            count++;
+        }
+
+        inline double Average() const {
+            return count > 0 ? total / count : 0.0;
+        }
+    };
+}
+
+#endif // MOVE_QUEUE_H
@@ -0,0 +1,314 @@
+#include "solver.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <utility>
+#include "threadPool.h"
+#ifdef __unix__
+#include <sys/mman.h>
+#endif
+
+namespace core {
+
+    /*
+        Zeroed array straight from the OS. Untouched pages are never backed by memory,
+        so the arrays can be reserved for the most states a search may ever keep and
+        only cost what it actually stores.
+    */
+    template <typename T>
+    class MappedArray {
+    public:
+        MappedArray() :
+            m_Data(nullptr),
+            m_Bytes(0)
+        { }
+
+        MappedArray(size_t count, bool hugePages) :
+            m_Data(nullptr),
+            m_Bytes(std::max<size_t>(count * sizeof(T), 1))
+        {
+#ifdef __unix__
+#ifdef MAP_HUGETLB
+            // explicit huge pages only exist if the admin set enough aside, otherwise ask for transparent
+            // ones. They have to be reserved up front, without that touching a page that isn't there is a SIGBUS
+            static constexpr size_t hugePageSize = 2 * 1024 * 1024;
+            if (hugePages) {
+                const size_t bytes = (m_Bytes + hugePageSize - 1) & ~(hugePageSize - 1);
+                void* data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (data != MAP_FAILED) {
+                    m_Data = static_cast<T*>(data);
+                    m_Bytes = bytes;
+                    return;
+                }
+            }
+#endif
+            void* data = mmap(nullptr, m_Bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (data == MAP_FAILED)
+                throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+            if (hugePages)
+                madvise(data, m_Bytes, MADV_HUGEPAGE);
+#endif
+            m_Data = static_cast<T*>(data);
+#else
+            (void)hugePages;
+            m_Data = static_cast<T*>(std::calloc(m_Bytes, 1));
+            if (m_Data == nullptr)
+                throw std::bad_alloc();
+#endif
+        }
+
+        ~MappedArray() {
+            if (m_Data == nullptr)
+                return;
+#ifdef __unix__
+            munmap(m_Data, m_Bytes);
+#else
+            std::free(m_Data);
+#endif
+        }
+
+        MappedArray(const MappedArray&) = delete;
+        MappedArray& operator=(const MappedArray&) = delete;
+
+        MappedArray& operator=(MappedArray&& other) noexcept {
+            std::swap(m_Data, other.m_Data);
+            std::swap(m_Bytes, other.m_Bytes);
+            return *this;
+        }
+
+        inline T* Data() const {
+            return m_Data;
+        }
+
+        inline T& operator[](size_t ix) const {
+            return m_Data[ix];
+        }
+
+    private:
+        T* m_Data;
+        size_t m_Bytes;
+    };
+
+    static constexpr uint64_t tagMask = 0xFFFFFFFF00000000ull;
+
+    /*
+        The shared visited table: like StateSet's, 32 bits of the hash and the state's
+        number + 1 per slot, only here a slot is claimed with a compare and swap. The
+        state, its hash and its parent are written before the slot is, so whoever sees
+        the slot also sees them.
+    */
+    class VisitedTable {
+    public:
+        VisitedTable(size_t numSlots, bool hugePages) :
+            m_Slots(numSlots, hugePages),
+            m_NumSlots(numSlots),
+            m_HugePages(hugePages)
+        { }
+
+        // -1 if the state (already stored as number ix) is new, else the number it had before
+        int64_t Insert(const uint64_t* states, int numWords, uint64_t hash, int64_t ix) {
+            const uint64_t* state = states + ix * numWords;
+            const uint64_t tag = hash & tagMask;
+            const uint64_t mask = m_NumSlots - 1;
+            for (uint64_t slot = hash & mask;; slot = (slot + 1) & mask) {
+                std::atomic_ref<uint64_t> entryRef(m_Slots[slot]);
+                uint64_t entry = entryRef.load(std::memory_order_acquire);
+                if (entry == 0 && entryRef.compare_exchange_strong(entry, tag | (uint64_t)(ix + 1),
+                            std::memory_order_acq_rel, std::memory_order_acquire))
+                    return -1;
+                // a failed compare and swap left the winner's entry in entry
+                if ((entry & tagMask) == tag) {
+                    const int64_t other = (int64_t)(entry & ~tagMask) - 1;
+                    if (std::equal(state, state + numWords, states + other * numWords))
+                        return other;
+                }
+            }
+        }
+
+        // into a new table of numSlots, the states are known to be different so nothing is compared
+        void Grow(size_t numSlots, const uint64_t* hashes, ThreadPool& pool) {
+            VisitedTable bigger(numSlots, m_HugePages);
+            const uint64_t mask = numSlots - 1;
+            pool.ParallelFor((int)((m_NumSlots + 4095) >> 12), 1, [&](int begin, int end) {
+                const size_t last = std::min((size_t)end << 12, m_NumSlots);
+                for (size_t old = (size_t)begin << 12; old < last; old++) {
+                    const uint64_t entry = m_Slots[old];
+                    if (entry == 0)
+                        continue;
+                    for (uint64_t slot = hashes[(entry & ~tagMask) - 1] & mask;; slot = (slot + 1) & mask) {
+                        uint64_t empty = 0;
+                        if (std::atomic_ref<uint64_t>(bigger.m_Slots[slot]).compare_exchange_strong(empty, entry,
+                                    std::memory_order_relaxed))
+                            break;
+                    }
+                }
+            });
+            m_Slots = std::move(bigger.m_Slots);
+            m_NumSlots = numSlots;
+        }
+
+        inline size_t GetNumSlots() const {
+            return m_NumSlots;
+        }
+
+    private:
+        MappedArray<uint64_t> m_Slots;
+        size_t m_NumSlots; // a power of 2
+        bool m_HugePages;
+    };
+
+    // a thread takes state numbers this many at a time, and layers in chunks of at least this many states
+    static constexpr int64_t numberBatch = 4096;
+    static constexpr int64_t minChunk = 256;
+
+    struct SearchThread {
+        std::vector<uint32_t> next; // its part of the next layer
+        int64_t nextNumber; // [nextNumber, endNumber) are reserved for it
+        int64_t endNumber;
+        int64_t expanded;
+        int64_t added;
+    };
+
+    SolveResult solveParallel(const LevelState& level, const SolveOptions& options) {
+        return solveParallel(StateSpace(level), options);
+    }
+
+    SolveResult solveParallel(const StateSpace& space, const SolveOptions& options) {
+        const auto start = std::chrono::steady_clock::now();
+        const int numWords = space.GetNumWords();
+        const int numThreads = options.numThreads > 0 ? options.numThreads :
+            std::max(1, (int)std::thread::hardware_concurrency());
+        SolveResult result = { SolveStatus::UNSOLVABLE, {}, 0, 1, 0, 0.0 };
+
+        // numbers and parents are 32 bits, 0xFFFFFFFF stays free like in StateSet
+        const int64_t maxStates = std::clamp<int64_t>(options.maxStates, 1, UINT32_MAX - numThreads * numberBatch - 1);
+        const size_t capacity = (size_t)(maxStates + numThreads * numberBatch);
+        MappedArray<uint64_t> states(capacity * numWords, options.hugePages);
+        MappedArray<uint64_t> hashes(capacity, options.hugePages);
+        MappedArray<uint32_t> parent(capacity, options.hugePages);
+        MappedArray<uint8_t> moveTo(capacity, false);
+        VisitedTable visited(std::max<size_t>(4096,
+                    std::bit_ceil((size_t)std::max<int64_t>(std::min(options.expectedStates, maxStates), 1) * 2)),
+                options.hugePages);
+
+        std::copy_n(space.GetStart(), numWords, states.Data());
+        hashes[0] = space.Hash(space.GetStart());
+        visited.Insert(states.Data(), numWords, hashes[0], 0);
+        std::atomic<int64_t> found = space.IsGoal(space.GetStart()) ? 0 : -1;
+        std::atomic<int64_t> nextFree = 1;
+        std::atomic<int64_t> numAdded = 1; // what maxStates counts, the reserved numbers run ahead of it
+        std::atomic<bool> gaveUp = false;
+
+        ThreadPool pool(numThreads);
+        std::vector<SearchThread> threads(numThreads, SearchThread{ {}, 0, 0, 0, 0 });
+        std::vector<uint32_t> layer = { 0 };
+        int64_t numVisited = 1;
+        while (space.HasGoal() && found == -1 && !gaveUp && !layer.empty()) {
+            // every state of the layer can add at most numRotations new ones, and the table stays under half full
+            const int64_t mostStates = std::min<int64_t>(numVisited + numRotations * (int64_t)layer.size(), capacity);
+            if ((size_t)mostStates * 2 > visited.GetNumSlots())
+                visited.Grow(std::bit_ceil((size_t)mostStates * 2), hashes.Data(), pool);
+
+            const int64_t chunk = std::max<int64_t>(minChunk, (int64_t)layer.size() / (numThreads * 16));
+            std::atomic<int64_t> cursor = 0;
+            pool.ParallelFor(numThreads, 1, [&](int begin, int end) {
+                for (int t = begin; t < end; t++) {
+                    SearchThread& thread = threads[t];
+                    thread.next.clear();
+                    std::vector<uint64_t> successors(numRotations * numWords);
+                    uint64_t* out = successors.data();
+                    std::array<uint64_t, numRotations> successorHashes;
+                    std::array<Rotation, numRotations> moves;
+
+                    while (found.load(std::memory_order_relaxed) == -1 && !gaveUp.load(std::memory_order_relaxed)) {
+                        const int64_t first = cursor.fetch_add(chunk, std::memory_order_relaxed);
+                        if (first >= (int64_t)layer.size())
+                            break;
+                        const int64_t last = std::min(first + chunk, (int64_t)layer.size());
+                        for (int64_t i = first; i < last; i++) {
+                            const uint32_t ix = layer[i];
+                            const int count = space.Expand(states.Data() + (size_t)ix * numWords, out, moves.data(),
+                                    hashes[ix], successorHashes.data());
+                            thread.expanded++;
+                            for (int s = 0; s < count; s++) {
+                                if (thread.nextNumber == thread.endNumber) {
+                                    // no more than fits, the numbers threads hold on to unused can't add up past that
+                                    int64_t first = nextFree.load(std::memory_order_relaxed);
+                                    int64_t count;
+                                    do {
+                                        count = std::min<int64_t>(numberBatch, (int64_t)capacity - first);
+                                    } while (count > 0 && !nextFree.compare_exchange_weak(first, first + count,
+                                                std::memory_order_relaxed));
+                                    if (count <= 0) {
+                                        gaveUp = true;
+                                        break;
+                                    }
+                                    thread.nextNumber = first;
+                                    thread.endNumber = first + count;
+                                }
+                                // written to the next free number first, it only is that state's if it turns out new
+                                const int64_t number = thread.nextNumber;
+                                std::copy_n(out + s * numWords, numWords, states.Data() + number * numWords);
+                                hashes[number] = successorHashes[s];
+                                parent[number] = ix;
+                                moveTo[number] = (uint8_t)moves[s];
+                                if (visited.Insert(states.Data(), numWords, successorHashes[s], number) != -1)
+                                    continue;
+                                // like solveBfs(), a new state past the limit ends the search before it counts
+                                if (numAdded.fetch_add(1, std::memory_order_relaxed) >= maxStates) {
+                                    gaveUp = true;
+                                    break;
+                                }
+                                thread.nextNumber++;
+                                thread.added++;
+                                thread.next.push_back((uint32_t)number);
+                                if (space.IsGoal(out + s * numWords)) {
+                                    int64_t none = -1;
+                                    found.compare_exchange_strong(none, number);
+                                }
+                            }
+                            if (gaveUp.load(std::memory_order_relaxed))
+                                break;
+                        }
+                    }
+                }
+            });
+
+            // the next layer is the threads' buffers one after the other
+            std::vector<size_t> offsets(numThreads + 1, 0);
+            for (int t = 0; t < numThreads; t++)
+                offsets[t + 1] = offsets[t] + threads[t].next.size();
+            layer.resize(offsets[numThreads]);
+            pool.ParallelFor(numThreads, 1, [&](int begin, int end) {
+                for (int t = begin; t < end; t++)
+                    std::copy(threads[t].next.begin(), threads[t].next.end(), layer.begin() + offsets[t]);
+            });
+            numVisited = 1;
+            for (const SearchThread& thread : threads)
+                numVisited += thread.added;
+            result.depth += !layer.empty();
+        }
+
+        if (found != -1) {
+            result.status = SolveStatus::SOLVED;
+            for (int64_t ix = found; ix != 0; ix = parent[ix])
+                result.moves.push_back(static_cast<Rotation>(moveTo[ix]));
+            std::reverse(result.moves.begin(), result.moves.end());
+        } else if (gaveUp) {
+            result.status = SolveStatus::GAVE_UP;
+        }
+        for (const SearchThread& thread : threads)
+            result.expanded += thread.expanded;
+        result.visited = numVisited;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+}
@@ -0,0 +1,75 @@
+#include "patternDatabase.h"
+#include <algorithm>
+#include <bit>
+
+namespace core {
+
+    PatternDatabase::PatternDatabase(const StateSpace& space, int64_t maxEntries) :
+        m_Space(&space),
+        m_NumPoses(space.GetNumPoses())
+    {
+        std::vector<uint8_t> goal(m_NumPoses);
+        std::vector<int> queue;
+        if (space.HasTargets()) {
+            for (int pose = 0; pose < m_NumPoses; pose++)
+                goal[pose] = space.IsTarget(pose / numOrientations);
+            m_TargetDistance.resize(m_NumPoses);
+            DistancesTo(goal, m_TargetDistance.data(), queue);
+        }
+
+        if ((int64_t)space.GetNumToggles() * m_NumPoses > maxEntries)
+            return;
+        m_LightDistance.resize((size_t)space.GetNumToggles() * m_NumPoses);
+        for (int toggle = 0; toggle < space.GetNumToggles(); toggle++) {
+            std::fill(goal.begin(), goal.end(), 0);
+            const int cell = space.GetToggleCell(toggle);
+            for (int o = 0; o < numOrientations; o++)
+                goal[cell * numOrientations + o] = StateSpace::LightsUp(o);
+            DistancesTo(goal, m_LightDistance.data() + (size_t)toggle * m_NumPoses, queue);
+        }
+    }
+
+    void PatternDatabase::DistancesTo(const std::vector<uint8_t>& goal, uint16_t* distance, std::vector<int>& queue) const {
+        std::fill(distance, distance + m_NumPoses, (uint16_t)unreachable);
+        queue.clear();
+        for (int pose = 0; pose < m_NumPoses; pose++) {
+            if (goal[pose]) {
+                distance[pose] = 0;
+                queue.push_back(pose);
+            }
+        }
+        for (size_t head = 0; head < queue.size(); head++) {
+            const int pose = queue[head];
+            const uint16_t next = (uint16_t)std::min(distance[pose] + 1, unreachable - 1);
+            for (int r = 0; r < numRotations; r++) {
+                const int previous = m_Space->Unroll(pose, static_cast<Rotation>(r));
+                if (previous != -1 && distance[previous] == unreachable) {
+                    distance[previous] = next;
+                    queue.push_back(previous);
+                }
+            }
+        }
+    }
+
+    int PatternDatabase::Estimate(const uint64_t* state) const {
+        const int pose = m_Space->PoseOf(state);
+        int estimate = m_TargetDistance.empty() ? 0 : m_TargetDistance[pose];
+        const uint64_t* toggleMask = m_Space->GetToggleMask();
+        const int poseBits = m_Space->GetPoseBits();
+        // a roll lights one tile at most, so there are at least as many rolls left as dark tiles
+        int numDark = 0;
+        for (int w = 0; w < m_Space->GetNumWords(); w++) {
+            uint64_t dark = ~state[w] & toggleMask[w];
+            numDark += std::popcount(dark);
+            if (m_LightDistance.empty())
+                continue;
+            while (dark != 0) {
+                const int toggle = w * 64 + std::countr_zero(dark) - poseBits;
+                estimate = std::max(estimate, (int)m_LightDistance[(size_t)toggle * m_NumPoses + pose]);
+                dark &= dark - 1;
+            }
+        }
+        return std::max(estimate, numDark);
+    }
+
+}
@@ -0,0 +1,56 @@
+#ifndef PATTERN_DATABASE_H
+#define PATTERN_DATABASE_H
+
+#include <cstdint>
+#include <vector>
+#include "stateSpace.h"
+
+namespace core {
+    /*
+        Lower bounds on the rolls left to solve a level, looked up instead of searched.
+
+        Toggles aside, the cube moves over a small graph: the reachable cells times the 24
+        orientations. A backward BFS over it, rolling poses back with StateSpace::Unroll(),
+        gives the fewest rolls from every pose to a set of goal poses. The database keeps
+        one such table for the targets (any pose on a target) and one per toggle (the poses
+        on it with a face down that lights it up). A dark toggle still has to be lit and
+        the cube has to end on a target, whatever the other tiles do, so the largest of the
+        distances that apply to a state is a bound, and so is the number of dark toggles,
+        as a roll lights one at most. The larger of the two never overestimates and never
+        drops by more than one per roll: A* with it needs no reopening of closed states.
+
+        A dark toggle that no pose can light from where the cube is makes the state a dead
+        end, Estimate() says unreachable and the search can drop it.
+
+        It keeps a pointer to the StateSpace, which has to outlive it.
+    */
+    class PatternDatabase {
+    public:
+        static constexpr int unreachable = 0xFFFF;
+
+        // skips the per toggle tables if they would need more than maxEntries distances
+        explicit PatternDatabase(const StateSpace& space, int64_t maxEntries = int64_t(1) << 26);
+
+        // at most the number of rolls to a goal state, unreachable if there is no way there
+        int Estimate(const uint64_t* state) const;
+
+        inline bool HasToggleTables() const {
+            return !m_LightDistance.empty();
+        }
+
+        inline size_t GetNumBytes() const {
+            return (m_TargetDistance.size() + m_LightDistance.size()) * sizeof(uint16_t);
+        }
+
+    private:
+        // fewest rolls from every pose to any with goal[pose] set, into distance (GetNumPoses() entries)
+        void DistancesTo(const std::vector<uint8_t>& goal, uint16_t* distance, std::vector<int>& queue) const;
+
+        const StateSpace* m_Space;
+        int m_NumPoses;
+        std::vector<uint16_t> m_TargetDistance; // per pose, empty without targets
+        std::vector<uint16_t> m_LightDistance; // per toggle * GetNumPoses() + pose
+    };
+}
+
+#endif // PATTERN_DATABASE_H
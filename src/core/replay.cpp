@@ -0,0 +1,279 @@
+#include "replay.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+/*
+    File layout, everything little endian:
+
+    header      "RPLY", version, level hash, side length, checkpoint interval,
+                number of moves, number of checkpoints
+    moves       (numMoves + 3) / 4 bytes, 2 bits per roll
+    index       (move, file offset) of every checkpoint
+    checkpoints player pose, number of chunks, then every chunk with a tile in it as its
+                index and its cells in row major order, like a chunk file
+*/
+
+static constexpr char replayMagic[4] = { 'R', 'P', 'L', 'Y' };
+static constexpr uint32_t replayVersion = 2;
+
+template<typename T>
+static void write(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+static bool read(std::ifstream& in, T& value) {
+    return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+namespace core {
+
+    uint64_t hashLevel(const LevelState& state) {
+        // one multiply per 8 tiles. Chunks without a tile in them are skipped whether they
+        // are allocated or not, so equal levels hash the same however they were edited
+        uint64_t hash = 0xcbf29ce484222325ull;
+        auto add = [&hash](uint64_t value) {
+            hash = (hash ^ value) * 0x100000001b3ull;
+            hash ^= hash >> 29;
+        };
+
+        add(state.tiles.GetSideLength());
+        add(packPose(state.player));
+        for (int chunkIx = 0; chunkIx < state.tiles.GetNumChunks(); chunkIx++) {
+            const TileChunk* chunk = state.tiles.GetChunk(chunkIx);
+            if (chunk == nullptr || chunk->numOccupied == 0)
+                continue;
+            add(chunkIx);
+            for (int i = 0; i < TileChunk::numCells; i += 8) {
+                uint64_t word;
+                std::memcpy(&word, chunk->cells.data() + i, sizeof(word));
+                add(word);
+            }
+        }
+        // walls change which rolls are legal, a level with them is another level
+        for (int chunkIx = 0; chunkIx < state.voxels.GetNumChunks(); chunkIx++) {
+            const VoxelChunk* chunk = state.voxels.GetChunk(chunkIx);
+            if (chunk == nullptr || chunk->numSolid == 0)
+                continue;
+            add(~(uint64_t)chunkIx);
+            for (int i = 0; i < VoxelChunk::numCells; i += 8) {
+                uint64_t word;
+                std::memcpy(&word, chunk->cells.data() + i, sizeof(word));
+                add(word);
+            }
+        }
+        return hash;
+    }
+
+    ReplayRecorder::ReplayRecorder() :
+        m_Start(makeLevelState(1)),
+        m_LevelHash(0),
+        m_Moves(),
+        m_Cursor(0),
+        m_Size(0)
+    {
+    }
+
+    void ReplayRecorder::Start(const LevelState& level) {
+        m_Start = level;
+        m_LevelHash = hashLevel(level);
+        m_Moves.clear();
+        m_Cursor = 0;
+        m_Size = 0;
+    }
+
+    void ReplayRecorder::Record(Rotation rotation) {
+        if (m_Cursor % 4 == 0) {
+            m_Moves.resize(m_Cursor / 4 + 1);
+            m_Moves.back() = 0;
+        }
+        m_Moves[m_Cursor / 4] &= (uint8_t)~(3 << (m_Cursor % 4 * 2));
+        m_Moves[m_Cursor / 4] |= (uint8_t)((int)rotation << (m_Cursor % 4 * 2));
+        m_Cursor++;
+        m_Size = m_Cursor;
+    }
+
+    void ReplayRecorder::Undo() {
+        if (m_Cursor > 0)
+            m_Cursor--;
+    }
+
+    void ReplayRecorder::Redo() {
+        if (m_Cursor < m_Size)
+            m_Cursor++;
+    }
+
+    bool ReplayRecorder::Save(const std::string& path, int checkpointInterval) const {
+        std::ofstream out(path, std::ios::binary);
+        if (!out)
+            return false;
+
+        const int sideLength = m_Start.tiles.GetSideLength();
+        const int64_t numMoves = m_Cursor;
+        const int64_t numCheckpoints = numMoves / checkpointInterval + 1;
+        const int64_t movesBytes = (numMoves + 3) / 4;
+
+        out.write(replayMagic, sizeof(replayMagic));
+        write(out, replayVersion);
+        write(out, m_LevelHash);
+        write(out, (int32_t)sideLength);
+        write(out, (int32_t)checkpointInterval);
+        write(out, numMoves);
+        write(out, numCheckpoints);
+        out.write(reinterpret_cast<const char*>(m_Moves.data()), movesBytes);
+
+        // checkpoints differ in size, the index is filled in once they are written
+        const std::streamoff indexStart = out.tellp();
+        for (int64_t i = 0; i < numCheckpoints; i++) {
+            write(out, i * checkpointInterval);
+            write(out, (uint64_t)0);
+        }
+
+        // the checkpoints are rebuilt by playing the session again
+        LevelState state = m_Start;
+        std::vector<uint64_t> offsets;
+        std::array<uint8_t, TileChunk::numCells> cells;
+        for (int64_t move = 0; move <= numMoves; move++) {
+            if (move % checkpointInterval == 0) {
+                offsets.push_back((uint64_t)out.tellp());
+                write(out, state.player.x);
+                write(out, state.player.z);
+                write(out, state.player.orientation);
+                // chunks without a tile are left out, they read as empty
+                const TileGrid& tiles = state.tiles;
+                int32_t numChunks = 0;
+                for (int chunkIx = 0; chunkIx < tiles.GetNumChunks(); chunkIx++) {
+                    const TileChunk* chunk = tiles.GetChunk(chunkIx);
+                    numChunks += chunk != nullptr && chunk->numOccupied != 0;
+                }
+                write(out, numChunks);
+                for (int chunkIx = 0; chunkIx < tiles.GetNumChunks(); chunkIx++) {
+                    const TileChunk* chunk = tiles.GetChunk(chunkIx);
+                    if (chunk == nullptr || chunk->numOccupied == 0)
+                        continue;
+                    write(out, (int32_t)chunkIx);
+                    TileGrid::PackChunk(*chunk, cells.data());
+                    out.write(reinterpret_cast<const char*>(cells.data()), cells.size());
+                }
+            }
+            if (move < numMoves)
+                step(state, static_cast<Rotation>((m_Moves[move / 4] >> (move % 4 * 2)) & 3));
+        }
+
+        out.seekp(indexStart);
+        for (int64_t i = 0; i < numCheckpoints; i++) {
+            write(out, i * checkpointInterval);
+            write(out, offsets[i]);
+        }
+        return (bool)out;
+    }
+
+    Replay::Replay() :
+        m_File(),
+        m_LevelHash(0),
+        m_SideLength(0),
+        m_CheckpointInterval(1),
+        m_NumMoves(0),
+        m_Cursor(0),
+        m_Synced(false),
+        m_Moves(),
+        m_Index()
+    {
+    }
+
+    bool Replay::Open(const std::string& path) {
+        m_File.close();
+        m_File.open(path, std::ios::binary);
+        if (!m_File)
+            return false;
+
+        char magic[4];
+        uint32_t version;
+        int32_t sideLength, checkpointInterval;
+        int64_t numMoves, numCheckpoints;
+        bool ok = m_File.read(magic, sizeof(magic)) && read(m_File, version) && read(m_File, m_LevelHash) &&
+            read(m_File, sideLength) && read(m_File, checkpointInterval) &&
+            read(m_File, numMoves) && read(m_File, numCheckpoints);
+        if (!ok || std::memcmp(magic, replayMagic, sizeof(magic)) != 0 || version != replayVersion ||
+                sideLength <= 0 || checkpointInterval <= 0 || numMoves < 0 ||
+                numCheckpoints != numMoves / checkpointInterval + 1) {
+            m_File.close();
+            return false;
+        }
+
+        m_SideLength = sideLength;
+        m_CheckpointInterval = checkpointInterval;
+        m_NumMoves = numMoves;
+        m_Cursor = 0;
+        m_Synced = false;
+        m_Moves.resize((numMoves + 3) / 4);
+        m_Index.resize(numCheckpoints);
+        m_File.read(reinterpret_cast<char*>(m_Moves.data()), m_Moves.size());
+        m_File.read(reinterpret_cast<char*>(m_Index.data()), m_Index.size() * sizeof(IndexEntry));
+        if (!m_File) {
+            m_File.close();
+            return false;
+        }
+        return true;
+    }
+
+    void Replay::Seek(LevelState& state, int64_t move) {
+        move = std::clamp<int64_t>(move, 0, m_NumMoves);
+
+        // keep stepping from where the state is, unless a checkpoint is closer
+        const int ix = (int)(move / m_CheckpointInterval);
+        if (!m_Synced || move < m_Cursor || m_Index[ix].move > m_Cursor)
+            ReadCheckpoint(ix, state);
+
+        while (m_Cursor < move)
+            Next(state);
+    }
+
+    StepResult Replay::Next(LevelState& state) {
+        return step(state, GetMove(m_Cursor++));
+    }
+
+    void Replay::ReadCheckpoint(int ix, LevelState& state) {
+        if (state.tiles.GetSideLength() != m_SideLength)
+            state = makeLevelState(m_SideLength);
+        else
+            state.tiles.Clear();
+
+        m_File.clear();
+        m_File.seekg(m_Index[ix].offset);
+        int32_t numChunks = 0;
+        read(m_File, state.player.x);
+        read(m_File, state.player.z);
+        read(m_File, state.player.orientation);
+        read(m_File, numChunks);
+
+        // the chunks go in whole, the counts are what they hold plus empty for the rest
+        TileGrid& tiles = state.tiles;
+        std::array<int, numTileTypes> counts = {};
+        std::array<uint8_t, TileChunk::numCells> cells;
+        TileChunk chunk;
+        for (int32_t i = 0; i < numChunks; i++) {
+            int32_t chunkIx;
+            if (!read(m_File, chunkIx) || chunkIx < 0 || chunkIx >= tiles.GetNumChunks() ||
+                    tiles.GetChunk(chunkIx) != nullptr ||
+                    !m_File.read(reinterpret_cast<char*>(cells.data()), cells.size()))
+                break;
+            if (std::any_of(cells.begin(), cells.end(), [](uint8_t type) { return type >= numTileTypes; }))
+                break;
+            TileGrid::UnpackChunk(cells.data(), chunk);
+            for (uint8_t type : chunk.cells)
+                counts[type]++;
+            tiles.InsertChunk(chunkIx, chunk);
+        }
+        int numOccupied = 0;
+        for (int t = 0; t < numTileTypes; t++)
+            numOccupied += t == (int)TileType::EMPTY_TILE ? 0 : counts[t];
+        counts[(int)TileType::EMPTY_TILE] = tiles.GetNumTiles() - numOccupied;
+        tiles.SetCounts(counts);
+
+        m_Cursor = m_Index[ix].move;
+        m_Synced = true;
+    }
+
+}
@@ -0,0 +1,120 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "levelState.h"
+#include "rules.h"
+
+namespace core {
+    // hash of the tiles, the voxels and the pose, replays are keyed by the one of their starting
+    // level. It reads the chunks as they are, so it differs between TileLayout builds
+    uint64_t hashLevel(const LevelState& state);
+
+    /*
+        Move stream of a play session, 2 bits per roll.
+
+        Only rolls that actually moved the cube are recorded, so playing the stream back
+        through core::step() from the same level lands on the same state every time.
+        Undo drops the last roll (Redo puts it back), so the stream always is the line
+        that leads to the current state.
+    */
+    class ReplayRecorder {
+    public:
+        ReplayRecorder();
+
+        void Start(const LevelState& level);
+        void Record(Rotation rotation);
+        void Undo();
+        void Redo();
+        // checkpoints every checkpointInterval rolls, they are what makes seeking cheap
+        bool Save(const std::string& path, int checkpointInterval = 65536) const;
+
+        inline int64_t GetNumMoves() const {
+            return m_Cursor;
+        }
+
+        inline uint64_t GetLevelHash() const {
+            return m_LevelHash;
+        }
+
+    private:
+        LevelState m_Start;
+        uint64_t m_LevelHash;
+        std::vector<uint8_t> m_Moves; // 4 rolls per byte
+        int64_t m_Cursor;
+        int64_t m_Size; // > m_Cursor when there are rolls to redo
+    };
+
+    /*
+        Replay file opened for playback.
+
+        The header, the move stream and the checkpoint index are read at once, the
+        checkpoints themselves stay on disk and are read when seeking next to them.
+        Checkpoint 0 is the level the session started from, so a replay plays back
+        on its own, the hash tells which level file it belongs to. Checkpoints hold no
+        voxels: walls only ever stop rolls and only rolls that moved are recorded, so
+        the stream plays back the same without them.
+    */
+    class Replay {
+    public:
+        Replay();
+
+        bool Open(const std::string& path);
+        // state ends up as it was after the given number of rolls. Afterwards only
+        // Seek() and Next() may change it, they step on from where it is
+        void Seek(LevelState& state, int64_t move);
+        // plays the next roll on state, which has to be at GetCursor() and not Done()
+        StepResult Next(LevelState& state);
+
+        inline Rotation GetMove(int64_t move) const {
+            return static_cast<Rotation>((m_Moves[move / 4] >> (move % 4 * 2)) & 3);
+        }
+
+        inline bool IsOpen() const {
+            return m_File.is_open();
+        }
+
+        inline bool Done() const {
+            return m_Cursor == m_NumMoves;
+        }
+
+        inline int64_t GetCursor() const {
+            return m_Cursor;
+        }
+
+        inline int64_t GetNumMoves() const {
+            return m_NumMoves;
+        }
+
+        inline uint64_t GetLevelHash() const {
+            return m_LevelHash;
+        }
+
+        inline int GetSideLength() const {
+            return m_SideLength;
+        }
+
+    private:
+        struct IndexEntry {
+            int64_t move;
+            uint64_t offset;
+        };
+
+        void ReadCheckpoint(int ix, LevelState& state);
+
+        std::ifstream m_File;
+        uint64_t m_LevelHash;
+        int m_SideLength;
+        int m_CheckpointInterval;
+        int64_t m_NumMoves;
+        int64_t m_Cursor;
+        bool m_Synced; // a checkpoint was read since Open()
+        std::vector<uint8_t> m_Moves;
+        std::vector<IndexEntry> m_Index;
+    };
+}
+
+#endif // REPLAY_H
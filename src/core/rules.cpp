@@ -0,0 +1,91 @@
+#include "rules.h"
+#include "tileRules.h"
+
+namespace core {
+
+    LevelState makeLevelState(int sideLength) {
+        return LevelState{
+            TileGrid(sideLength),
+            CubePose{ 0, 0, 0 },
+            VoxelGrid(sideLength)
+        };
+    }
+
+    TilePos rollTarget(TilePos pos, Rotation rotation) {
+        return { pos.x + rollDx[(int)rotation], pos.z + rollDz[(int)rotation] };
+    }
+
+    // padded bit index of the tile the cube lands on
+    static int rollIndex(const TileGrid& tiles, const CubePose& pose, Rotation rotation) {
+        return tiles.PaddedIndex(pose.x + rollDx[(int)rotation], pose.z + rollDz[(int)rotation]);
+    }
+
+    int getTileIndex(const LevelState& state, int tileX, int tileZ) {
+        return state.tiles.GetTileIndex(tileX, tileZ);
+    }
+
+    bool canMove(const LevelState& state, Rotation rotation) {
+        return canMove(state, state.player, rotation);
+    }
+
+    bool canMove(const LevelState& state, const CubePose& pose, Rotation rotation) {
+        // the empty border around the grid makes the bounds check unnecessary
+        int target = rollIndex(state.tiles, pose, rotation);
+        return canEnter(state.tiles.TypeAt(target), rotation) &&
+            !state.voxels.Blocks(pose.x + rollDx[(int)rotation], pose.z + rollDz[(int)rotation]);
+    }
+
+    CubePose rollPose(const CubePose& pose, Rotation rotation) {
+        TilePos target = rollTarget({ pose.x, pose.z }, rotation);
+        return CubePose{ (int16_t)target.x, (int16_t)target.z, nextOrientation(pose.orientation, rotation) };
+    }
+
+    CubePose unrollPose(const CubePose& pose, Rotation rotation) {
+        return CubePose{
+            (int16_t)(pose.x - rollDx[(int)rotation]),
+            (int16_t)(pose.z - rollDz[(int)rotation]),
+            prevOrientation(pose.orientation, rotation)
+        };
+    }
+
+    bool isLevelComplete(const LevelState& state) {
+        const TileGrid& tiles = state.tiles;
+        if (tiles.Count(TileType::DARK_TILE) != 0)
+            return false;
+
+        if (tiles.Count(targetTiles()) != 0) {
+            TileType under = tiles.TypeAt(tiles.PaddedIndex(state.player.x, state.player.z));
+            return tileInfo[(int)under].target;
+        }
+
+        return tiles.Count(TileType::LIGHT_TILE) != 0;
+    }
+
+    StepResult step(LevelState& state, Rotation rotation) {
+        StepResult result = {};
+        TileGrid& tiles = state.tiles;
+
+        int target = rollIndex(tiles, state.player, rotation);
+        TileType before = tiles.TypeAt(target);
+        if (!canEnter(before, rotation) ||
+                state.voxels.Blocks(state.player.x + rollDx[(int)rotation], state.player.z + rollDz[(int)rotation])) {
+            result.player = state.player;
+            return result;
+        }
+
+        state.player = rollPose(state.player, rotation);
+
+        // whatever the tile does is in its tileInfo row, keyed by the face it gets
+        TileType after = onEnter(before, downFace(state.player.orientation));
+        if (after != before) {
+            tiles.Replace(target, before, after);
+            result.changedTiles[result.numChangedTiles++] = {
+                tiles.GetTileIndex(state.player.x, state.player.z), before, after };
+        }
+
+        result.moved = true;
+        result.player = state.player;
+        return result;
+    }
+
+}
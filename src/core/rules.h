@@ -0,0 +1,50 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include "levelState.h"
+#include "cubePose.h"
+
+namespace core {
+    // a single roll can only ever change the tile the cube lands on
+    static constexpr int maxChangedTiles = 1;
+
+    // tile deltas of each roll, indexed by Rotation (DOWN, UP, LEFT, RIGHT)
+    static constexpr int rollDx[numRotations] = { 0, 0, -1, 1 };
+    static constexpr int rollDz[numRotations] = { 1, -1, 0, 0 };
+
+    struct TileChange {
+        int tileIx;
+        TileType before;
+        TileType after;
+    };
+
+    struct StepResult {
+        bool moved;
+        CubePose player;
+        int numChangedTiles;
+        std::array<TileChange, maxChangedTiles> changedTiles;
+    };
+
+    // poses are int16 tile coords centered on the grid, level files with a longer side are refused
+    static constexpr int maxLevelSide = 32767;
+
+    LevelState makeLevelState(int sideLength);
+    TilePos rollTarget(TilePos pos, Rotation rotation);
+    int getTileIndex(const LevelState& state, int tileX, int tileZ);
+    bool canMove(const LevelState& state, Rotation rotation);
+    // legality only depends on the pose, on which tiles are empty and on the walls (voxels on
+    // layer 0), tile toggles never change it, so this also works for poses the player will
+    // only reach after some queued rolls
+    bool canMove(const LevelState& state, const CubePose& pose, Rotation rotation);
+    // pose after a roll, without checking that the roll is legal
+    CubePose rollPose(const CubePose& pose, Rotation rotation);
+    // pose before a roll, the inverse of rollPose
+    CubePose unrollPose(const CubePose& pose, Rotation rotation);
+    // no dark tile left and, if the level has targets, the cube resting on one
+    bool isLevelComplete(const LevelState& state);
+    // applies one roll to the state (position, orientation and tile toggle).
+    // an illegal move leaves the state untouched and returns moved = false
+    StepResult step(LevelState& state, Rotation rotation);
+}
+
+#endif // RULES_H
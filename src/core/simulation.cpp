@@ -0,0 +1,238 @@
+#include "simulation.h"
+#include <algorithm>
+#include <cmath>
+#include "cubeSwarm.h"
+#include "rules.h"
+
+namespace core {
+
+    Simulation::Simulation(LevelState& level, const SimConfig& config) :
+        m_Level(level),
+        m_Obstacles(nullptr),
+        m_Config(config),
+        m_Queue(),
+        m_Latency{},
+        m_Undo(),
+        m_Recorder(),
+        m_Events{},
+        m_Previous{},
+        m_Current{},
+        m_RollFrom(level.player),
+        m_Rotation(Rotation::DOWN),
+        m_Rolling(false),
+        m_RollChangedTile(-1),
+        m_RollTick(0),
+        m_RollId(0),
+        m_Accumulator(0.0),
+        m_Time(0.0),
+        m_LastUpdate(0.0),
+        m_Started(false),
+        m_TickCount(0)
+    {
+        m_Recorder.Start(level);
+    }
+
+    int Simulation::Update(double now) {
+        if (!m_Started) {
+            // line the simulation clock up with the caller's, so press times can be compared
+            m_Started = true;
+            m_Time = now;
+            m_LastUpdate = now;
+            return 0;
+        }
+
+        double frameTime = now - m_LastUpdate;
+        m_LastUpdate = now;
+        if (frameTime > m_Config.maxFrameTime) {
+            // a long hitch is not worth catching up on, the dropped time is skipped for good
+            m_Time += frameTime - m_Config.maxFrameTime;
+            frameTime = m_Config.maxFrameTime;
+        }
+
+        const double step = 1.0 / m_Config.tickRate;
+        m_Accumulator += frameTime;
+        int numTicks = 0;
+        while (m_Accumulator >= step) {
+            Tick();
+            m_Accumulator -= step;
+            numTicks++;
+        }
+        return numTicks;
+    }
+
+    void Simulation::Tick() {
+        m_Previous = m_Current;
+        m_Time += 1.0 / m_Config.tickRate;
+        m_TickCount++;
+
+        if (m_Rolling && ++m_RollTick >= TicksPerRoll())
+            LandRoll();
+
+        // inputs only ever start on a tick, queued rolls run back to back
+        QueuedMove queued;
+        while (!m_Rolling && m_Queue.Pop(queued))
+            BeginRoll(queued.rotation, queued.pressTime);
+
+        m_Current = Snapshot();
+    }
+
+    void Simulation::RequestRoll(Rotation rotation, double pressTime, bool repeat) {
+        // holding a key down must not pile up rolls
+        if (repeat && (m_Rolling || !m_Queue.Empty()))
+            return;
+
+        if (m_Config.snapRolls && m_Rolling) {
+            LandRoll();
+            QueuedMove queued;
+            while (m_Queue.Pop(queued)) {
+                BeginRoll(queued.rotation, queued.pressTime);
+                LandRoll();
+            }
+            m_Current = Snapshot();
+            m_Previous = m_Current;
+        }
+
+        // the level already is the one after the current roll, play the queued rolls on top of it
+        CubePose predicted = m_Level.player;
+        for (int i = 0; i < m_Queue.Size(); i++)
+            predicted = rollPose(predicted, m_Queue.Get(i).rotation);
+
+        if (CanRoll(predicted, rotation))
+            m_Queue.Push({ rotation, pressTime });
+    }
+
+    SimEvents Simulation::TakeEvents() {
+        SimEvents events = std::move(m_Events);
+        m_Events = {};
+        return events;
+    }
+
+    RollSnapshot Simulation::GetInterpolated() const {
+        const float alpha = std::clamp(GetAlpha(), 0.0f, 1.0f);
+
+        // the previous tick ended a roll: play its last bit, its end pose is where the new state starts
+        if (m_Previous.rolling && (!m_Current.rolling || m_Previous.rollId != m_Current.rollId)) {
+            RollSnapshot snapshot = m_Previous;
+            snapshot.progress = std::lerp(m_Previous.progress, 1.0f, alpha);
+            return snapshot;
+        }
+
+        if (m_Current.rolling) {
+            RollSnapshot snapshot = m_Current;
+            float from = m_Previous.rolling ? m_Previous.progress : m_Current.progress;
+            snapshot.progress = std::lerp(from, m_Current.progress, alpha);
+            return snapshot;
+        }
+
+        return m_Current;
+    }
+
+    bool Simulation::Undo() {
+        Settle();
+        // the roll being undone is the one that landed here, its toggle is under the cube
+        const int tileIx = m_Level.tiles.GetTileIndex(m_Level.player.x, m_Level.player.z);
+        if (!m_Undo.Undo(m_Level))
+            return false;
+        if (IsBlocked()) {
+            m_Undo.Redo(m_Level);
+            return false;
+        }
+        m_Recorder.Undo();
+        m_Events.tilesChanged = true;
+        m_Events.changedTiles.push_back(tileIx);
+        m_RollFrom = m_Level.player;
+        m_Current = Snapshot();
+        m_Previous = m_Current;
+        return true;
+    }
+
+    bool Simulation::Redo() {
+        Settle();
+        if (!m_Undo.Redo(m_Level))
+            return false;
+        if (IsBlocked()) {
+            m_Undo.Undo(m_Level);
+            return false;
+        }
+        m_Recorder.Redo();
+        m_Events.tilesChanged = true;
+        m_Events.changedTiles.push_back(m_Level.tiles.GetTileIndex(m_Level.player.x, m_Level.player.z));
+        m_RollFrom = m_Level.player;
+        m_Current = Snapshot();
+        m_Previous = m_Current;
+        if (isLevelComplete(m_Level))
+            m_Events.levelCompleted = true;
+        return true;
+    }
+
+    void Simulation::ResetHistory() {
+        Settle();
+        m_Undo.Clear();
+        m_Recorder.Start(m_Level);
+        m_RollFrom = m_Level.player;
+        m_Current = Snapshot();
+        m_Previous = m_Current;
+    }
+
+    bool Simulation::CanRoll(const CubePose& pose, Rotation rotation) const {
+        return canMove(m_Level, pose, rotation) && (m_Obstacles == nullptr ||
+            !m_Obstacles->IsOccupied(m_Level, pose.x + rollDx[(int)rotation], pose.z + rollDz[(int)rotation]));
+    }
+
+    // the swarm moves on its own, a pose from the history can have a cube on it by now
+    bool Simulation::IsBlocked() const {
+        return m_Obstacles != nullptr && m_Obstacles->IsOccupied(m_Level, m_Level.player.x, m_Level.player.z);
+    }
+
+    void Simulation::BeginRoll(Rotation rotation, double pressTime) {
+        CubePose from = m_Level.player;
+        // the obstacles can have moved in the way since the roll was queued
+        if (m_Obstacles != nullptr && !CanRoll(from, rotation))
+            return;
+        StepResult result = m_Undo.Step(m_Level, rotation);
+        if (!result.moved)
+            return;
+        m_Recorder.Record(rotation);
+
+        m_Rolling = true;
+        m_RollFrom = from;
+        m_Rotation = rotation;
+        m_RollTick = 0;
+        m_RollId++;
+        m_RollChangedTile = result.numChangedTiles > 0 ? result.changedTiles[0].tileIx : -1;
+        m_Latency.Add(std::max(0.0, m_Time - pressTime));
+    }
+
+    void Simulation::LandRoll() {
+        m_Rolling = false;
+        // the tile toggle was already applied by step(), it only shows once the roll lands
+        if (m_RollChangedTile != -1) {
+            m_Events.tilesChanged = true;
+            m_Events.changedTiles.push_back(m_RollChangedTile);
+        }
+        if (isLevelComplete(m_Level))
+            m_Events.levelCompleted = true;
+    }
+
+    // lands the current roll and forgets the queued ones
+    void Simulation::Settle() {
+        if (m_Rolling)
+            LandRoll();
+        m_Queue.Clear();
+    }
+
+    RollSnapshot Simulation::Snapshot() const {
+        return RollSnapshot{
+            m_Rolling,
+            m_RollFrom,
+            m_Rotation,
+            m_RollId,
+            m_Rolling ? std::min(1.0f, (float)m_RollTick / TicksPerRoll()) : 0.0f
+        };
+    }
+
+    int Simulation::TicksPerRoll() const {
+        return std::max(1, (int)std::lround(m_Config.tickRate / m_Config.rollsPerSecond));
+    }
+
+}
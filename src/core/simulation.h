@@ -0,0 +1,153 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+#include <vector>
+#include "levelState.h"
+#include "moveQueue.h"
+#include "replay.h"
+#include "undoLog.h"
+
+namespace core {
+    class CubeSwarm;
+
+    struct SimConfig {
+        int tickRate; // simulation ticks per second
+        float rollsPerSecond; // how fast a roll plays
+        bool snapRolls; // a new press finishes the current roll at once instead of queueing
+        double maxFrameTime; // anything above this is dropped instead of simulated
+    };
+
+    inline constexpr SimConfig defaultSimConfig = { 120, 10.0f, false, 0.25 };
+
+    // what the renderer needs to draw the cube, sampled at the end of every tick
+    struct RollSnapshot {
+        bool rolling;
+        CubePose from; // pose at the start of the roll
+        Rotation rotation;
+        int rollId; // tells two consecutive rolls apart
+        float progress; // 0..1
+    };
+
+    // things that happened since the last TakeEvents()
+    struct SimEvents {
+        bool tilesChanged; // a roll that toggled a tile has landed
+        bool levelCompleted;
+        std::vector<int> changedTiles; // tile indices, can repeat, so the renderer only redoes those
+    };
+
+    /*
+        Fixed timestep driver of the game rules.
+
+        Update() accumulates real time and runs whole ticks of 1 / tickRate seconds,
+        so the outcome of a sequence of inputs does not depend on frame times.
+        Rolls last a whole number of ticks and inputs only take effect on a tick,
+        and the renderer interpolates between the last two ticks with GetInterpolated().
+        Headless code can call Tick() directly, as fast as it likes.
+
+        The rules are applied to the LevelState when a roll starts, the roll itself
+        is only animation. Every roll goes through an UndoLog, Undo() and Redo() snap
+        the cube to the result without animating, and refuse to when a swarm cube sits
+        where that would put the player. The session is recorded as well,
+        see GetRecorder().
+    */
+    class Simulation {
+    public:
+        explicit Simulation(LevelState& level, const SimConfig& config = defaultSimConfig);
+
+        // now is in seconds, on the same clock as the press times. Returns the number of ticks run
+        int Update(double now);
+        void Tick();
+        void RequestRoll(Rotation rotation, double pressTime, bool repeat = false);
+        SimEvents TakeEvents();
+        RollSnapshot GetInterpolated() const;
+        bool Undo();
+        bool Redo();
+        // call after the level was changed from outside, the history doesn't apply anymore
+        void ResetHistory();
+
+        // solid cubes the player can't roll onto, null for none. The swarm has to outlive the simulation
+        inline void SetObstacles(const CubeSwarm* obstacles) {
+            m_Obstacles = obstacles;
+        }
+
+        inline const SimConfig& GetConfig() const {
+            return m_Config;
+        }
+
+        inline void SetConfig(const SimConfig& config) {
+            m_Config = config;
+        }
+
+        inline const LatencyStats& GetLatency() const {
+            return m_Latency;
+        }
+
+        inline void ResetLatency() {
+            m_Latency = {};
+        }
+
+        inline const MoveQueue& GetQueue() const {
+            return m_Queue;
+        }
+
+        inline const UndoLog& GetUndoLog() const {
+            return m_Undo;
+        }
+
+        // rolls played since the last ResetHistory(), on the level as it was then
+        inline const ReplayRecorder& GetRecorder() const {
+            return m_Recorder;
+        }
+
+        inline bool IsRolling() const {
+            return m_Rolling;
+        }
+
+        inline double GetTime() const {
+            return m_Time;
+        }
+
+        inline uint64_t GetTickCount() const {
+            return m_TickCount;
+        }
+
+        // fraction of a tick left in the accumulator
+        inline float GetAlpha() const {
+            return (float)(m_Accumulator * m_Config.tickRate);
+        }
+
+    private:
+        bool CanRoll(const CubePose& pose, Rotation rotation) const;
+        bool IsBlocked() const;
+        void BeginRoll(Rotation rotation, double pressTime);
+        void LandRoll();
+        void Settle();
+        RollSnapshot Snapshot() const;
+        int TicksPerRoll() const;
+
+        LevelState& m_Level;
+        const CubeSwarm* m_Obstacles;
+        SimConfig m_Config;
+        MoveQueue m_Queue;
+        LatencyStats m_Latency;
+        UndoLog m_Undo;
+        ReplayRecorder m_Recorder;
+        SimEvents m_Events;
+        RollSnapshot m_Previous;
+        RollSnapshot m_Current;
+        CubePose m_RollFrom;
+        Rotation m_Rotation;
+        bool m_Rolling;
+        int m_RollChangedTile; // tile index the current roll toggles, -1 if none
+        int m_RollTick;
+        int m_RollId;
+        double m_Accumulator;
+        double m_Time; // seconds, advances by exactly one tick per Tick()
+        double m_LastUpdate;
+        bool m_Started;
+        uint64_t m_TickCount;
+    };
+}
+
+#endif // SIMULATION_H
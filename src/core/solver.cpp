@@ -0,0 +1,153 @@
+#include "solver.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+
+namespace core {
+
+    StateSet::StateSet(int numWords, int64_t expectedStates) :
+        m_NumWords(numWords),
+        m_Size(0)
+    {
+        const uint64_t slots = std::bit_ceil((uint64_t)std::max<int64_t>(expectedStates, 8) * 2);
+        m_Slots.assign(slots, 0);
+        m_Mask = slots - 1;
+        m_States.reserve((size_t)std::max<int64_t>(expectedStates, 8) * numWords);
+    }
+
+    uint64_t StateSet::Hash(const uint64_t* state) const {
+        uint64_t h = 0x9E3779B97F4A7C15ull;
+        for (int w = 0; w < m_NumWords; w++) {
+            h = (h ^ state[w]) * 0xBF58476D1CE4E5B9ull;
+            h ^= h >> 31;
+        }
+        h *= 0x94D049BB133111EBull;
+        return h ^ (h >> 29);
+    }
+
+    std::pair<int64_t, bool> StateSet::Insert(const uint64_t* state) {
+        if ((uint64_t)(m_Size + 1) * 2 > m_Slots.size())
+            Grow();
+        const uint64_t hash = Hash(state);
+        const uint64_t tag = hash & 0xFFFFFFFF00000000ull;
+        for (uint64_t slot = hash & m_Mask;; slot = (slot + 1) & m_Mask) {
+            const uint64_t entry = m_Slots[slot];
+            if (entry == 0) {
+                m_Slots[slot] = tag | (uint64_t)(m_Size + 1);
+                m_States.insert(m_States.end(), state, state + m_NumWords);
+                return { m_Size++, true };
+            }
+            if ((entry & 0xFFFFFFFF00000000ull) == tag) {
+                const int64_t ix = (int64_t)(entry & 0xFFFFFFFFull) - 1;
+                if (std::equal(state, state + m_NumWords, Get(ix)))
+                    return { ix, false };
+            }
+        }
+    }
+
+    int64_t StateSet::Find(const uint64_t* state) const {
+        const uint64_t hash = Hash(state);
+        const uint64_t tag = hash & 0xFFFFFFFF00000000ull;
+        for (uint64_t slot = hash & m_Mask;; slot = (slot + 1) & m_Mask) {
+            const uint64_t entry = m_Slots[slot];
+            if (entry == 0)
+                return -1;
+            if ((entry & 0xFFFFFFFF00000000ull) == tag) {
+                const int64_t ix = (int64_t)(entry & 0xFFFFFFFFull) - 1;
+                if (std::equal(state, state + m_NumWords, Get(ix)))
+                    return ix;
+            }
+        }
+    }
+
+    void StateSet::Grow() {
+        // the tag is the top half of the hash and the home slot comes from the bottom half, so
+        // the old slots don't say where an entry goes in the bigger table, the state does
+        std::vector<uint64_t> slots(m_Slots.size() * 2, 0);
+        const uint64_t mask = slots.size() - 1;
+        for (uint64_t entry : m_Slots) {
+            if (entry == 0)
+                continue;
+            uint64_t slot = Hash(Get((int64_t)(entry & 0xFFFFFFFFull) - 1)) & mask;
+            while (slots[slot] != 0)
+                slot = (slot + 1) & mask;
+            slots[slot] = entry;
+        }
+        m_Slots.swap(slots);
+        m_Mask = mask;
+    }
+
+    SolveResult solveBfs(const LevelState& level, const SolveOptions& options) {
+        return solveBfs(StateSpace(level), options);
+    }
+
+    SolveResult solveBfs(const StateSpace& space, const SolveOptions& options) {
+        const auto start = std::chrono::steady_clock::now();
+        const int numWords = space.GetNumWords();
+        SolveResult result = { SolveStatus::UNSOLVABLE, {}, 0, 1, 0, 0.0 };
+
+        // the set numbers states in the order they are found, which is the BFS queue
+        StateSet visited(numWords, std::min(options.expectedStates, options.maxStates));
+        std::vector<uint32_t> parent = { 0 };
+        std::vector<Rotation> moveTo = { Rotation::DOWN };
+        visited.Insert(space.GetStart());
+
+        int64_t found = space.IsGoal(space.GetStart()) ? 0 : -1;
+        std::vector<uint64_t> current(numWords);
+        std::vector<uint64_t> successors(numRotations * numWords);
+        std::array<Rotation, numRotations> moves;
+        int64_t layerEnd = 1;
+        if (space.HasGoal()) {
+            for (int64_t head = 0; found == -1 && head < visited.GetSize(); head++) {
+                if (head == layerEnd) {
+                    result.depth++;
+                    layerEnd = visited.GetSize();
+                }
+                // copied, inserting may move the states
+                std::copy_n(visited.Get(head), numWords, current.data());
+                const int count = space.Expand(current.data(), successors.data(), moves.data());
+                result.expanded++;
+                for (int i = 0; i < count; i++) {
+                    const uint64_t* successor = successors.data() + i * numWords;
+                    if (visited.GetSize() >= options.maxStates && visited.Find(successor) == -1) {
+                        result.status = SolveStatus::GAVE_UP;
+                        break;
+                    }
+                    auto [ix, inserted] = visited.Insert(successor);
+                    if (!inserted)
+                        continue;
+                    parent.push_back((uint32_t)head);
+                    moveTo.push_back(moves[i]);
+                    if (space.IsGoal(successor)) {
+                        found = ix;
+                        result.depth++;
+                        break;
+                    }
+                }
+                if (result.status == SolveStatus::GAVE_UP)
+                    break;
+            }
+        }
+
+        if (found != -1) {
+            result.status = SolveStatus::SOLVED;
+            for (int64_t ix = found; ix != 0; ix = parent[ix])
+                result.moves.push_back(moveTo[ix]);
+            std::reverse(result.moves.begin(), result.moves.end());
+        }
+        result.visited = visited.GetSize();
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    bool checkSolution(const LevelState& level, const std::vector<Rotation>& moves) {
+        LevelState state = level;
+        for (Rotation rotation : moves) {
+            if (!step(state, rotation).moved)
+                return false;
+        }
+        return isLevelComplete(state);
+    }
+
+}
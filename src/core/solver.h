@@ -0,0 +1,146 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "stateSpace.h"
+
+namespace core {
+    enum class SolveStatus {
+        SOLVED,
+        UNSOLVABLE, // searched every reachable state
+        GAVE_UP, // hit SolveOptions::maxStates first
+        FAILED // solveExternal() couldn't read or write its files
+    };
+
+    struct SolveOptions {
+        int64_t maxStates = int64_t(1) << 26; // distinct states to keep before giving up
+        int64_t expectedStates = int64_t(1) << 20; // what the visited set is sized for up front
+        // solveParallel() only
+        int numThreads = 0; // 0 for one per core
+        bool hugePages = false; // the visited table and the states on huge pages, where the OS has them
+        // solveExternal() only
+        int64_t maxMemory = int64_t(256) << 20; // bytes of buffers it may keep in RAM
+        std::string tempDirectory; // where the layer files go (in a directory of their own), the system's if empty
+    };
+
+    // disk traffic of one layer of solveExternal()
+    struct ExternalLayer {
+        int depth; // -1 for the walk back through the layers that finds the moves
+        int64_t states; // new states in the layer
+        int runs; // sorted runs the layer's successors were spilled in
+        int64_t bytesWritten;
+        int64_t bytesRead;
+    };
+
+    struct SolveResult {
+        SolveStatus status;
+        std::vector<Rotation> moves; // a shortest solution, when SOLVED
+        int64_t expanded; // states whose successors were generated
+        int64_t visited; // distinct states seen, the start included
+        int depth; // deepest layer searched
+        double seconds;
+    };
+
+    /*
+        Set of packed states (StateSpace), each one numbered in the order it was added.
+
+        The states themselves sit back to back in one array, so the number of a state is
+        all a search has to keep about it. The table is open addressing with linear probing,
+        each slot holds 32 bits of the hash and the state's number + 1 (0 is empty), so a
+        probe only reads the state when the hashes match and growing never hashes again.
+        It stays under half full, a state costs 8 bytes per word plus 16 to 32 bytes of table.
+    */
+    class StateSet {
+    public:
+        StateSet(int numWords, int64_t expectedStates);
+
+        // the number of the state, and whether it is new
+        std::pair<int64_t, bool> Insert(const uint64_t* state);
+        // -1 if the state isn't in the set
+        int64_t Find(const uint64_t* state) const;
+
+        inline const uint64_t* Get(int64_t ix) const {
+            return m_States.data() + ix * m_NumWords;
+        }
+
+        inline int64_t GetSize() const {
+            return m_Size;
+        }
+
+    private:
+        uint64_t Hash(const uint64_t* state) const;
+        void Grow();
+
+        int m_NumWords;
+        int64_t m_Size;
+        uint64_t m_Mask; // slots - 1
+        std::vector<uint64_t> m_Slots;
+        std::vector<uint64_t> m_States;
+    };
+
+    // breadth first from the level's start, the moves it finds are a shortest solution
+    SolveResult solveBfs(const LevelState& level, const SolveOptions& options = {});
+    SolveResult solveBfs(const StateSpace& space, const SolveOptions& options = {});
+    /*
+        solveBfs() on all cores, one BFS layer at a time.
+
+        The threads pull chunks of the current layer and expand them into a frontier
+        buffer of their own, the buffers are put together into the next layer once all
+        threads are done with this one. Visited states go into one table the threads share
+        without locks: open addressing where a slot is claimed with a compare and swap, keyed
+        by the state's Zobrist hash, which every successor gets from its parent's for a few
+        xors (StateSpace::Expand()). The states, their hashes and their parents sit in arrays
+        reserved for maxStates up front, the memory only gets used as they fill. The table
+        grows in between layers, when no thread is touching it.
+
+        The solution has the same length as the one of solveBfs(), but may be another one.
+    */
+    SolveResult solveParallel(const LevelState& level, const SolveOptions& options = {});
+    SolveResult solveParallel(const StateSpace& space, const SolveOptions& options = {});
+    class PatternDatabase;
+
+    /*
+        Best first on moves so far + the database's estimate of the moves left, which is a
+        lower bound, so the first goal state taken from the open list is a shortest
+        solution. The open list is one bucket per f, newest first within a bucket, and the
+        states go into a StateSet like solveBfs(). Dead ends (unreachable estimate) are
+        never kept.
+    */
+    SolveResult solveAStar(const StateSpace& space, const PatternDatabase& heuristic, const SolveOptions& options = {});
+    // iterative deepening A*: depth first up to a bound on f that grows each round, no visited
+    // set at all, maxStates limits the states expanded over all rounds instead
+    SolveResult solveIdaStar(const StateSpace& space, const PatternDatabase& heuristic, const SolveOptions& options = {});
+    /*
+        Breadth first from both ends at once: forward from the start, backward from every goal
+        state (StateSpace::GetGoalStates()) with StateSpace::ExpandBackward(). Each round
+        expands a whole layer of the side with the smaller one, and a state found by one
+        side that the other has seen joins the two halves of a solution. The shortest such
+        join over the layer is a shortest solution. Both sides keep their states in a StateSet,
+        maxStates counts them together.
+    */
+    SolveResult solveBidirectional(const StateSpace& space, const SolveOptions& options = {});
+    /*
+        solveBfs() for state spaces that don't fit in RAM, with every layer in a file.
+
+        The successors of a layer are collected in a buffer, sorted and written out as a
+        run whenever it fills up. The runs are then merged, which drops the duplicates
+        between them, and streamed against the files of the previous layers (all sorted
+        the same way), which drops the states seen before. What is left is the next layer.
+        Files hold the states in order, each one as the difference to the one before in
+        variable length bytes, so a dense layer costs a few bytes per state and all of the
+        I/O is sequential. The moves come from walking back through the layer files once a
+        goal state turns up. RAM stays around maxMemory whatever the number of states, disk
+        use is a few bytes for every state seen.
+
+        layers gets the disk traffic of every layer, when it isn't null.
+    */
+    SolveResult solveExternal(const StateSpace& space, const SolveOptions& options = {},
+            std::vector<ExternalLayer>* layers = nullptr);
+    // plays the moves through core::step() and checks that every one is legal and the level ends complete
+    bool checkSolution(const LevelState& level, const std::vector<Rotation>& moves);
+}
+
+#endif // SOLVER_H
@@ -0,0 +1,217 @@
+#include "stateSpace.h"
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+
+namespace core {
+
+    static uint64_t splitMix(uint64_t& seed) {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    StateSpace::StateSpace(const LevelState& level) :
+        m_Level(level),
+        m_PoseBits(0),
+        m_NumWords(0),
+        m_HasTargets(false),
+        m_HasGoal(false),
+        m_LightElsewhere(false)
+    {
+        const TileGrid& tiles = level.tiles;
+
+        // flood fill from the start, every cell gets the next free index in the order it is found
+        std::unordered_map<int, int> cellOf; // by tile index
+        const CubePose start = { level.player.x, level.player.z, 0 };
+        cellOf[tiles.GetTileIndex(start.x, start.z)] = 0;
+        m_CellPose.push_back(start);
+        for (int cell = 0; cell < (int)m_CellPose.size(); cell++) {
+            const CubePose pose = m_CellPose[cell];
+            for (int r = 0; r < numRotations; r++) {
+                if (!canMove(level, pose, static_cast<Rotation>(r))) {
+                    m_Neighbour.push_back(-1);
+                    continue;
+                }
+                const CubePose next = { (int16_t)(pose.x + rollDx[r]), (int16_t)(pose.z + rollDz[r]), 0 };
+                auto [it, inserted] = cellOf.try_emplace(tiles.GetTileIndex(next.x, next.z), (int)m_CellPose.size());
+                if (inserted)
+                    m_CellPose.push_back(next);
+                m_Neighbour.push_back(it->second);
+            }
+        }
+
+        m_Previous.assign(m_Neighbour.size(), -1);
+        for (int i = 0; i < (int)m_Neighbour.size(); i++) {
+            if (m_Neighbour[i] != -1)
+                m_Previous[m_Neighbour[i] * numRotations + i % numRotations] = i / numRotations;
+        }
+
+        int reachableDark = 0;
+        int reachableLight = 0;
+        bool reachableTarget = false;
+        for (int cell = 0; cell < (int)m_CellPose.size(); cell++) {
+            const CubePose& pose = m_CellPose[cell];
+            const int padded = tiles.PaddedIndex(pose.x, pose.z);
+            const TileType type = tiles.TypeAt(padded);
+            const bool toggles = type == TileType::DARK_TILE || type == TileType::LIGHT_TILE;
+            m_ToggleOf.push_back(toggles ? (int)m_TogglePadded.size() : -1);
+            if (toggles) {
+                m_TogglePadded.push_back(padded);
+                m_ToggleCell.push_back(cell);
+            }
+            reachableDark += type == TileType::DARK_TILE;
+            reachableLight += type == TileType::LIGHT_TILE;
+            m_Target.push_back(tileInfo[(int)type].target);
+            reachableTarget |= tileInfo[(int)type].target;
+        }
+
+        m_HasTargets = tiles.Count(targetTiles()) != 0;
+        m_LightElsewhere = tiles.Count(TileType::LIGHT_TILE) > reachableLight;
+        m_HasGoal = tiles.Count(TileType::DARK_TILE) == reachableDark &&
+            (m_HasTargets ? reachableTarget : !m_TogglePadded.empty() || m_LightElsewhere);
+
+        m_PoseBits = std::max(1, (int)std::bit_width((uint64_t)m_CellPose.size() * numOrientations - 1));
+        m_NumWords = (m_PoseBits + GetNumToggles() + 63) / 64;
+        m_ToggleMask.assign(m_NumWords, 0);
+        m_Start.assign(m_NumWords, 0);
+        m_Start[0] = level.player.orientation;
+        for (int i = 0; i < GetNumToggles(); i++) {
+            const int bit = m_PoseBits + i;
+            m_ToggleMask[bit >> 6] |= uint64_t(1) << (bit & 63);
+            if (tiles.TypeAt(m_TogglePadded[i]) == TileType::LIGHT_TILE)
+                m_Start[bit >> 6] |= uint64_t(1) << (bit & 63);
+        }
+
+        // fixed seed, the same level hashes the same in every run
+        uint64_t seed = 0x2545F4914F6CDD1Dull;
+        m_PoseKeys.resize(m_CellPose.size() * numOrientations);
+        for (uint64_t& key : m_PoseKeys)
+            key = splitMix(seed);
+        m_ToggleKeys.resize(m_TogglePadded.size());
+        for (uint64_t& key : m_ToggleKeys)
+            key = splitMix(seed);
+    }
+
+    int StateSpace::Expand(const uint64_t* state, uint64_t* out, Rotation* moves, uint64_t hash,
+            uint64_t* hashes) const {
+        const uint64_t poseMask = (uint64_t(1) << m_PoseBits) - 1;
+        const int pose = (int)(state[0] & poseMask);
+        const int cell = pose / numOrientations;
+        const int orientation = pose % numOrientations;
+
+        int count = 0;
+        for (int r = 0; r < numRotations; r++) {
+            const int next = m_Neighbour[cell * numRotations + r];
+            if (next == -1)
+                continue;
+            const uint8_t nextOrientation = orientationTables.next[orientation][r];
+            uint64_t* successor = out + count * m_NumWords;
+            for (int w = 0; w < m_NumWords; w++)
+                successor[w] = state[w];
+            const int nextPose = next * numOrientations + nextOrientation;
+            successor[0] = (successor[0] & ~poseMask) | (uint64_t)nextPose;
+            uint64_t nextHash = hash ^ m_PoseKeys[pose] ^ m_PoseKeys[nextPose];
+
+            const int toggle = m_ToggleOf[next];
+            if (toggle != -1) {
+                const int bit = m_PoseBits + toggle;
+                const uint64_t mask = uint64_t(1) << (bit & 63);
+                const bool light = LightsUp(nextOrientation);
+                if (light != IsLight(state, toggle))
+                    nextHash ^= m_ToggleKeys[toggle];
+                successor[bit >> 6] = light ? successor[bit >> 6] | mask : successor[bit >> 6] & ~mask;
+            }
+            if (hashes != nullptr)
+                hashes[count] = nextHash;
+            moves[count++] = static_cast<Rotation>(r);
+        }
+        return count;
+    }
+
+    int StateSpace::ExpandBackward(const uint64_t* state, uint64_t* out, Rotation* moves) const {
+        const uint64_t poseMask = (uint64_t(1) << m_PoseBits) - 1;
+        const int pose = (int)(state[0] & poseMask);
+        const int toggle = m_ToggleOf[pose / numOrientations];
+        if (toggle != -1 && IsLight(state, toggle) != LightsUp(pose % numOrientations))
+            return 0;
+
+        int count = 0;
+        for (int r = 0; r < numRotations; r++) {
+            const int previous = Unroll(pose, static_cast<Rotation>(r));
+            if (previous == -1)
+                continue;
+            for (int before = 0; before < (toggle == -1 ? 1 : 2); before++) {
+                uint64_t* predecessor = out + count * m_NumWords;
+                for (int w = 0; w < m_NumWords; w++)
+                    predecessor[w] = state[w];
+                predecessor[0] = (predecessor[0] & ~poseMask) | (uint64_t)previous;
+                if (toggle != -1) {
+                    const int bit = m_PoseBits + toggle;
+                    const uint64_t mask = uint64_t(1) << (bit & 63);
+                    predecessor[bit >> 6] = before ? predecessor[bit >> 6] | mask : predecessor[bit >> 6] & ~mask;
+                }
+                moves[count++] = static_cast<Rotation>(r);
+            }
+        }
+        return count;
+    }
+
+    std::vector<uint64_t> StateSpace::GetGoalStates() const {
+        std::vector<uint64_t> goals;
+        if (!m_HasGoal)
+            return goals;
+        for (int pose = 0; pose < GetNumPoses(); pose++) {
+            const int cell = pose / numOrientations;
+            if (m_HasTargets && !m_Target[cell])
+                continue;
+            // standing on a toggle it can only have lit it
+            if (m_ToggleOf[cell] != -1 && !LightsUp(pose % numOrientations))
+                continue;
+            for (int w = 0; w < m_NumWords; w++)
+                goals.push_back(m_ToggleMask[w] | (w == 0 ? (uint64_t)pose : 0));
+        }
+        return goals;
+    }
+
+    uint64_t StateSpace::Hash(const uint64_t* state) const {
+        uint64_t hash = m_PoseKeys[state[0] & ((uint64_t(1) << m_PoseBits) - 1)];
+        for (int i = 0; i < GetNumToggles(); i++) {
+            if (IsLight(state, i))
+                hash ^= m_ToggleKeys[i];
+        }
+        return hash;
+    }
+
+    bool StateSpace::IsGoal(const uint64_t* state) const {
+        if (!m_HasGoal)
+            return false;
+        for (int w = 0; w < m_NumWords; w++) {
+            if ((state[w] & m_ToggleMask[w]) != m_ToggleMask[w])
+                return false;
+        }
+        // all reachable toggles are light and (HasGoal) there is at least one light tile
+        const int cell = (int)((state[0] & ((uint64_t(1) << m_PoseBits) - 1)) / numOrientations);
+        return !m_HasTargets || m_Target[cell];
+    }
+
+    CubePose StateSpace::GetPose(const uint64_t* state) const {
+        const int pose = (int)(state[0] & ((uint64_t(1) << m_PoseBits) - 1));
+        const CubePose& cell = m_CellPose[pose / numOrientations];
+        return { cell.x, cell.z, (uint8_t)(pose % numOrientations) };
+    }
+
+    LevelState StateSpace::Decode(const uint64_t* state) const {
+        LevelState level = m_Level;
+        level.player = GetPose(state);
+        for (int i = 0; i < GetNumToggles(); i++) {
+            const TileType before = level.tiles.TypeAt(m_TogglePadded[i]);
+            const TileType after = IsLight(state, i) ? TileType::LIGHT_TILE : TileType::DARK_TILE;
+            if (after != before)
+                level.tiles.Replace(m_TogglePadded[i], before, after);
+        }
+        return level;
+    }
+
+}
@@ -0,0 +1,159 @@
+#ifndef STATE_SPACE_H
+#define STATE_SPACE_H
+
+#include <cstdint>
+#include <vector>
+#include "levelState.h"
+#include "cubePose.h"
+#include "rules.h"
+#include "tileRules.h"
+
+namespace core {
+    /*
+        Everything a search needs to know about a level, with a state packed into a few words.
+
+        Rolls only ever change the pose and whether a dark or light tile is dark or light
+        (tileRules.h asserts that), so a state is the pose plus one bit per toggleable tile.
+        Both only count what the cube can actually get to: the cells are the tiles reachable
+        from the start (a flood fill over canMove(), which ignores the toggles), and the
+        bits are the dark and light tiles among them. The packed state is
+
+            bits [0, poseBits)      cell * 24 + orientation
+            bit poseBits + i        toggle i is light
+
+        over GetNumWords() uint64_t words, unused bits are 0, so two states are equal when
+        their words are. A 20x20 level of toggles fits into 7 words.
+
+        A dark tile the cube can't reach can never be lit, such a level has no goal state.
+    */
+    class StateSpace {
+    public:
+        explicit StateSpace(const LevelState& level);
+
+        // writes the successors of state to out (numRotations * GetNumWords() words) and the
+        // Rotation that leads to each to moves, returns how many there are. With hashes, it
+        // also writes the Hash() of every successor there, updated from hash, the state's
+        int Expand(const uint64_t* state, uint64_t* out, Rotation* moves, uint64_t hash = 0,
+                uint64_t* hashes = nullptr) const;
+        // the states that lead to state in one roll, into out (2 * numRotations * GetNumWords()
+        // words), with the Rotation of each roll in moves, returns how many there are. The roll
+        // decided what the tile it landed on is, so a state is only reached at all if that tile is
+        // what the roll makes it, and then from both a dark and a light one
+        int ExpandBackward(const uint64_t* state, uint64_t* out, Rotation* moves) const;
+        // every goal state (the ones a roll can end in), back to back
+        std::vector<uint64_t> GetGoalStates() const;
+        // Zobrist hash: a random key per pose, xor one per light toggle. A roll changes it by
+        // two pose keys and at most one toggle key, which is how Expand() keeps it up to date
+        uint64_t Hash(const uint64_t* state) const;
+        // what isLevelComplete() says about the state
+        bool IsGoal(const uint64_t* state) const;
+        CubePose GetPose(const uint64_t* state) const;
+        // the full level in the state, for checking a search against core::step()
+        LevelState Decode(const uint64_t* state) const;
+
+        inline const uint64_t* GetStart() const {
+            return m_Start.data();
+        }
+
+        inline int GetNumWords() const {
+            return m_NumWords;
+        }
+
+        inline int GetNumCells() const {
+            return (int)m_CellPose.size();
+        }
+
+        inline int GetNumToggles() const {
+            return (int)m_TogglePadded.size();
+        }
+
+        inline int GetPoseBits() const {
+            return m_PoseBits;
+        }
+
+        // false if no state can ever be complete, like with an unreachable dark tile
+        inline bool HasGoal() const {
+            return m_HasGoal;
+        }
+
+        inline bool HasTargets() const {
+            return m_HasTargets;
+        }
+
+        inline const LevelState& GetLevel() const {
+            return m_Level;
+        }
+
+        // a pose without the toggles is cell * 24 + orientation, for searches over the pose graph alone
+        inline int GetNumPoses() const {
+            return GetNumCells() * numOrientations;
+        }
+
+        inline int PoseOf(const uint64_t* state) const {
+            return (int)(state[0] & ((uint64_t(1) << m_PoseBits) - 1));
+        }
+
+        // -1 if the roll is illegal
+        inline int Roll(int pose, Rotation rotation) const {
+            const int next = m_Neighbour[pose / numOrientations * numRotations + (int)rotation];
+            return next == -1 ? -1 : next * numOrientations + orientationTables.next[pose % numOrientations][(int)rotation];
+        }
+
+        // the pose that lands on pose with the roll, -1 if there is none
+        inline int Unroll(int pose, Rotation rotation) const {
+            const int previous = m_Previous[pose / numOrientations * numRotations + (int)rotation];
+            return previous == -1 ? -1 :
+                previous * numOrientations + orientationTables.prev[pose % numOrientations][(int)rotation];
+        }
+
+        // whether landing on a toggle in the orientation makes it light, dark and light tiles share their onEnter row
+        static inline bool LightsUp(int orientation) {
+            return onEnter(TileType::DARK_TILE, downFace((uint8_t)orientation)) == TileType::LIGHT_TILE;
+        }
+
+        // -1 if the cell's tile never changes
+        inline int GetToggle(int cell) const {
+            return m_ToggleOf[cell];
+        }
+
+        inline int GetToggleCell(int toggle) const {
+            return m_ToggleCell[toggle];
+        }
+
+        inline bool IsTarget(int cell) const {
+            return m_Target[cell];
+        }
+
+        inline bool IsLight(const uint64_t* state, int toggle) const {
+            const int bit = m_PoseBits + toggle;
+            return (state[bit >> 6] >> (bit & 63)) & 1;
+        }
+
+        // the toggle bits, per word
+        inline const uint64_t* GetToggleMask() const {
+            return m_ToggleMask.data();
+        }
+
+    private:
+        LevelState m_Level;
+        std::vector<CubePose> m_CellPose; // position of each cell, orientation 0
+        std::vector<int32_t> m_Neighbour; // per cell and Rotation, -1 if the roll is illegal
+        std::vector<int32_t> m_Previous; // per cell and Rotation, the cell that rolls onto it or -1
+        std::vector<int32_t> m_ToggleOf; // per cell, -1 if the tile never changes
+        std::vector<uint8_t> m_Target; // per cell
+        std::vector<int> m_TogglePadded; // padded tile index of each toggle
+        std::vector<int> m_ToggleCell;
+        std::vector<uint64_t> m_ToggleMask; // all the toggle bits, per word
+        std::vector<uint64_t> m_Start;
+        std::vector<uint64_t> m_PoseKeys; // Zobrist keys, per cell * 24 + orientation
+        std::vector<uint64_t> m_ToggleKeys; // per toggle
+        int m_PoseBits;
+        int m_NumWords;
+        bool m_HasTargets;
+        bool m_HasGoal;
+        // no targets: a level without any light tile isn't complete, one the cube can't reach counts too
+        bool m_LightElsewhere;
+    };
+}
+
+#endif // STATE_SPACE_H
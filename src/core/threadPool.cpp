@@ -0,0 +1,88 @@
+#include "threadPool.h"
+#include <algorithm>
+
+namespace core {
+
+    ThreadPool::ThreadPool(int numThreads) :
+        m_Workers(),
+        m_Job(nullptr),
+        m_Count(0),
+        m_NumChunks(0),
+        m_Pending(0),
+        m_Generation(0),
+        m_Quit(false)
+    {
+        for (int i = 1; i < numThreads; i++)
+            m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(m_Mutex);
+            m_Quit = true;
+        }
+        m_WorkReady.notify_all();
+        for (std::thread& worker : m_Workers)
+            worker.join();
+    }
+
+    static void chunkOf(int count, int numChunks, int chunk, int& begin, int& end) {
+        begin = (int)((int64_t)count * chunk / numChunks);
+        end = (int)((int64_t)count * (chunk + 1) / numChunks);
+    }
+
+    void ThreadPool::ParallelFor(int count, int minChunk, const std::function<void(int begin, int end)>& fn) {
+        const int numChunks = std::clamp(count / std::max(1, minChunk), 1, GetNumThreads());
+        if (numChunks == 1) {
+            fn(0, count);
+            return;
+        }
+
+        {
+            std::lock_guard lock(m_Mutex);
+            m_Job = &fn;
+            m_Count = count;
+            m_NumChunks = numChunks;
+            m_Pending = (int)m_Workers.size();
+            m_Generation++;
+        }
+        m_WorkReady.notify_all();
+
+        int begin, end;
+        chunkOf(count, numChunks, 0, begin, end);
+        fn(begin, end);
+
+        std::unique_lock lock(m_Mutex);
+        m_WorkDone.wait(lock, [this] { return m_Pending == 0; });
+        m_Job = nullptr;
+    }
+
+    void ThreadPool::WorkerLoop(int worker) {
+        uint64_t seen = 0;
+        while (true) {
+            const std::function<void(int, int)>* job;
+            int count, numChunks;
+            {
+                std::unique_lock lock(m_Mutex);
+                m_WorkReady.wait(lock, [&] { return m_Quit || m_Generation != seen; });
+                if (m_Quit)
+                    return;
+                seen = m_Generation;
+                job = m_Job;
+                count = m_Count;
+                numChunks = m_NumChunks;
+            }
+
+            if (worker < numChunks) {
+                int begin, end;
+                chunkOf(count, numChunks, worker, begin, end);
+                (*job)(begin, end);
+            }
+
+            std::lock_guard lock(m_Mutex);
+            if (--m_Pending == 0)
+                m_WorkDone.notify_one();
+        }
+    }
+
+}
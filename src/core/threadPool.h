@@ -0,0 +1,51 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace core {
+    /*
+        Fixed set of worker threads for data parallel loops.
+
+        ParallelFor() splits [0, count) in one contiguous chunk per thread (fewer if a
+        chunk would get less than minChunk items), runs the first chunk on the calling
+        thread and returns once every chunk is done. The workers sleep in between, so
+        calling it once per batch step is cheap.
+    */
+    class ThreadPool {
+    public:
+        // numThreads counts the calling thread, 1 means no workers at all
+        explicit ThreadPool(int numThreads);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void ParallelFor(int count, int minChunk, const std::function<void(int begin, int end)>& fn);
+
+        inline int GetNumThreads() const {
+            return (int)m_Workers.size() + 1;
+        }
+
+    private:
+        void WorkerLoop(int worker);
+
+        std::vector<std::thread> m_Workers;
+        std::mutex m_Mutex;
+        std::condition_variable m_WorkReady;
+        std::condition_variable m_WorkDone;
+        const std::function<void(int, int)>* m_Job;
+        int m_Count;
+        int m_NumChunks;
+        int m_Pending; // workers still running the current job
+        uint64_t m_Generation; // bumped for every job, wakes the workers up
+        bool m_Quit;
+    };
+}
+
+#endif // THREAD_POOL_H
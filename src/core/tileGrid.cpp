@@ -0,0 +1,112 @@
+#include "tileGrid.h"
+#include <algorithm>
+
+static TileChunk makeEmptyChunk(int chunkIx) {
+    TileChunk chunk;
+    chunk.cells.fill((uint8_t)TileType::EMPTY_TILE);
+    chunk.occupied.fill(0);
+    chunk.numOccupied = 0;
+    chunk.chunkIx = chunkIx;
+    chunk.modified = false;
+    return chunk;
+}
+
+// the sentinels, one for every grid there is
+static const std::shared_ptr<TileChunk>& sharedChunk(int chunkIx) {
+    static const std::shared_ptr<TileChunk> empty = std::make_shared<TileChunk>(makeEmptyChunk(-1));
+    static const std::shared_ptr<TileChunk> unloaded = std::make_shared<TileChunk>(makeEmptyChunk(-2));
+    return chunkIx == -1 ? empty : unloaded;
+}
+
+TileGrid::TileGrid(int sideLength) :
+    m_NumAllocated(0),
+    m_Counts{},
+    m_SideLength(sideLength),
+    m_Offset(sideLength / 2),
+    m_ChunksPerRow((sideLength + 2 + TileChunk::side - 1) / TileChunk::side)
+{
+    Clear();
+}
+
+void TileGrid::Clear() {
+    // everything is empty, border included (that is the sentinel the rules rely on)
+    m_Chunks.assign(GetNumChunks(), sharedChunk(emptyChunk));
+    m_NumAllocated = 0;
+
+    m_Counts = {};
+    m_Counts[(int)TileType::EMPTY_TILE] = GetNumTiles();
+}
+
+TileType TileGrid::Get(int tileIx) const {
+    return TypeAt(ToPadded(tileIx));
+}
+
+void TileGrid::Set(int tileIx, TileType type) {
+    int cell = ToPadded(tileIx);
+    TileType current = TypeAt(cell);
+    if (current == type)
+        return;
+
+    const int chunkIx = cell >> cellBits;
+    if (m_Chunks[chunkIx]->chunkIx == unloadedChunk)
+        return;
+    if (m_Chunks[chunkIx]->chunkIx == emptyChunk) {
+        // only writes allocate, so an empty chunk costs nothing until a tile is put in it
+        InsertChunk(chunkIx, makeEmptyChunk(chunkIx));
+    }
+    Replace(cell, current, type);
+}
+
+void TileGrid::Unshare(int chunkIx) {
+    m_Chunks[chunkIx] = std::make_shared<TileChunk>(*m_Chunks[chunkIx]);
+}
+
+void TileGrid::MarkUnloaded(int chunkIx) {
+    m_Chunks[chunkIx] = sharedChunk(unloadedChunk);
+}
+
+void TileGrid::SetCounts(const std::array<int, numTileTypes>& counts) {
+    m_Counts = counts;
+}
+
+void TileGrid::InsertChunk(int chunkIx, const TileChunk& chunk) {
+    m_Chunks[chunkIx] = std::make_shared<TileChunk>(chunk);
+    m_Chunks[chunkIx]->chunkIx = chunkIx;
+    m_NumAllocated++;
+}
+
+TileChunk TileGrid::EvictChunk(int chunkIx) {
+    TileChunk chunk = *m_Chunks[chunkIx];
+    m_Chunks[chunkIx] = sharedChunk(unloadedChunk);
+    m_NumAllocated--;
+    return chunk;
+}
+
+void TileGrid::UnpackChunk(const uint8_t* rowMajor, TileChunk& chunk) {
+    chunk.occupied.fill(0);
+    chunk.numOccupied = 0;
+    chunk.modified = false;
+    for (int z = 0; z < TileChunk::side; z++) {
+        for (int x = 0; x < TileChunk::side; x++) {
+            const int cell = chunkLayout.Index(x, z);
+            const uint8_t type = rowMajor[z * TileChunk::side + x];
+            chunk.cells[cell] = type;
+            if (type != (uint8_t)TileType::EMPTY_TILE) {
+                chunk.occupied[cell >> 6] |= uint64_t(1) << (cell & 63);
+                chunk.numOccupied++;
+            }
+        }
+    }
+}
+
+void TileGrid::PackChunk(const TileChunk& chunk, uint8_t* rowMajor) {
+    for (int z = 0; z < TileChunk::side; z++) {
+        for (int x = 0; x < TileChunk::side; x++)
+            rowMajor[z * TileChunk::side + x] = chunk.cells[chunkLayout.Index(x, z)];
+    }
+}
+
+size_t TileGrid::GetMemoryUsage() const {
+    return sizeof(TileGrid) + m_Chunks.capacity() * sizeof(std::shared_ptr<TileChunk>) +
+        (size_t)m_NumAllocated * sizeof(TileChunk);
+}
@@ -0,0 +1,289 @@
+#ifndef TILE_GRID_H
+#define TILE_GRID_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "tileLayout.h"
+
+enum class TileType {
+    EMPTY_TILE,
+    GROUND_TILE,
+    DARK_TILE,
+    LIGHT_TILE,
+    TARGET_OFF_TILE,
+    TARGET_ON_TILE,
+    ONE_WAY_DOWN_TILE,
+    ONE_WAY_UP_TILE,
+    ONE_WAY_LEFT_TILE,
+    ONE_WAY_RIGHT_TILE
+};
+
+// what each type does lives in core::tileInfo (tileRules.h)
+static constexpr int numTileTypes = 10;
+
+// set of tile types, bit n is TileType n
+using TileTypeMask = uint32_t;
+
+constexpr TileTypeMask tileBit(TileType type) {
+    return 1u << (int)type;
+}
+
+// one bit per cell of a dense padded grid, see BatchEnv
+using TilePlane = std::vector<uint64_t>;
+
+// 32x32 tiles of a TileGrid, allocated on the first write of a non empty tile
+struct TileChunk {
+    static constexpr int shift = 5;
+    static constexpr int side = 1 << shift;
+    static constexpr int numCells = side * side;
+
+    std::array<uint8_t, numCells> cells; // TileType, in TileLayout order
+    std::array<uint64_t, numCells / 64> occupied; // non empty tiles, same order as cells
+    int numOccupied;
+    int chunkIx; // where it sits in the grid, negative for the shared empty and unloaded ones
+    bool modified; // written to since it was allocated or inserted
+};
+
+/*
+    Tiles of a square level, stored sparse in chunks of 32x32.
+
+    Cells are addressed with a padded index that covers the grid plus a one tile border
+    that is always EMPTY_TILE, so looking at the neighbour of any tile inside the grid
+    never needs a bounds check. The padded index is the chunk (row major) times 1024
+    plus the position inside the chunk (TileLayout). A chunk is only allocated once a
+    non empty tile is written to it, every other one reads from a shared all empty
+    chunk, so memory goes with the part of the level that is used and not with its
+    area: an empty 10000x10000 level is the 400 KB chunk directory.
+
+    Chunks are shared between copies of the grid and only copied when one of them
+    writes to it (copy on write), so copying a grid is one pointer per chunk and a
+    snapshot of the level costs next to nothing until the live one changes, and then
+    only the chunks that change.
+
+    Outside code keeps using the plain row major tile index (z * sideLength + x, the
+    same one the editor uses), the padded index is only exposed for the hot paths of
+    the rules. Every Set() keeps a per type counter up to date, so things like "how
+    many dark tiles are left" are O(1).
+
+    For levels streamed from disk (core::ChunkStreamer) a chunk can also be unloaded:
+    it reads as empty like a chunk that doesn't exist, but Set() ignores it, so the
+    cube can't roll into it and nothing can be lost by writing to it. The counts keep
+    covering the whole level, unloaded chunks included.
+*/
+class TileGrid {
+public:
+    TileGrid() :
+        m_NumAllocated(0),
+        m_Counts{},
+        m_SideLength(0),
+        m_Offset(0),
+        m_ChunksPerRow(0)
+    { }
+
+    explicit TileGrid(int sideLength);
+
+    TileType Get(int tileIx) const;
+    void Set(int tileIx, TileType type);
+    void Clear();
+
+    // calls fn(tileIx) for every tile of the given type, chunk by chunk.
+    // Empty tiles are not kept track of, for EMPTY_TILE this walks the whole grid
+    template <typename F>
+    void ForEach(TileType type, F&& fn) const {
+        if (type == TileType::EMPTY_TILE) {
+            for (int tileIx = 0; tileIx < GetNumTiles(); tileIx++) {
+                if (Get(tileIx) == type)
+                    fn(tileIx);
+            }
+            return;
+        }
+        for (int chunkIx = 0; chunkIx < GetNumChunks(); chunkIx++) {
+            ForEachInChunk(chunkIx, [&](int tileIx, TileType tileType) {
+                if (tileType == type)
+                    fn(tileIx);
+            });
+        }
+    }
+
+    // calls fn(tileIx, type) for every non empty tile of a chunk
+    template <typename F>
+    void ForEachInChunk(int chunkIx, F&& fn) const {
+        const TileChunk& chunk = *m_Chunks[chunkIx];
+        for (int w = 0; w < (int)chunk.occupied.size(); w++) {
+            uint64_t bits = chunk.occupied[w];
+            while (bits) {
+                const int cell = w * 64 + std::countr_zero(bits);
+                fn(ToTileIndex(chunkIx << cellBits | cell), static_cast<TileType>(chunk.cells[cell]));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // centered tile coords (the grid goes from -sideLength/2) to row major index, -1 if outside
+    inline int GetTileIndex(int tileX, int tileZ) const {
+        tileX += m_Offset;
+        tileZ += m_Offset;
+        if (tileX >= 0 && tileZ >= 0 && tileX < m_SideLength && tileZ < m_SideLength)
+            return tileZ * m_SideLength + tileX;
+        else
+            return -1;
+    }
+
+    // padded index of centered tile coords, valid up to one tile outside the grid
+    inline int PaddedIndex(int tileX, int tileZ) const {
+        return CellIndex(tileX + m_Offset + 1, tileZ + m_Offset + 1);
+    }
+
+    inline int ToPadded(int tileIx) const {
+        return CellIndex(tileIx % m_SideLength + 1, tileIx / m_SideLength + 1);
+    }
+
+    inline int ToTileIndex(int paddedIx) const {
+        const int chunkIx = paddedIx >> cellBits;
+        const int cell = paddedIx & (TileChunk::numCells - 1);
+        const int px = (chunkIx % m_ChunksPerRow << TileChunk::shift) + chunkLayout.X(cell);
+        const int pz = (chunkIx / m_ChunksPerRow << TileChunk::shift) + chunkLayout.Z(cell);
+        return (pz - 1) * m_SideLength + px - 1;
+    }
+
+    inline TileType TypeAt(int paddedIx) const {
+        return static_cast<TileType>(m_Chunks[paddedIx >> cellBits]->cells[paddedIx & (TileChunk::numCells - 1)]);
+    }
+
+    // fast path for the rules, the caller already knows the current type. The chunk
+    // has to be allocated already, which it is whenever from isn't EMPTY_TILE
+    inline void Replace(int paddedIx, TileType from, TileType to) {
+        TileChunk& chunk = MutableChunk(paddedIx >> cellBits);
+        const int cell = paddedIx & (TileChunk::numCells - 1);
+        chunk.cells[cell] = (uint8_t)to;
+        chunk.modified = true;
+        if (from == TileType::EMPTY_TILE || to == TileType::EMPTY_TILE) {
+            chunk.occupied[cell >> 6] ^= uint64_t(1) << (cell & 63);
+            chunk.numOccupied += from == TileType::EMPTY_TILE ? 1 : -1;
+        }
+        m_Counts[(int)from]--;
+        m_Counts[(int)to]++;
+    }
+
+    inline int Count(TileType type) const {
+        return m_Counts[(int)type];
+    }
+
+    inline int Count(TileTypeMask types) const {
+        int count = 0;
+        for (int t = 0; t < numTileTypes; t++) {
+            if (types & (1u << t))
+                count += m_Counts[t];
+        }
+        return count;
+    }
+
+    inline int GetSideLength() const {
+        return m_SideLength;
+    }
+
+    inline int GetNumTiles() const {
+        return m_SideLength * m_SideLength;
+    }
+
+    // centered tile coordinate to padded coordinate
+    inline int GetPaddedOffset() const {
+        return m_Offset + 1;
+    }
+
+    // chunks cover the padded grid, row major
+    inline int GetChunksPerRow() const {
+        return m_ChunksPerRow;
+    }
+
+    inline int GetNumChunks() const {
+        return m_ChunksPerRow * m_ChunksPerRow;
+    }
+
+    inline int ChunkOf(int tileIx) const {
+        return ToPadded(tileIx) >> cellBits;
+    }
+
+    // chunk of centered tile coords, valid up to one tile outside the grid
+    inline int ChunkAt(int tileX, int tileZ) const {
+        return PaddedIndex(tileX, tileZ) >> cellBits;
+    }
+
+    // nullptr for chunks that were never written to and for unloaded ones
+    inline const TileChunk* GetChunk(int chunkIx) const {
+        return m_Chunks[chunkIx]->chunkIx < 0 ? nullptr : m_Chunks[chunkIx].get();
+    }
+
+    inline int GetNumAllocatedChunks() const {
+        return m_NumAllocated;
+    }
+
+    // calls fn(const TileChunk&) for every allocated chunk, in chunk order
+    template <typename F>
+    void ForEachAllocatedChunk(F&& fn) const {
+        for (const std::shared_ptr<TileChunk>& chunk : m_Chunks) {
+            if (chunk->chunkIx >= 0)
+                fn(*chunk);
+        }
+    }
+
+    // the chunk is the very same one in both grids (of the same size), neither wrote to it since one was copied from the other
+    inline bool SharesChunk(const TileGrid& other, int chunkIx) const {
+        return m_Chunks[chunkIx] == other.m_Chunks[chunkIx];
+    }
+
+    // chunks shared with other grids are counted in full, as the grid would need them on its own
+    size_t GetMemoryUsage() const;
+
+    // streaming, see ChunkStreamer. The chunk must not be allocated
+    void MarkUnloaded(int chunkIx);
+    void SetCounts(const std::array<int, numTileTypes>& counts);
+    // an unloaded chunk back in, counts are not touched
+    void InsertChunk(int chunkIx, const TileChunk& chunk);
+    // the chunk reads as unloaded afterwards, counts are not touched
+    TileChunk EvictChunk(int chunkIx);
+
+    inline bool IsUnloaded(int chunkIx) const {
+        return m_Chunks[chunkIx]->chunkIx == unloadedChunk;
+    }
+
+    // chunk cells from and to plain row major order, what goes on disk
+    static void UnpackChunk(const uint8_t* rowMajor, TileChunk& chunk);
+    static void PackChunk(const TileChunk& chunk, uint8_t* rowMajor);
+
+private:
+    // chunkIx of the two chunks every grid shares and never writes to
+    static constexpr int emptyChunk = -1;
+    static constexpr int unloadedChunk = -2;
+    static constexpr int cellBits = 2 * TileChunk::shift;
+    static constexpr TileLayout chunkLayout = TileLayout(TileChunk::side);
+
+    // padded coordinates to padded index
+    inline int CellIndex(int px, int pz) const {
+        const int chunkIx = (pz >> TileChunk::shift) * m_ChunksPerRow + (px >> TileChunk::shift);
+        return chunkIx << cellBits | chunkLayout.Index(px & (TileChunk::side - 1), pz & (TileChunk::side - 1));
+    }
+
+    // the chunk, copied first if another grid still holds it
+    inline TileChunk& MutableChunk(int chunkIx) {
+        if (m_Chunks[chunkIx].use_count() > 1)
+            Unshare(chunkIx);
+        return *m_Chunks[chunkIx];
+    }
+
+    void Unshare(int chunkIx);
+
+    // chunk directory, chunks that don't exist yet point at the shared empty one
+    std::vector<std::shared_ptr<TileChunk>> m_Chunks;
+    int m_NumAllocated;
+    std::array<int, numTileTypes> m_Counts; // tiles inside the grid only, the border is not counted
+    int m_SideLength;
+    int m_Offset; // sideLength / 2, see GetTileIndex
+    int m_ChunksPerRow;
+};
+
+#endif // TILE_GRID_H
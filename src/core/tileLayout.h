@@ -0,0 +1,96 @@
+#ifndef TILE_LAYOUT_H
+#define TILE_LAYOUT_H
+
+#include <array>
+#include <cstdint>
+
+/*
+    How the cells of a square block of a padded grid (tile coordinates + 1, the border
+    included) map to an index, for the bits of a TilePlane or the bytes of a cell array.
+
+    RowMajorLayout is the plain z * stride + x. MortonLayout cuts the grid into 8x8
+    bricks: the 64 cells of a brick are in Z-order and fill exactly one plane word,
+    the bricks themselves are row major. Walking to any of the 4 neighbours then stays
+    in the same word most of the time, where row major jumps a whole row of words for
+    every step along z. Plain Z-order over the whole grid would need a power of two
+    side, which pads a 4098 wide padded grid to 8192 (4 times the memory), bricks only
+    round up to a multiple of 8.
+
+    TileGrid orders the cells inside its 32x32 chunks with the one picked at compile
+    time (MYGAME_MORTON_TILES), see TileLayout below.
+*/
+class RowMajorLayout {
+public:
+    constexpr RowMajorLayout() : m_Stride(0) { }
+
+    constexpr explicit RowMajorLayout(int paddedSide) : m_Stride(paddedSide) { }
+
+    constexpr int Index(int px, int pz) const {
+        return pz * m_Stride + px;
+    }
+
+    constexpr int X(int ix) const {
+        return ix % m_Stride;
+    }
+
+    constexpr int Z(int ix) const {
+        return ix / m_Stride;
+    }
+
+    constexpr int GetNumCells() const {
+        return m_Stride * m_Stride;
+    }
+
+private:
+    int m_Stride;
+};
+
+// Z-order position of (x, z) inside an 8x8 brick, indexed by z * 8 + x
+inline constexpr std::array<uint8_t, 64> mortonBrickOrder = [] {
+    // 0b abc -> 0b a0b0c
+    auto spread = [](int v) { return (v & 1) | ((v & 2) << 1) | ((v & 4) << 2); };
+    std::array<uint8_t, 64> table = {};
+    for (int i = 0; i < 64; i++)
+        table[i] = (uint8_t)(spread(i & 7) | (spread(i >> 3) << 1));
+    return table;
+}();
+
+class MortonLayout {
+public:
+    constexpr MortonLayout() : m_BricksPerRow(0) { }
+
+    constexpr explicit MortonLayout(int paddedSide) : m_BricksPerRow((paddedSide + 7) / 8) { }
+
+    constexpr int Index(int px, int pz) const {
+        int brick = (pz >> 3) * m_BricksPerRow + (px >> 3);
+        return (brick << 6) | mortonBrickOrder[(pz & 7) << 3 | (px & 7)];
+    }
+
+    constexpr int X(int ix) const {
+        return (ix >> 6) % m_BricksPerRow * 8 + compact(ix & 63);
+    }
+
+    constexpr int Z(int ix) const {
+        return (ix >> 6) / m_BricksPerRow * 8 + compact((ix & 63) >> 1);
+    }
+
+    constexpr int GetNumCells() const {
+        return m_BricksPerRow * m_BricksPerRow * 64;
+    }
+
+private:
+    // 0b a0b0c -> 0b abc, reads bits 0, 2 and 4
+    static constexpr int compact(int m) {
+        return (m & 1) | ((m >> 1) & 2) | ((m >> 2) & 4);
+    }
+
+    int m_BricksPerRow;
+};
+
+#ifdef MYGAME_MORTON_TILES
+using TileLayout = MortonLayout;
+#else
+using TileLayout = RowMajorLayout;
+#endif
+
+#endif // TILE_LAYOUT_H
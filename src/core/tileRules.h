@@ -0,0 +1,129 @@
+#ifndef TILE_RULES_H
+#define TILE_RULES_H
+
+#include <array>
+#include <cstdint>
+#include "levelState.h"
+#include "cubePose.h"
+
+namespace core {
+    // bit r set: a roll in Rotation r may land on the tile
+    static constexpr uint8_t enterFromAnywhere = 0b1111;
+
+    struct TileInfo {
+        const char* name; // editor button
+        char glyph; // level files
+        uint32_t color; // 0xRRGGBB, as drawn by the game
+        uint8_t enterFrom;
+        bool target; // the cube has to end on one of these, if the level has any
+        std::array<TileType, 6> onEnter; // what the tile turns into, indexed by the Face landing on it
+    };
+
+    // stays what it is whatever face lands on it
+    constexpr std::array<TileType, 6> same(TileType type) {
+        return { type, type, type, type, type, type };
+    }
+
+    // the front face lights dark tiles up, every other face turns light tiles off
+    constexpr std::array<TileType, 6> lightOnFront() {
+        std::array<TileType, 6> onEnter = same(TileType::DARK_TILE);
+        onEnter[(int)Face::F] = TileType::LIGHT_TILE;
+        return onEnter;
+    }
+
+    /*
+        Everything the rules, the renderer, the editor and the level files know about a
+        tile type, indexed by TileType. Adding a type is adding a row here (and to the
+        enum), core::step() only ever does lookups into this table.
+    */
+    inline constexpr std::array<TileInfo, numTileTypes> tileInfo = {{
+        { "Empty", '.', 0x000000, 0, false, same(TileType::EMPTY_TILE) },
+        { "Ground", '#', 0xFFFFFF, enterFromAnywhere, false, same(TileType::GROUND_TILE) },
+        { "Dark", 'D', 0x770000, enterFromAnywhere, false, lightOnFront() },
+        { "Light", 'L', 0xFF0000, enterFromAnywhere, false, lightOnFront() },
+        { "Target OFF", 'O', 0x007700, enterFromAnywhere, true, same(TileType::TARGET_OFF_TILE) },
+        { "Target ON", 'T', 0x00FF00, enterFromAnywhere, true, same(TileType::TARGET_ON_TILE) },
+        { "One way down", 'v', 0x3355AA, 1 << (int)Rotation::DOWN, false, same(TileType::ONE_WAY_DOWN_TILE) },
+        { "One way up", '^', 0x4466CC, 1 << (int)Rotation::UP, false, same(TileType::ONE_WAY_UP_TILE) },
+        { "One way left", '<', 0x5577DD, 1 << (int)Rotation::LEFT, false, same(TileType::ONE_WAY_LEFT_TILE) },
+        { "One way right", '>', 0x6688EE, 1 << (int)Rotation::RIGHT, false, same(TileType::ONE_WAY_RIGHT_TILE) },
+    }};
+
+    struct VoxelInfo {
+        const char* name; // editor button
+        char glyph; // level files
+        uint32_t color; // 0xRRGGBB, before the face shading
+    };
+
+    // indexed by VoxelType. Every voxel is a wall on layer 0, the type only changes its shape
+    inline constexpr std::array<VoxelInfo, numVoxelTypes> voxelInfo = {{
+        { "Empty", '.', 0x000000 },
+        { "Block", '#', 0x8C8C9A },
+        { "Ramp down", 'v', 0xA08060 },
+        { "Ramp up", '^', 0xA08060 },
+        { "Ramp left", '<', 0xA08060 },
+        { "Ramp right", '>', 0xA08060 },
+    }};
+
+    constexpr bool isRamp(VoxelType type) {
+        return type >= VoxelType::RAMP_DOWN;
+    }
+
+    // the way a ramp rises, as the Rotation of a roll going up it
+    constexpr Rotation rampRotation(VoxelType type) {
+        return static_cast<Rotation>((int)type - (int)VoxelType::RAMP_DOWN);
+    }
+
+    constexpr bool canEnter(TileType type, Rotation rotation) {
+        return (tileInfo[(int)type].enterFrom >> (int)rotation) & 1;
+    }
+
+    constexpr TileType onEnter(TileType type, Face face) {
+        return tileInfo[(int)type].onEnter[(int)face];
+    }
+
+    constexpr TileTypeMask targetTiles() {
+        TileTypeMask mask = 0;
+        for (int t = 0; t < numTileTypes; t++) {
+            if (tileInfo[t].target)
+                mask |= 1u << t;
+        }
+        return mask;
+    }
+
+    // the undo log and the batch env store a tile change as one light/dark bit, which
+    // only holds as long as nothing but dark and light tiles ever changes
+    constexpr bool onlyDarkLightChange() {
+        for (int t = 0; t < numTileTypes; t++) {
+            bool darkOrLight = t == (int)TileType::DARK_TILE || t == (int)TileType::LIGHT_TILE;
+            for (TileType after : tileInfo[t].onEnter) {
+                if (after != static_cast<TileType>(t) && !darkOrLight)
+                    return false;
+                if (darkOrLight && after != TileType::DARK_TILE && after != TileType::LIGHT_TILE)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr bool validTileInfo() {
+        for (int t = 0; t < numTileTypes; t++) {
+            for (int u = t + 1; u < numTileTypes; u++) {
+                if (tileInfo[t].glyph == tileInfo[u].glyph)
+                    return false;
+            }
+        }
+        for (int t = 0; t < numVoxelTypes; t++) {
+            for (int u = t + 1; u < numVoxelTypes; u++) {
+                if (voxelInfo[t].glyph == voxelInfo[u].glyph)
+                    return false;
+            }
+        }
+        // the empty border is what keeps the cube inside the grid
+        return tileInfo[(int)TileType::EMPTY_TILE].enterFrom == 0;
+    }
+
+    static_assert(validTileInfo());
+}
+
+#endif // TILE_RULES_H
@@ -0,0 +1,140 @@
+#include "tweens.h"
+#include <algorithm>
+
+namespace core {
+
+    // a, b and c of ease(t) = a t + b t^2 + c t^3, all of them go from 0 at t = 0 to 1 at t = 1
+    static constexpr float easeCoefficients[][3] = {
+        { 1.0f, 0.0f, 0.0f }, // LINEAR
+        { 0.0f, 1.0f, 0.0f }, // IN_QUAD
+        { 2.0f, -1.0f, 0.0f }, // OUT_QUAD
+        { 3.0f, -3.0f, 1.0f }, // OUT_CUBIC
+        { 0.0f, 3.0f, -2.0f }, // SMOOTH
+    };
+
+    TweenId TweenSystem::Start(float start, float end, float duration, Ease ease, float delay, Callback onDone) {
+        uint32_t slot;
+        if (m_FreeSlots.empty()) {
+            slot = (uint32_t)m_Slots.size();
+            m_Slots.push_back({ 0, 1 });
+        } else {
+            slot = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+        m_Slots[slot].dense = (uint32_t)m_Value.size();
+
+        duration = std::max(duration, 0.0f);
+        const float* coefficients = easeCoefficients[(int)ease];
+        m_Start.push_back(start);
+        m_Delta.push_back(end - start);
+        m_Elapsed.push_back(-std::max(delay, 0.0f));
+        m_Duration.push_back(duration);
+        // a tween without duration ends on the next Update(), at t = 1 like any other
+        m_InvDuration.push_back(duration > 0.0f ? 1.0f / duration : 0.0f);
+        m_A.push_back(coefficients[0]);
+        m_B.push_back(coefficients[1]);
+        m_C.push_back(coefficients[2]);
+        m_Value.push_back(start);
+        m_Owner.push_back(slot);
+        m_OnDone.push_back(std::move(onDone));
+        return (TweenId)m_Slots[slot].generation << 32 | slot;
+    }
+
+    bool TweenSystem::Cancel(TweenId id) {
+        const int ix = Find(id);
+        if (ix == -1)
+            return false;
+        Remove(ix);
+        return true;
+    }
+
+    void TweenSystem::Clear() {
+        while (!m_Value.empty())
+            Remove((int)m_Value.size() - 1);
+    }
+
+    bool TweenSystem::IsActive(TweenId id) const {
+        return Find(id) != -1;
+    }
+
+    void TweenSystem::Remove(int ix) {
+        Slot& slot = m_Slots[m_Owner[ix]];
+        slot.generation++;
+        m_FreeSlots.push_back(m_Owner[ix]);
+
+        const int last = (int)m_Value.size() - 1;
+        if (ix != last) {
+            m_Start[ix] = m_Start[last];
+            m_Delta[ix] = m_Delta[last];
+            m_Elapsed[ix] = m_Elapsed[last];
+            m_Duration[ix] = m_Duration[last];
+            m_InvDuration[ix] = m_InvDuration[last];
+            m_A[ix] = m_A[last];
+            m_B[ix] = m_B[last];
+            m_C[ix] = m_C[last];
+            m_Value[ix] = m_Value[last];
+            m_Owner[ix] = m_Owner[last];
+            m_OnDone[ix] = std::move(m_OnDone[last]);
+            m_Slots[m_Owner[ix]].dense = (uint32_t)ix;
+        }
+        m_Start.pop_back();
+        m_Delta.pop_back();
+        m_Elapsed.pop_back();
+        m_Duration.pop_back();
+        m_InvDuration.pop_back();
+        m_A.pop_back();
+        m_B.pop_back();
+        m_C.pop_back();
+        m_Value.pop_back();
+        m_Owner.pop_back();
+        m_OnDone.pop_back();
+    }
+
+    // the whole pass, selects instead of branches so it stays one vector loop
+    static void advance(int n, float deltaTime, float* __restrict elapsed, float* __restrict value,
+            const float* __restrict start, const float* __restrict delta, const float* __restrict duration,
+            const float* __restrict invDuration, const float* __restrict a, const float* __restrict b,
+            const float* __restrict c) {
+        for (int i = 0; i < n; i++) {
+            const float e = elapsed[i] + deltaTime;
+            elapsed[i] = e;
+            float t = e * invDuration[i];
+            t = t > 0.0f ? t : 0.0f;
+            t = t < 1.0f ? t : 1.0f;
+            t = e >= duration[i] ? 1.0f : t;
+            value[i] = start[i] + delta[i] * (((c[i] * t + b[i]) * t + a[i]) * t);
+        }
+    }
+
+    int TweenSystem::Update(float deltaTime) {
+        const int n = (int)m_Value.size();
+        advance(n, deltaTime, m_Elapsed.data(), m_Value.data(), m_Start.data(), m_Delta.data(), m_Duration.data(),
+                m_InvDuration.data(), m_A.data(), m_B.data(), m_C.data());
+
+        // mostly nothing finishes, so no branch on it either
+        m_Finished.resize(n);
+        int numFinished = 0;
+        for (int i = 0; i < n; i++) {
+            m_Finished[numFinished] = i;
+            numFinished += m_Elapsed[i] >= m_Duration[i];
+        }
+        m_Finished.resize(numFinished);
+        if (numFinished == 0)
+            return 0;
+
+        // from the back, whatever gets swapped into a finished tween's place is still running
+        std::vector<Callback> callbacks;
+        callbacks.swap(m_Callbacks);
+        for (auto it = m_Finished.rbegin(); it != m_Finished.rend(); ++it) {
+            if (m_OnDone[*it])
+                callbacks.push_back(std::move(m_OnDone[*it]));
+            Remove(*it);
+        }
+        for (auto it = callbacks.rbegin(); it != callbacks.rend(); ++it)
+            (*it)();
+        callbacks.clear();
+        m_Callbacks.swap(callbacks);
+        return numFinished;
+    }
+
+}
@@ -0,0 +1,98 @@
+#ifndef TWEENS_H
+#define TWEENS_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace core {
+    // how a tween gets from start to end, every one of them is a cubic in the time fraction
+    enum class Ease : uint8_t {
+        LINEAR,
+        IN_QUAD,
+        OUT_QUAD,
+        OUT_CUBIC,
+        SMOOTH // smoothstep, slow at both ends
+    };
+
+    // 0 is never a tween, so it can stand for none
+    using TweenId = uint64_t;
+
+    /*
+        Every float the game animates (roll progress, tile effects, camera moves), updated
+        together once per frame.
+
+        The tweens are kept as structure of arrays, dense, in no particular order. An
+        easing is the three coefficients of its cubic, so Update() is one branch free
+        loop over plain float arrays that the compiler vectorizes, whatever mix of
+        easings is running. Finished tweens are swapped out of the arrays afterwards and
+        their callbacks run last, when the arrays are consistent again, so a callback
+        can start the next tween of a chain or change anything else in the game.
+
+        An id stays valid while its tween runs and never comes back after it is done, the
+        dense index behind it moves around as others finish (generation per slot, like
+        handles usually are).
+    */
+    class TweenSystem {
+    public:
+        using Callback = std::function<void()>;
+
+        // the value goes from start to end in duration seconds, after waiting delay seconds at start
+        TweenId Start(float start, float end, float duration, Ease ease = Ease::LINEAR, float delay = 0.0f,
+                Callback onDone = {});
+        // stops a tween without its callback, false if it was done already
+        bool Cancel(TweenId id);
+        // cancels all of them
+        void Clear();
+        // advances every tween, then calls back the ones that finished. Returns how many finished
+        int Update(float deltaTime);
+
+        bool IsActive(TweenId id) const;
+
+        // current value, otherwise once the tween is done or cancelled
+        inline float Get(TweenId id, float otherwise) const {
+            const int ix = Find(id);
+            return ix == -1 ? otherwise : m_Value[ix];
+        }
+
+        inline int GetNumActive() const {
+            return (int)m_Value.size();
+        }
+
+    private:
+        struct Slot {
+            uint32_t dense; // index into the arrays while the tween runs
+            uint32_t generation; // bumped when it finishes, so old ids stop matching
+        };
+
+        inline int Find(TweenId id) const {
+            const uint32_t slot = (uint32_t)id;
+            if (slot >= m_Slots.size() || m_Slots[slot].generation != (uint32_t)(id >> 32))
+                return -1;
+            return (int)m_Slots[slot].dense;
+        }
+
+        // swaps the last tween into ix, the callback is moved out first
+        void Remove(int ix);
+
+        // per tween
+        std::vector<float> m_Start;
+        std::vector<float> m_Delta; // end - start
+        std::vector<float> m_Elapsed; // negative while delayed
+        std::vector<float> m_Duration;
+        std::vector<float> m_InvDuration;
+        std::vector<float> m_A; // ease(t) = ((c t + b) t + a) t
+        std::vector<float> m_B;
+        std::vector<float> m_C;
+        std::vector<float> m_Value;
+        std::vector<uint32_t> m_Owner; // slot of the tween
+        std::vector<Callback> m_OnDone;
+
+        std::vector<Slot> m_Slots;
+        std::vector<uint32_t> m_FreeSlots;
+        std::vector<int> m_Finished; // of the current Update()
+        std::vector<Callback> m_Callbacks;
+    };
+}
+
+#endif // TWEENS_H
@@ -0,0 +1,166 @@
+#include "undoLog.h"
+#include <algorithm>
+#include <bit>
+#include <unordered_set>
+
+namespace core {
+
+    UndoLog::UndoLog(int checkpointInterval, int maxCheckpoints) :
+        m_Segments(),
+        m_Interval(checkpointInterval),
+        m_MaxCheckpoints(maxCheckpoints),
+        m_Cursor(0)
+    {
+    }
+
+    void UndoLog::Clear() {
+        m_Segments.clear();
+        m_Cursor = 0;
+    }
+
+    StepResult UndoLog::Step(LevelState& state, Rotation rotation) {
+        // illegal rolls don't change anything, so they don't cut the redo history either
+        if (!canMove(state, rotation))
+            return step(state, rotation);
+
+        Truncate();
+        if (m_Segments.empty() || m_Segments.back().numMoves == m_Interval) {
+            Segment& segment = m_Segments.emplace_back(Segment{ state, m_Cursor, 0, {}, {}, {} });
+            segment.moves.reserve((m_Interval + 3) / 4);
+            segment.toggleFlags.reserve((m_Interval + 63) / 64);
+            if ((int)m_Segments.size() > m_MaxCheckpoints)
+                m_Segments.pop_front();
+        }
+
+        Segment& segment = m_Segments.back();
+        StepResult result = step(state, rotation);
+
+        const int i = segment.numMoves++;
+        if (i % 4 == 0)
+            segment.moves.push_back(0);
+        segment.moves[i / 4] |= (uint8_t)((int)rotation << (i % 4 * 2));
+
+        if (i % 64 == 0)
+            segment.toggleFlags.push_back(0);
+        if (result.numChangedTiles > 0) {
+            segment.toggleFlags[i / 64] |= uint64_t(1) << (i % 64);
+            segment.toggled.push_back((uint32_t)result.changedTiles[0].tileIx);
+        }
+
+        m_Cursor++;
+        return result;
+    }
+
+    bool UndoLog::Undo(LevelState& state) {
+        if (m_Cursor == GetFirstMove())
+            return false;
+        StepBack(state);
+        return true;
+    }
+
+    bool UndoLog::Redo(LevelState& state) {
+        if (m_Cursor == GetLastMove())
+            return false;
+        StepForward(state);
+        return true;
+    }
+
+    void UndoLog::Seek(LevelState& state, int64_t move) {
+        move = std::clamp(move, GetFirstMove(), GetLastMove());
+        if (move == m_Cursor)
+            return;
+
+        // restart from the checkpoint when that is fewer rolls than walking there from here
+        Segment& segment = SegmentOf(move);
+        int64_t distance = move > m_Cursor ? move - m_Cursor : m_Cursor - move;
+        if (move - segment.firstMove < distance) {
+            state = segment.start;
+            m_Cursor = segment.firstMove;
+        }
+
+        while (m_Cursor < move)
+            StepForward(state);
+        while (m_Cursor > move)
+            StepBack(state);
+    }
+
+    size_t UndoLog::GetMemoryUsage() const {
+        // checkpoints share every chunk nothing wrote to in between, those count once
+        std::unordered_set<const TileChunk*> chunks;
+        size_t bytes = sizeof(UndoLog);
+        for (const Segment& segment : m_Segments) {
+            bytes += sizeof(Segment);
+            bytes += (size_t)segment.start.tiles.GetNumChunks() * sizeof(std::shared_ptr<TileChunk>);
+            segment.start.tiles.ForEachAllocatedChunk([&](const TileChunk& chunk) {
+                chunks.insert(&chunk);
+            });
+            bytes += segment.moves.capacity();
+            bytes += segment.toggleFlags.capacity() * sizeof(uint64_t);
+            bytes += segment.toggled.capacity() * sizeof(uint32_t);
+        }
+        return bytes + chunks.size() * sizeof(TileChunk);
+    }
+
+    UndoLog::Segment& UndoLog::SegmentOf(int64_t move) {
+        int64_t ix = (move - m_Segments.front().firstMove) / m_Interval;
+        return m_Segments[std::min<int64_t>(ix, m_Segments.size() - 1)];
+    }
+
+    void UndoLog::Truncate() {
+        if (m_Cursor == GetLastMove())
+            return;
+
+        while (!m_Segments.empty() && m_Segments.back().firstMove >= m_Cursor)
+            m_Segments.pop_back();
+        if (m_Segments.empty())
+            return;
+
+        Segment& segment = m_Segments.back();
+        const int keep = (int)(m_Cursor - segment.firstMove);
+
+        int numToggles = 0;
+        for (int w = 0; w < keep / 64; w++)
+            numToggles += std::popcount(segment.toggleFlags[w]);
+        if (keep % 64 != 0) {
+            segment.toggleFlags[keep / 64] &= (uint64_t(1) << (keep % 64)) - 1;
+            numToggles += std::popcount(segment.toggleFlags[keep / 64]);
+        }
+
+        segment.numMoves = keep;
+        segment.toggled.resize(numToggles);
+        segment.toggleFlags.resize((keep + 63) / 64);
+        segment.moves.resize((keep + 3) / 4);
+        if (keep % 4 != 0)
+            segment.moves.back() &= (uint8_t)((1 << (keep % 4 * 2)) - 1);
+    }
+
+    void UndoLog::StepBack(LevelState& state) {
+        const int64_t move = m_Cursor - 1;
+        const Segment& segment = SegmentOf(move);
+        const int i = (int)(move - segment.firstMove);
+        const Rotation rotation = static_cast<Rotation>((segment.moves[i / 4] >> (i % 4 * 2)) & 3);
+
+        if ((segment.toggleFlags[i / 64] >> (i % 64)) & 1) {
+            // the toggle is the n-th one of the segment, n being the flags set before it
+            int slot = std::popcount(segment.toggleFlags[i / 64] & ((uint64_t(1) << (i % 64)) - 1));
+            for (int w = 0; w < i / 64; w++)
+                slot += std::popcount(segment.toggleFlags[w]);
+
+            const int tileIx = (int)segment.toggled[slot];
+            TileType tile = state.tiles.Get(tileIx);
+            state.tiles.Set(tileIx, tile == TileType::DARK_TILE ? TileType::LIGHT_TILE : TileType::DARK_TILE);
+        }
+
+        state.player = unrollPose(state.player, rotation);
+        m_Cursor--;
+    }
+
+    void UndoLog::StepForward(LevelState& state) {
+        const int64_t move = m_Cursor;
+        const Segment& segment = SegmentOf(move);
+        const int i = (int)(move - segment.firstMove);
+        step(state, static_cast<Rotation>((segment.moves[i / 4] >> (i % 4 * 2)) & 3));
+        m_Cursor++;
+    }
+
+}
@@ -0,0 +1,80 @@
+#ifndef UNDO_LOG_H
+#define UNDO_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "levelState.h"
+#include "rules.h"
+#include "tileRules.h"
+
+namespace core {
+    /*
+        Undo/redo history of the rolls played on a level.
+
+        Every roll costs 2 bits (its Rotation) plus 1 bit telling whether it toggled a
+        tile, and the index of that tile if it did. The history is split in segments of
+        checkpointInterval rolls, each one starting with a copy of the LevelState. The
+        copies share every chunk no roll toggled a tile in (see TileGrid).
+
+        Undoing a roll runs it backwards (previous pose, flip the toggled tile back).
+        Seeking further than that restores the closest checkpoint and replays forward,
+        so any jump costs at most checkpointInterval rolls. Once there are more than
+        maxCheckpoints segments the oldest one is dropped, which bounds the memory.
+    */
+    class UndoLog {
+    public:
+        explicit UndoLog(int checkpointInterval = 1024, int maxCheckpoints = 512);
+
+        // forget everything, e.g. after the level was edited
+        void Clear();
+        // core::step() that records the roll, dropping whatever could have been redone
+        StepResult Step(LevelState& state, Rotation rotation);
+        bool Undo(LevelState& state);
+        bool Redo(LevelState& state);
+        // moves the state to the given roll count, clamped to what the log still holds
+        void Seek(LevelState& state, int64_t move);
+        size_t GetMemoryUsage() const;
+
+        // rolls applied to the state, counted from the Clear()
+        inline int64_t GetCursor() const {
+            return m_Cursor;
+        }
+
+        inline int64_t GetFirstMove() const {
+            return m_Segments.empty() ? m_Cursor : m_Segments.front().firstMove;
+        }
+
+        inline int64_t GetLastMove() const {
+            return m_Segments.empty() ? m_Cursor : m_Segments.back().firstMove + m_Segments.back().numMoves;
+        }
+
+    private:
+        // only one tile can change per roll, that is what the 1 bit toggle flag relies on
+        static_assert(maxChangedTiles == 1);
+        // and undoing it flips dark and light, so nothing else may change
+        static_assert(onlyDarkLightChange());
+
+        struct Segment {
+            LevelState start; // state before the first roll of the segment
+            int64_t firstMove;
+            int numMoves;
+            std::vector<uint8_t> moves; // 4 rolls per byte
+            std::vector<uint64_t> toggleFlags; // 1 bit per roll
+            std::vector<uint32_t> toggled; // tile index of every toggle, in roll order
+        };
+
+        Segment& SegmentOf(int64_t move);
+        void Truncate();
+        void StepBack(LevelState& state);
+        void StepForward(LevelState& state);
+
+        std::deque<Segment> m_Segments; // every segment but the last one is full
+        int m_Interval;
+        int m_MaxCheckpoints;
+        int64_t m_Cursor;
+    };
+}
+
+#endif // UNDO_LOG_H
@@ -0,0 +1,173 @@
+#include "voxelGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+VoxelGrid::VoxelGrid(int sideLength) :
+    m_Chunks(),
+    m_Count(0),
+    m_SideLength(sideLength),
+    m_Offset(sideLength / 2),
+    m_ChunksPerRow((sideLength + 2 + VoxelChunk::side - 1) / VoxelChunk::side)
+{
+}
+
+void VoxelGrid::Clear() {
+    m_Chunks.clear();
+    m_Count = 0;
+}
+
+VoxelType VoxelGrid::Get(int tileX, int layer, int tileZ) const {
+    const int px = tileX + m_Offset + 1;
+    const int pz = tileZ + m_Offset + 1;
+    if (m_Chunks.empty() || px < 1 || pz < 1 || px > m_SideLength || pz > m_SideLength || layer < 0 || layer >= numLayers)
+        return VoxelType::EMPTY;
+    const VoxelChunk* chunk = m_Chunks[(pz >> VoxelChunk::shift) * m_ChunksPerRow + (px >> VoxelChunk::shift)].get();
+    if (chunk == nullptr)
+        return VoxelType::EMPTY;
+    return static_cast<VoxelType>(chunk->cells[CellIndex(px, layer, pz)]);
+}
+
+void VoxelGrid::Set(int tileX, int layer, int tileZ, VoxelType type) {
+    const int px = tileX + m_Offset + 1;
+    const int pz = tileZ + m_Offset + 1;
+    if (px < 1 || pz < 1 || px > m_SideLength || pz > m_SideLength || layer < 0 || layer >= numLayers)
+        return;
+    if (Get(tileX, layer, tileZ) == type)
+        return;
+
+    VoxelChunk& chunk = MutableChunk((pz >> VoxelChunk::shift) * m_ChunksPerRow + (px >> VoxelChunk::shift));
+    uint8_t& cell = chunk.cells[CellIndex(px, layer, pz)];
+    const int change = (type != VoxelType::EMPTY) - (cell != (uint8_t)VoxelType::EMPTY);
+    cell = (uint8_t)type;
+    chunk.numSolid += change;
+    m_Count += change;
+}
+
+int VoxelGrid::ColumnHeight(int tileX, int tileZ) const {
+    for (int layer = numLayers - 1; layer >= 0; layer--) {
+        if (Get(tileX, layer, tileZ) != VoxelType::EMPTY)
+            return layer + 1;
+    }
+    return 0;
+}
+
+VoxelChunk& VoxelGrid::MutableChunk(int chunkIx) {
+    if (m_Chunks.empty())
+        m_Chunks.resize(GetNumChunks());
+    std::shared_ptr<VoxelChunk>& chunk = m_Chunks[chunkIx];
+    if (!chunk) {
+        chunk = std::make_shared<VoxelChunk>();
+        chunk->cells.fill((uint8_t)VoxelType::EMPTY);
+        chunk->numSolid = 0;
+    } else if (chunk.use_count() > 1) {
+        chunk = std::make_shared<VoxelChunk>(*chunk);
+    }
+    return *chunk;
+}
+
+size_t VoxelGrid::GetMemoryUsage() const {
+    size_t bytes = sizeof(VoxelGrid) + m_Chunks.capacity() * sizeof(std::shared_ptr<VoxelChunk>);
+    for (const std::shared_ptr<VoxelChunk>& chunk : m_Chunks)
+        bytes += chunk ? sizeof(VoxelChunk) : 0;
+    return bytes;
+}
+
+namespace core {
+
+    RayHit raycast(const VoxelGrid& voxels, const std::array<float, 3>& origin, const std::array<float, 3>& direction) {
+        RayHit result = {};
+        const int low = -(voxels.GetPaddedOffset() - 1);
+        const int high = low + voxels.GetSideLength();
+        const float boxMin[3] = { (float)low, 0.0f, (float)low };
+        const float boxMax[3] = { (float)high, (float)VoxelGrid::numLayers, (float)high };
+
+        // nothing to walk through, only the floor can be hit
+        if (voxels.Count() == 0) {
+            if (origin[1] < 0.0f || direction[1] >= 0.0f)
+                return result;
+            const float t = -origin[1] / direction[1];
+            const float x = origin[0] + direction[0] * t;
+            const float z = origin[2] + direction[2] * t;
+            if (x < boxMin[0] || z < boxMin[2] || x >= boxMax[0] || z >= boxMax[2])
+                return result;
+            result = { true, true, (int)std::floor(x), (int)std::floor(z), -1, { 0, 1, 0 }, t, 0 };
+            return result;
+        }
+
+        // clip the ray to the box, slab by slab
+        static constexpr float infinity = std::numeric_limits<float>::infinity();
+        float tEnter = 0.0f;
+        float tExit = infinity;
+        int enterAxis = -1;
+        for (int a = 0; a < 3; a++) {
+            if (direction[a] == 0.0f) {
+                if (origin[a] < boxMin[a] || origin[a] >= boxMax[a])
+                    return result;
+                continue;
+            }
+            float t0 = (boxMin[a] - origin[a]) / direction[a];
+            float t1 = (boxMax[a] - origin[a]) / direction[a];
+            if (t0 > t1)
+                std::swap(t0, t1);
+            if (t0 > tEnter) {
+                tEnter = t0;
+                enterAxis = a;
+            }
+            tExit = std::min(tExit, t1);
+        }
+        if (tEnter > tExit)
+            return result;
+
+        int cell[3];
+        int step[3];
+        float tMax[3];
+        float tDelta[3];
+        for (int a = 0; a < 3; a++) {
+            const float p = origin[a] + direction[a] * tEnter;
+            cell[a] = std::clamp((int)std::floor(p), (int)boxMin[a], (int)boxMax[a] - 1);
+            if (direction[a] > 0.0f) {
+                step[a] = 1;
+                tMax[a] = (cell[a] + 1 - origin[a]) / direction[a];
+                tDelta[a] = 1.0f / direction[a];
+            } else if (direction[a] < 0.0f) {
+                step[a] = -1;
+                tMax[a] = (cell[a] - origin[a]) / direction[a];
+                tDelta[a] = -1.0f / direction[a];
+            } else {
+                step[a] = 0;
+                tMax[a] = infinity;
+                tDelta[a] = infinity;
+            }
+        }
+
+        std::array<int, 3> normal = { 0, 0, 0 };
+        if (enterAxis != -1)
+            normal[enterAxis] = -step[enterAxis];
+        float t = tEnter;
+        while (true) {
+            result.steps++;
+            if (voxels.Get(cell[0], cell[1], cell[2]) != VoxelType::EMPTY) {
+                result = { true, false, cell[0], cell[2], cell[1], normal, t, result.steps };
+                return result;
+            }
+
+            int a = tMax[0] < tMax[1] ? 0 : 1;
+            if (tMax[2] < tMax[a])
+                a = 2;
+            cell[a] += step[a];
+            t = tMax[a];
+            tMax[a] += tDelta[a];
+            normal = { 0, 0, 0 };
+            normal[a] = -step[a];
+
+            if (a == 1 && cell[1] < 0) {
+                result = { true, true, cell[0], cell[2], -1, normal, t, result.steps };
+                return result;
+            }
+            if (cell[a] < (int)boxMin[a] || cell[a] >= (int)boxMax[a])
+                return result;
+        }
+    }
+
+}
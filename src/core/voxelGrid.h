@@ -0,0 +1,148 @@
+#ifndef VOXEL_GRID_H
+#define VOXEL_GRID_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class VoxelType : uint8_t {
+    EMPTY,
+    BLOCK,
+    RAMP_DOWN, // ramps rise towards where a roll in that Rotation goes, DOWN is +z
+    RAMP_UP,
+    RAMP_LEFT,
+    RAMP_RIGHT
+};
+
+// name, glyph and color of each type are in core::voxelInfo (tileRules.h)
+static constexpr int numVoxelTypes = 6;
+
+// 32x32 columns of numLayers voxels, same footprint and chunk index as a TileChunk
+struct VoxelChunk {
+    static constexpr int shift = 5;
+    static constexpr int side = 1 << shift;
+    static constexpr int numLayers = 16;
+    static constexpr int layerCells = side * side;
+    static constexpr int numCells = layerCells * numLayers;
+
+    std::array<uint8_t, numCells> cells; // VoxelType, layer major, then row major inside the layer
+    int numSolid; // non empty voxels
+};
+
+/*
+    What stands on top of the tiles: blocks and ramps stacked up to numLayers high.
+
+    Layer 0 is the one the cube rolls through, a voxel there is a wall it can't enter.
+    The layers above are scenery for now, the cube never leaves the tile plane.
+
+    Chunks cover the same padded grid as the TileGrid of the level, so a chunk index
+    means the same in both. Only chunks with a voxel in them exist, and like the tile
+    chunks they are shared between copies of the grid until one of them writes to it.
+    A grid without any voxel doesn't even have the chunk directory, most levels are like that.
+*/
+class VoxelGrid {
+public:
+    static constexpr int numLayers = VoxelChunk::numLayers;
+
+    VoxelGrid() :
+        m_Chunks(),
+        m_Count(0),
+        m_SideLength(0),
+        m_Offset(0),
+        m_ChunksPerRow(0)
+    { }
+
+    explicit VoxelGrid(int sideLength);
+
+    // centered tile coords, EMPTY outside the grid and above the top layer
+    VoxelType Get(int tileX, int layer, int tileZ) const;
+    // ignored outside the grid
+    void Set(int tileX, int layer, int tileZ, VoxelType type);
+    void Clear();
+
+    // number of layers up to and including the top voxel of the column, 0 if it has none
+    int ColumnHeight(int tileX, int tileZ) const;
+
+    // fast path for the rules, a voxel on layer 0 of the tile. Valid up to one tile outside the grid
+    inline bool Blocks(int tileX, int tileZ) const {
+        if (m_Chunks.empty())
+            return false;
+        const int px = tileX + m_Offset + 1;
+        const int pz = tileZ + m_Offset + 1;
+        const VoxelChunk* chunk = m_Chunks[(pz >> VoxelChunk::shift) * m_ChunksPerRow + (px >> VoxelChunk::shift)].get();
+        return chunk != nullptr && chunk->cells[CellIndex(px, 0, pz)] != (uint8_t)VoxelType::EMPTY;
+    }
+
+    // nullptr for chunks without a voxel
+    inline const VoxelChunk* GetChunk(int chunkIx) const {
+        return m_Chunks.empty() ? nullptr : m_Chunks[chunkIx].get();
+    }
+
+    inline int Count() const {
+        return m_Count;
+    }
+
+    // same as TileGrid::SharesChunk()
+    inline bool SharesChunk(const VoxelGrid& other, int chunkIx) const {
+        return GetChunk(chunkIx) == other.GetChunk(chunkIx);
+    }
+
+    inline int GetSideLength() const {
+        return m_SideLength;
+    }
+
+    inline int GetPaddedOffset() const {
+        return m_Offset + 1;
+    }
+
+    inline int GetChunksPerRow() const {
+        return m_ChunksPerRow;
+    }
+
+    inline int GetNumChunks() const {
+        return m_ChunksPerRow * m_ChunksPerRow;
+    }
+
+    // cell of a voxel inside its chunk, from padded coords
+    static inline int CellIndex(int px, int layer, int pz) {
+        return layer * VoxelChunk::layerCells + (pz & (VoxelChunk::side - 1)) * VoxelChunk::side + (px & (VoxelChunk::side - 1));
+    }
+
+    size_t GetMemoryUsage() const;
+
+private:
+    // the chunk, allocated or copied first if another grid still holds it
+    VoxelChunk& MutableChunk(int chunkIx);
+
+    std::vector<std::shared_ptr<VoxelChunk>> m_Chunks; // chunk directory, empty while there is no voxel
+    int m_Count;
+    int m_SideLength;
+    int m_Offset; // sideLength / 2, the same as TileGrid
+    int m_ChunksPerRow;
+};
+
+namespace core {
+    struct RayHit {
+        bool hit;
+        bool floor; // hit the tile plane at y = 0 rather than a voxel
+        int x; // centered tile coords of the column
+        int z;
+        int layer; // -1 for the floor
+        std::array<int, 3> normal; // of the face the ray went in through
+        float distance; // along the ray, in units of its direction
+        int steps; // cells visited, for the benchmarks
+    };
+
+    /*
+        Amanatides & Woo grid traversal: walks the cells the ray goes through in order
+        and stops at the first voxel, so it costs the length of the ray inside the grid
+        and nothing else. The box is the grid from the floor up to the top layer, a ray
+        that leaves it through the floor hits the tile under it, empty tile or not, that
+        is what the editor picks.
+    */
+    RayHit raycast(const VoxelGrid& voxels, const std::array<float, 3>& origin, const std::array<float, 3>& direction);
+}
+
+#endif // VOXEL_GRID_H
@@ -1,4 +1,4 @@
-#include <fstream>
+#include <algorithm>
 #include <iostream>
 #include <filesystem>
 #include <unordered_set>
@@ -8,20 +8,12 @@
 #include "imgui.h"
 #include "shader.h"
 #include "utils.h"
+#include "core/rules.h"
+#include "core/levelFile.h"
+#include "core/tileRules.h"
 
 #define LEVEL_STR(levelNum) (std::format(ABS_PATH("/res/levels/level_{}.txt"), (levelNum) + 1).c_str())
 
-enum class Face {
-    U, F, D, B, L, R
-};
-
-struct LevelState {
-    std::vector<TileType> tiles;
-    glm::mat4 model;
-    std::array<Face, 6> playerRot;
-    glm::vec3 playerPos;
-};
-
 namespace levelEditor {
 
     // attributes
@@ -32,24 +24,41 @@ namespace levelEditor {
     Shader editorGridShader;
     Shader selectedTilesShader;
     Shader axisShader;
-    std::vector<TileQuad> gridVertices;
-    std::vector<TileQuad> selectedTilesVertices;
-    std::vector<uint32_t> gridIndices;
+    std::vector<LineVertex> gridLines;
     std::vector<uint32_t> selectedTilesIndices;
     std::unordered_set<int> selectedTiles;
     std::vector<LineVertex> axisLines;
     std::vector<Layout> layout = { { GL_FLOAT, 3 }, { GL_FLOAT, 3 } };
-    TileQuad castedTileQuad;
-    glm::vec3 axisOffset;
+    glm::vec3 gridLineColor;
     int gridSideLength;
     int numTiles;
     int gridOffset;
-    int castedTile = -1;
+    int newLevelSide; // side of the levels Reset and + make
     bool selectionNeedsUpdate = true;
-    TileType activeTileTypeButton = TileType::EMPTY_TILE;
 
     static int levelCounter = 0;
     static int currentLevel = -1;
+    static constexpr glm::vec3 selectedLinesColor = glm::vec3(0,0.7,1);
+
+    // one line per tile edge along each axis instead of a quad per tile, so that
+    // the grid of a 10000x10000 level stays at 20002 lines
+    static void buildGridLines() {
+        const float low = (float)-gridOffset;
+        const float high = (float)(gridSideLength - gridOffset);
+        gridLines.clear();
+        gridLines.reserve(2 * (gridSideLength + 1));
+        for (int i = 0; i <= gridSideLength; i++) {
+            const float at = (float)(i - gridOffset);
+            gridLines.push_back(LineVertex({
+                    Vertex{glm::vec3(at, 0.0f, low), gridLineColor},
+                    Vertex{glm::vec3(at, 0.0f, high), gridLineColor},
+                    }));
+            gridLines.push_back(LineVertex({
+                    Vertex{glm::vec3(low, 0.0f, at), gridLineColor},
+                    Vertex{glm::vec3(high, 0.0f, at), gridLineColor},
+                    }));
+        }
+    }
 
     // functions
     void Init(int sideLength, const glm::vec3& lineColor, const char* vertexShaderPath,
@@ -59,47 +68,18 @@ namespace levelEditor {
         gridSideLength = sideLength;
         gridOffset = gridSideLength / 2;
         numTiles = sideLength * sideLength;
-        static constexpr glm::vec3 selectedLinesColor = glm::vec3(0,0.7,1);
+        newLevelSide = sideLength;
+        gridLineColor = lineColor;
 
         // vertices
         {
-            gridVertices.reserve(numTiles);
-            selectedTiles.reserve(numTiles);
-            gridIndices = generateQuadLineIndices(numTiles);
-            selectedTilesIndices = generateQuadIndices(numTiles);
-
-            // editor lines data
-            for (int z = 0; z < sideLength; z++) {
-                for (int x = 0; x < sideLength; x++) {
-                    gridVertices.push_back({
-                            Vertex{glm::vec3(x - gridOffset, 0.0f, z - gridOffset), lineColor},
-                            Vertex{glm::vec3(x + 1 - gridOffset, 0.0f, z - gridOffset), lineColor},
-                            Vertex{glm::vec3(x + 1 - gridOffset, 0.0f, z + 1 - gridOffset), lineColor},
-                            Vertex{glm::vec3(x - gridOffset, 0.0f, z + 1 - gridOffset), lineColor}
-                            });
-
-                    selectedTilesVertices.push_back({
-                            Vertex{glm::vec3(x - gridOffset, 0.01f, z - gridOffset), selectedLinesColor},
-                            Vertex{glm::vec3(x + 1 - gridOffset, 0.01f, z - gridOffset), selectedLinesColor},
-                            Vertex{glm::vec3(x + 1 - gridOffset, 0.01f, z + 1 - gridOffset), selectedLinesColor},
-                            Vertex{glm::vec3(x - gridOffset, 0.01f, z + 1 - gridOffset), selectedLinesColor}
-                            });
-                }
-            }
-
-            castedTileQuad = {
-                Vertex{glm::vec3(0), glm::vec3(0, 1, 0)},
-                Vertex{glm::vec3(0), glm::vec3(0, 1, 0)},
-                Vertex{glm::vec3(0), glm::vec3(0, 1, 0)},
-                Vertex{glm::vec3(0), glm::vec3(0, 1, 0)},
-            };
+            buildGridLines();
 
             // axis lines
             static constexpr float halfLength = 1000.0f;
             glm::vec3 axisRed = hexToRgb(AXIS_RED);
             glm::vec3 axisGreen = hexToRgb(AXIS_GREEN);
             glm::vec3 axisBlue = hexToRgb(AXIS_BLUE);
-            axisOffset = glm::vec3(0);
 
             axisLines = {
                 LineVertex({
@@ -120,24 +100,15 @@ namespace levelEditor {
         // meshes
         {
             editorGridMesh = Mesh(
-                    gridVertices.data(),
-                    gridVertices.size() * TileQuad::numVertices,
-                    gridVertices.size() * sizeof(TileQuad),
-                    layout,
-                    GL_STATIC_DRAW,
-                    gridIndices.data(),
-                    gridIndices.size(),
-                    gridIndices.size() * sizeof(uint32_t));
-
-            selectedTilesMesh = Mesh(
-                    selectedTilesVertices.data(),
-                    selectedTilesVertices.size() * TileQuad::numVertices,
-                    selectedTilesVertices.size() * sizeof(TileQuad),
+                    gridLines.data(),
+                    gridLines.size() * LineVertex::numVertices,
+                    gridLines.size() * sizeof(LineVertex),
                     layout,
-                    GL_DYNAMIC_DRAW,
-                    selectedTilesIndices.data(),
-                    selectedTilesIndices.size(),
-                    selectedTilesIndices.size() * sizeof(uint32_t));
+                    GL_STATIC_DRAW);
+
+            // sized by Update() to whatever is selected
+            selectedTilesMesh = Mesh(nullptr, TileQuad::numVertices,
+                    sizeof(TileQuad), layout, GL_DYNAMIC_DRAW);
 
             castedTileMesh = Mesh(nullptr, TileQuad::numVertices,
                     sizeof(TileQuad), layout, GL_DYNAMIC_DRAW);
@@ -163,7 +134,37 @@ namespace levelEditor {
             levelCounter++;
     }
 
-    void Update() {
+    void Resize(int sideLength) {
+        if (sideLength == gridSideLength)
+            return;
+        gridSideLength = sideLength;
+        gridOffset = gridSideLength / 2;
+        numTiles = sideLength * sideLength;
+        buildGridLines();
+        editorGridMesh.SetBufferData(gridLines.size() * LineVertex::numVertices,
+                gridLines.size() * sizeof(LineVertex), gridLines.data(), GL_STATIC_DRAW);
+        selectedTiles.clear();
+        selectionNeedsUpdate = true;
+    }
+
+    TileQuad MakeTileQuad(int tileIx, float y, const glm::vec3& color) {
+        const float x = (float)(tileIx % gridSideLength - gridOffset);
+        const float z = (float)(tileIx / gridSideLength - gridOffset);
+        return {
+            Vertex{glm::vec3(x, y, z), color},
+            Vertex{glm::vec3(x + 1, y, z), color},
+            Vertex{glm::vec3(x + 1, y, z + 1), color},
+            Vertex{glm::vec3(x, y, z + 1), color}
+        };
+    }
+
+    void SetCursor(Cursor& cursor, int tileIx, float y, const glm::vec3& color) {
+        cursor.tile = tileIx;
+        cursor.quad = MakeTileQuad(tileIx, y, color);
+        castedTileMesh.UpdateBufferData(0, TileQuad::numVertices, sizeof(TileQuad), &cursor.quad);
+    }
+
+    void Update(const LevelState& levelState) {
         // super inefficient but who cares, it's just the editor
         if (selectionNeedsUpdate) {
             selectionNeedsUpdate = false;
@@ -171,41 +172,73 @@ namespace levelEditor {
             const int numSelected = selectedTiles.size();
             currentSelectedVertices.reserve(numSelected);
 
+            // on top of whatever is stacked on the tile
             for (int tileIx : selectedTiles) {
-                currentSelectedVertices.push_back(selectedTilesVertices[tileIx]);
+                const int height = levelState.voxels.ColumnHeight(tileIx % gridSideLength - gridOffset,
+                        tileIx / gridSideLength - gridOffset);
+                currentSelectedVertices.push_back(MakeTileQuad(tileIx, height + 0.01f, selectedLinesColor));
             }
 
             selectedTilesIndices = generateQuadIndices(numSelected);
 
-            selectedTilesMesh.UpdateBufferData(0, currentSelectedVertices.size(),
-                    currentSelectedVertices.size() * sizeof(TileQuad), currentSelectedVertices.data());
-            selectedTilesMesh.UpdateElementBufferData(0, selectedTilesIndices.size(),
+            selectedTilesMesh.SetBufferData(currentSelectedVertices.size() * TileQuad::numVertices,
+                    currentSelectedVertices.size() * sizeof(TileQuad), currentSelectedVertices.data(),
+                    GL_DYNAMIC_DRAW);
+            selectedTilesMesh.SetElementBufferData(selectedTilesIndices.size(),
                     selectedTilesIndices.size() * sizeof(uint32_t), selectedTilesIndices.data());
         }
     }
 
-    static void AddTiles(TileType tileType, std::vector<TileType>& tiles) {
+    static void AddTiles(TileType tileType, TileGrid& tiles, Edits& edits) {
+        // tile by tile, the grid allocates its chunks as they get painted
+        for (int tileIx : selectedTiles) {
+            if (tiles.Get(tileIx) != tileType) {
+                tiles.Set(tileIx, tileType);
+                edits.tiles.push_back(tileIx);
+            }
+        }
         if (selectedTiles.size() > 0) {
-            for (int tileIx : selectedTiles)
-                tiles[tileIx] = tileType;
             selectedTiles.clear();
             selectionNeedsUpdate = true;
         }
     }
 
+    // one voxel on top of every selected column, the selection stays so it can be stacked again
+    static void StackVoxels(VoxelType voxelType, VoxelGrid& voxels, Edits& edits) {
+        for (int tileIx : selectedTiles) {
+            const int x = tileIx % gridSideLength - gridOffset;
+            const int z = tileIx / gridSideLength - gridOffset;
+            const int height = voxels.ColumnHeight(x, z);
+            if (height < VoxelGrid::numLayers) {
+                voxels.Set(x, height, z, voxelType);
+                edits.columns.push_back(tileIx);
+            }
+        }
+        selectionNeedsUpdate = true;
+    }
+
+    static void UnstackVoxels(VoxelGrid& voxels, Edits& edits) {
+        for (int tileIx : selectedTiles) {
+            const int x = tileIx % gridSideLength - gridOffset;
+            const int z = tileIx / gridSideLength - gridOffset;
+            const int height = voxels.ColumnHeight(x, z);
+            if (height > 0) {
+                voxels.Set(x, height - 1, z, VoxelType::EMPTY);
+                edits.columns.push_back(tileIx);
+            }
+        }
+        selectionNeedsUpdate = true;
+    }
+
     static void ResetLevelState(LevelState& levelState) {
-        std::fill(levelState.tiles.begin(), levelState.tiles.end(), TileType::EMPTY_TILE);
-        levelState.model = glm::mat4({
-                1, 0, 0, 0,
-                0, 1, 0, 0,
-                0, 0, 1, 0,
-                0.5, 0.5, 0.5, 1
-                });
-        levelState.playerRot = { Face::U, Face::F, Face::D, Face::B, Face::L, Face::R };
-        levelState.playerPos = glm::vec3(0.0f);
+        levelState = core::makeLevelState(newLevelSide);
+        Resize(newLevelSide);
     }
 
     void Render(const glm::mat4& mvp,
+            const glm::vec3& axisOffset,
+            Cursor& cursor,
+            Edits& edits,
             bool& tilesNeedUpdate,
             LevelState& levelState) {
         // render tile grid
@@ -213,10 +246,10 @@ namespace levelEditor {
         editorGridShader.SetUniformMatrix4fv("mvp", mvp);
         editorGridMesh.BindVao();
         glLineWidth(1);
-        glDrawElements(GL_LINES, editorGridMesh.GetNumIndices(), GL_UNSIGNED_INT, 0);
+        glDrawArrays(GL_LINES, 0, editorGridMesh.GetNumVertices());
 
         // render raycasted tile
-        if (castedTile != -1) {
+        if (cursor.tile != -1) {
             castedTileMesh.BindVao();
             glLineWidth(4);
             glDisable(GL_DEPTH_TEST);
@@ -245,54 +278,44 @@ namespace levelEditor {
 
             // tiles buttons
             ImGui::SeparatorText("Edit tiles");
-            if (ImGui::Button("Empty")) {
-                AddTiles(TileType::EMPTY_TILE, levelState.tiles);
-                tilesNeedUpdate = true;
+            for (int t = 0; t < numTileTypes; t++) {
+                if (t > 0)
+                    ImGui::SameLine();
+                if (ImGui::Button(core::tileInfo[t].name))
+                    AddTiles(static_cast<TileType>(t), levelState.tiles, edits);
             }
 
-            ImGui::SameLine();
-            if (ImGui::Button("Ground")) {
-                AddTiles(TileType::GROUND_TILE, levelState.tiles);
-                tilesNeedUpdate = true;
-            }
-
-            ImGui::SameLine();
-            if (ImGui::Button("Dark")) {
-                AddTiles(TileType::DARK_TILE, levelState.tiles);
-                tilesNeedUpdate = true;
-            }
-
-            ImGui::SameLine();
-            if (ImGui::Button("Light")) {
-                AddTiles(TileType::LIGHT_TILE, levelState.tiles);
-                tilesNeedUpdate = true;
+            // voxels buttons, a voxel on the bottom layer is a wall
+            ImGui::SeparatorText("Stack voxels");
+            for (int t = 1; t < numVoxelTypes; t++) {
+                if (t > 1)
+                    ImGui::SameLine();
+                if (ImGui::Button(core::voxelInfo[t].name))
+                    StackVoxels(static_cast<VoxelType>(t), levelState.voxels, edits);
             }
-
             ImGui::SameLine();
-            if (ImGui::Button("Target OFF")) {
-                AddTiles(TileType::TARGET_OFF_TILE, levelState.tiles);
-                tilesNeedUpdate = true;
-            }
-
-            ImGui::SameLine();
-            if (ImGui::Button("Target ON")) {
-                AddTiles(TileType::TARGET_ON_TILE, levelState.tiles);
-                tilesNeedUpdate = true;
-            }
+            if (ImGui::Button("Remove top"))
+                UnstackVoxels(levelState.voxels, edits);
 
 
             // levels buttons
             ImGui::SeparatorText("Level");
+            ImGui::Text("%dx%d, %d of %d chunks allocated, %.1f MB", gridSideLength, gridSideLength,
+                    levelState.tiles.GetNumAllocatedChunks(), levelState.tiles.GetNumChunks(),
+                    levelState.tiles.GetMemoryUsage() / (1024.0 * 1024.0));
+            ImGui::Text("%d voxels, %.1f MB", levelState.voxels.Count(),
+                    levelState.voxels.GetMemoryUsage() / (1024.0 * 1024.0));
+            ImGui::SetNextItemWidth(120);
+            if (ImGui::InputInt("Side of new levels", &newLevelSide))
+                newLevelSide = std::clamp(newLevelSide, 1, core::maxLevelSide);
             if (ImGui::Button("Reset")) {
                 ResetLevelState(levelState);
                 tilesNeedUpdate = true;
             }
 
             ImGui::SameLine();
-            if (ImGui::Button("Save")) {
+            if (ImGui::Button("Save"))
                 SaveCurrentLevel(levelState);
-                tilesNeedUpdate = true;
-            }
 
             ImGui::Separator();
 
@@ -312,7 +335,7 @@ namespace levelEditor {
 
                 if (pressed) {
                     currentLevel = i;
-                    LoadLevelFromFile(LEVEL_STR(currentLevel) , levelState);
+                    LoadLevelFromFile(LEVEL_STR(currentLevel), levelState);
                     tilesNeedUpdate = true;
                 }
             }
@@ -326,6 +349,10 @@ namespace levelEditor {
 
             ImGui::End();
         }
+
+        // the tile it was on may not even exist in the new level
+        if (tilesNeedUpdate)
+            cursor.tile = -1;
     }
 
     int GetTileIndex(int tileX, int tileZ) {
@@ -338,232 +365,34 @@ namespace levelEditor {
             return -1;
     }
 
-    void AddCastedToSelected() {
-        selectedTiles.insert(castedTile);
+    void AddCastedToSelected(const Cursor& cursor) {
+        selectedTiles.insert(cursor.tile);
         selectionNeedsUpdate = true;
     }
 
-    void RemoveCastedFromSelected() {
-        selectedTiles.erase(castedTile);
+    void RemoveCastedFromSelected(const Cursor& cursor) {
+        selectedTiles.erase(cursor.tile);
         selectionNeedsUpdate = true;
     }
 
     void LoadLevelFromFile(const char* filePath, LevelState& levelState) {
-        std::ifstream inputFile(filePath);
-
-        if (!inputFile) {
-            LOG_ERROR("Failed to read {}", filePath);
+        LevelState loaded = levelState;
+        std::string error;
+        if (!core::loadLevelFile(filePath, loaded, error)) {
+            LOG_ERROR("Error while loading level file {}: {}", filePath, error);
             exit(EXIT_FAILURE);
         }
 
-        std::string line;
-        int lineCounter = 0;
-        int tileCounter = 0;
-        while (std::getline(inputFile, line)) {
-            if (lineCounter == 0) {
-                // load pos
-                int numParsed = 0;
-                size_t i = 0;
-                while (i < line.length()) {
-                    char c = line[i];
-                    switch (c) {
-                        case '(':
-                        case ')':
-                        case ',':
-                        case ' ':
-                            i++;
-                            break;
-                        default:
-                            // parse number
-                            {
-                                size_t start = i;
-                                while (i < line.length() - 1 &&
-                                        line[i + 1] != ',' &&
-                                        line[i + 1] != ')' &&
-                                        line[i + 1] != ' ') {
-                                    i++;
-                                }
-                                size_t numLen = i - start + 1;
-                                std::string numStr = line.substr(start, numLen);
-                                if (numParsed > 2) {
-                                    LOG_ERROR("Error while loading level file, player position is invalid");
-                                }
-                                levelState.playerPos[numParsed++] = std::stof(numStr);
-                                i++;
-                            }
-                            break;
-                    }
-                }
-            } else if (lineCounter == 1) {
-                // load cubeState
-                int numParsed = 0;
-                size_t i = 0;
-                while (i < line.length()) {
-                    char c = line[i];
-                    switch (c) {
-                        case '(':
-                        case ')':
-                        case ',':
-                        case ' ':
-                            i++;
-                            break;
-                        default:
-                            // parse number
-                            {
-                                size_t start = i;
-                                while (i < line.length() - 1 &&
-                                        line[i + 1] != ',' &&
-                                        line[i + 1] != ')' &&
-                                        line[i + 1] != ' ') {
-                                    i++;
-                                }
-                                size_t numLen = i - start + 1;
-                                std::string numStr = line.substr(start, numLen);
-                                if (numParsed > 5) {
-                                    LOG_ERROR("Error while loading level file, player rotation is invalid");
-                                }
-                                levelState.playerRot[numParsed++] = static_cast<Face>(std::stoi(numStr));
-                                i++;
-                            }
-                            break;
-                    }
-                }
-
-            } else if (lineCounter == 2) {
-                // load model matrix
-                int numParsed = 0;
-                size_t i = 0;
-                while (i < line.length()) {
-                    char c = line[i];
-                    switch (c) {
-                        case '[':
-                        case ']':
-                        case ',':
-                        case ' ':
-                            i++;
-                            break;
-                        default:
-                            // parse number
-                            {
-                                size_t start = i;
-                                while (i < line.length() - 1 &&
-                                        line[i + 1] != ',' &&
-                                        line[i + 1] != '[' &&
-                                        line[i + 1] != ']' &&
-                                        line[i + 1] != ' ') {
-                                    i++;
-                                }
-                                size_t numLen = i - start + 1;
-                                std::string numStr = line.substr(start, numLen);
-                                if (numParsed > 15) {
-                                    LOG_ERROR("Error while loading level file, model matrix is invalid");
-                                }
-                                int row = numParsed / 4;
-                                int col = numParsed % 4;
-                                levelState.model[row][col] = std::stof(numStr);
-                                numParsed++;
-                                i++;
-                            }
-                            break;
-                    }
-                }
-            } else {
-                // load tile map
-                for (char c : line) {
-                    switch (c) {
-                        case '.':
-                            levelState.tiles[tileCounter++] = TileType::EMPTY_TILE;
-                            break;
-                        case '#':
-                            levelState.tiles[tileCounter++] = TileType::GROUND_TILE;
-                            break;
-                        case 'D':
-                            levelState.tiles[tileCounter++] = TileType::DARK_TILE;
-                            break;
-                        case 'L':
-                            levelState.tiles[tileCounter++] = TileType::LIGHT_TILE;
-                            break;
-                        case 'O':
-                            levelState.tiles[tileCounter++] = TileType::TARGET_OFF_TILE;
-                            break;
-                        case 'T':
-                            levelState.tiles[tileCounter++] = TileType::TARGET_ON_TILE;
-                            break;
-                        default:
-                            break;
-                    }
-                }
-            }
-            lineCounter++;
-        }
+        // the editor grid follows the level
+        Resize(loaded.tiles.GetSideLength());
+        levelState = std::move(loaded);
     }
 
-    void SaveLevelToFile(const char* filePath, const LevelState& levelState, int rowLength) {
-        std::ofstream outputFile(filePath);
-
-        if (!outputFile) {
+    void SaveLevelToFile(const char* filePath, const LevelState& levelState) {
+        if (!core::saveLevelFile(filePath, levelState)) {
             LOG_ERROR("Failed at creating file {}", filePath);
             exit(EXIT_FAILURE);
         }
-
-        // save player pos
-        outputFile << "(" << levelState.playerPos[0] << ",";
-        outputFile << levelState.playerPos[1] << ",";
-        outputFile << levelState.playerPos[2] << ")\n";
-
-        // save player orientation (cube state)
-        outputFile << "(";
-        for (int i = 0; i < 6; i++) {
-            outputFile << (int)levelState.playerRot[i];
-            if (i != 5)
-                outputFile << ",";
-        }
-        outputFile << ")\n";
-
-        // save player orientation (model matrix)
-        outputFile << "[";
-        for (int i = 0; i < 4; i++) {
-            outputFile << "[";
-            for (int j = 0; j < 4; j++) {
-                outputFile << levelState.model[i][j];
-                if (j != 3)
-                    outputFile << ",";
-            }
-            outputFile << "]";
-            if (i != 3)
-                outputFile << ",";
-        }
-        outputFile << "]\n";
-
-        // save tiles map
-        int colCounter = 0;
-        for (auto tile : levelState.tiles) {
-            switch (tile) {
-                case TileType::EMPTY_TILE:
-                    outputFile << ".";
-                    break;
-                case TileType::GROUND_TILE:
-                    outputFile << "#";
-                    break;
-                case TileType::DARK_TILE:
-                    outputFile << "D";
-                    break;
-                case TileType::LIGHT_TILE:
-                    outputFile << "L";
-                    break;
-                case TileType::TARGET_OFF_TILE:
-                    outputFile << "O";
-                    break;
-                case TileType::TARGET_ON_TILE:
-                    outputFile << "T";
-                    break;
-            }
-            colCounter++;
-            if (colCounter == rowLength) {
-                outputFile << "\n";
-                colCounter = 0;
-            }
-        }
     }
 
     void SaveCurrentLevel(LevelState& levelState) {
@@ -571,8 +400,7 @@ namespace levelEditor {
         // but in this case maybe having a global state here makes more sense 
         // than having it in main
         if (currentLevel != -1) {
-            static constexpr int sideNum = 100;
-            SaveLevelToFile(LEVEL_STR(currentLevel), levelState, sideNum);
+            SaveLevelToFile(LEVEL_STR(currentLevel), levelState);
         }
     }
 
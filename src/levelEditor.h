@@ -4,17 +4,7 @@
 #include <vector>
 #include "mesh.h"
 #include <glm/glm.hpp>
-
-enum class TileType {
-    EMPTY_TILE,
-    GROUND_TILE,
-    DARK_TILE,
-    LIGHT_TILE,
-    TARGET_OFF_TILE,
-    TARGET_ON_TILE
-};
-
-struct LevelState;
+#include "core/levelState.h"
 
 namespace levelEditor {
     /* namespace { */
@@ -42,25 +32,40 @@ namespace levelEditor {
         Vertex tileVertices[numVertices]; // mesh
     };
 
+    // the tile under the mouse, a component of the editor entity (see main.cpp)
+    struct Cursor {
+        int tile = -1; // -1 for none
+        TileQuad quad;
+    };
+
+    // what the editor changed since main last looked, on the editor entity too. Tiles are
+    // single tile edits, columns voxel edits (as the tile index of the column)
+    struct Edits {
+        std::vector<int> tiles;
+        std::vector<int> columns;
+    };
+
     void Init(int sideLength, const glm::vec3& lineColor, const char* vertexShaderPath,
             const char* fragmentShaderPath, const char* selectedFragmentShaderPath,
             const char* axisVertexShaderPath);
+    // rebuilds the grid for a level of another size, drops the selection
+    void Resize(int sideLength);
     void GetSideLength();
     int GetTileIndex(int tileX, int tileZ);
-    void AddCastedToSelected();
-    void RemoveCastedFromSelected();
-    void Update();
-    void Render(const glm::mat4& mvp, bool& tilesNeedUpdate, LevelState& levelState); 
+    TileQuad MakeTileQuad(int tileIx, float y, const glm::vec3& color);
+    // puts the cursor on a tile, drawn at height y
+    void SetCursor(Cursor& cursor, int tileIx, float y, const glm::vec3& color);
+    void AddCastedToSelected(const Cursor& cursor);
+    void RemoveCastedFromSelected(const Cursor& cursor);
+    // the selection is drawn on top of the voxel columns
+    void Update(const LevelState& levelState);
+    // tilesNeedUpdate: the whole level changed (and the cursor is taken off it), anything
+    // smaller goes to edits
+    void Render(const glm::mat4& mvp, const glm::vec3& axisOffset, Cursor& cursor, Edits& edits,
+            bool& tilesNeedUpdate, LevelState& levelState);
     void LoadLevelFromFile(const char* path, LevelState& levelState);
-    void SaveLevelToFile(const char* filePath, const LevelState& levelState, int rowLength);
+    void SaveLevelToFile(const char* filePath, const LevelState& levelState);
     void SaveCurrentLevel(LevelState& levelState);
-
-    extern Mesh castedTileMesh;
-    extern TileQuad castedTileQuad;
-    extern int castedTile;
-    extern std::vector<TileQuad> gridVertices;
-    extern glm::vec3 axisOffset;
-    extern TileType activeTileTypeButton;
 }
 
 #endif // EDITOR_TILE_H
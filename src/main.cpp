@@ -2,9 +2,19 @@
 #include <SDL_mouse.h>
 #include <SDL_stdinc.h>
 #include <SDL_video.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
 #include <SDL2/SDL.h>
+#include <glm/gtc/type_ptr.hpp>
 #include "render.h"
 #include "utils.h"
 #include "shader.h"
@@ -12,6 +22,18 @@
 #include "camera.h"
 #include "logger.h"
 #include "levelEditor.h"
+#include "tileMeshes.h"
+#include "core/rules.h"
+#include "core/simulation.h"
+#include "core/replay.h"
+#include "core/chunkStreamer.h"
+#include "core/cubeSwarm.h"
+#include "core/entityStore.h"
+#include "core/levelFile.h"
+#include "core/levelPublisher.h"
+#include "core/tileRules.h"
+#include "core/tweens.h"
+#include "server/server.h"
 // imgui
 #include "imgui.h"
 #include "imgui_impl_sdl2.h"
@@ -29,118 +51,194 @@
 #define SDL_ERROR() LOG_ERROR("SDL_Error: {}", SDL_GetError())
 
 
-enum class Rotation {
-    DOWN,
-    UP,
-    LEFT,
-    RIGHT
-};
+template <typename T>
+T* SDL(T* ptr) {
+    if (ptr == nullptr) {
+        SDL_ERROR();
+        exit(EXIT_FAILURE);
+    }
+    return ptr;
+}
 
-enum class Orientation {
-    UP,
-    FRONT,
-    DOWN,
-    BACK,
-    LEFT,
-    RIGHT
-};
+// replays are named after the hash of the level they were played on
+static std::string replayPath(uint64_t levelHash) {
+    return std::format(ABS_PATH("/res/replays/{:016x}.replay"), levelHash);
+}
 
-enum class Face {
-    U, F, D, B, L, R
-};
+static void saveReplay(const core::ReplayRecorder& recorder) {
+    if (recorder.GetNumMoves() == 0)
+        return;
+    std::filesystem::create_directories(ABS_PATH("/res/replays"));
+    std::string path = replayPath(recorder.GetLevelHash());
+    if (recorder.Save(path))
+        LOG_INFO("Saved replay of {} moves to {}", recorder.GetNumMoves(), path);
+    else
+        LOG_ERROR("Failed to save replay to {}", path);
+}
 
-static void turn(std::array<Face, 6>& state, Rotation rotation) {
-    switch (rotation) {
+// exact cube transform from the orientation table, the mesh is centered on the origin
+static glm::mat4 poseModel(const CubePose& pose) {
+    glm::mat4 model = glm::make_mat4(core::orientationTables.matrices[pose.orientation].data());
+    model[3] = glm::vec4(pose.x + 0.5f, 0.5f, pose.z + 0.5f, 1.0f);
+    return model;
+}
+
+// cube transform part way through a roll, pivoting around the bottom edge it rolls over
+static glm::mat4 rollModel(const core::RollSnapshot& roll) {
+    glm::vec3 axis;
+    float angle;
+    glm::vec3 translationAxis;
+    switch (roll.rotation) {
         case Rotation::DOWN:
-            {
-                Face temp = state[0];
-                state[0] = state[3];
-                state[3] = state[2];
-                state[2] = state[1];
-                state[1] = temp;
-            }
+            axis = glm::vec3(1,0,0);
+            angle = 90.0f;
+            translationAxis = glm::vec3(0, 0.5, -0.5);
             break;
         case Rotation::UP:
-            {
-                Face temp = state[0];
-                state[0] = state[1];
-                state[1] = state[2];
-                state[2] = state[3];
-                state[3] = temp;
-            }
+            axis = glm::vec3(1,0,0);
+            angle = -90.0f;
+            translationAxis = glm::vec3(0, 0.5, 0.5);
             break;
         case Rotation::LEFT:
-            {
-                Face temp = state[0];
-                state[0] = state[5];
-                state[5] = state[2];
-                state[2] = state[4];
-                state[4] = temp;
-            }
+            axis = glm::vec3(0,0,1);
+            angle = 90.0f;
+            translationAxis = glm::vec3(0.5, 0.5, 0);
             break;
         case Rotation::RIGHT:
-            {
-                Face temp = state[0];
-                state[0] = state[4];
-                state[4] = state[2];
-                state[2] = state[5];
-                state[5] = temp;
-            }
-            break;
         default:
+            axis = glm::vec3(0,0,1);
+            angle = -90.0f;
+            translationAxis = glm::vec3(-0.5, 0.5, 0);
             break;
     }
+
+    static constexpr glm::vec3 absoluteTrans = glm::vec3(0.5f);
+    glm::vec3 origin = glm::vec3(roll.from.x, 0.0f, roll.from.z);
+    glm::mat4 trans = glm::translate(glm::mat4(1.0), - absoluteTrans - origin + translationAxis);
+    glm::mat4 transBack = glm::translate(glm::mat4(1.0), absoluteTrans + origin - translationAxis);
+    return transBack * glm::rotate(glm::mat4(1.0), glm::radians(roll.progress * angle), axis) * trans *
+        poseModel(roll.from);
 }
 
-template <typename T>
-T* SDL(T* ptr) {
-    if (ptr == nullptr) {
-        SDL_ERROR();
-        exit(EXIT_FAILURE);
-    }
-    return ptr;
+// per instance data of the cube mesh, see cubeInstancedShader.vert
+struct CubeInstance {
+    glm::mat4 model;
+    glm::vec3 tint;
+};
+
+// the cubes of a swarm all roll at once, progress is how far the last step is played
+static glm::mat4 swarmModel(const core::CubeSwarm& swarm, int cube, float progress) {
+    const CubePose pose = swarm.GetPose(cube);
+    if (!swarm.GetMoved()[cube] || progress >= 1.0f)
+        return poseModel(pose);
+    const Rotation rotation = static_cast<Rotation>(swarm.GetRotation()[cube]);
+    return rollModel({ true, core::unrollPose(pose, rotation), rotation, 0, progress });
 }
 
-struct Vertex {
-    glm::vec3 position;
-    glm::vec3 color;
-    glm::vec2 texture; // Probably I can cut this
+enum class SwarmMode {
+    IDLE,
+    FOLLOW, // a step the same way as every arrow key press
+    WANDER // random steps at the roll rate
 };
 
-struct Tile {
-    void SetColor(const glm::vec3& color) {
-        for (auto& vertex : tileVertices) {
-            vertex.color = color;
-        }
+// short lived tile animations, drawn with the cubes as thin slabs on top of the tiles
+enum class TileEffectKind {
+    FLIP, // a tile the cubes changed turns over, the tween is its angle
+    DROP, // the tiles of a loaded level fall into place, the tween is the height
+    HIGHLIGHT // a tile the editor changed, the tween is how much of the slab is left
+};
+
+struct TileEffect {
+    int tileIx;
+    TileEffectKind kind;
+    core::TweenId tween;
+    glm::vec3 tint;
+};
+
+static constexpr float tileDropHeight = 4.0f;
+
+static glm::mat4 tileEffectModel(const TileEffect& effect, float value, const LevelState& level) {
+    const int side = level.tiles.GetSideLength();
+    const int x = effect.tileIx % side - side / 2;
+    const int z = effect.tileIx / side - side / 2;
+    const float top = (float)level.voxels.ColumnHeight(x, z);
+    const glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x + 0.5f, top, z + 0.5f));
+    switch (effect.kind) {
+        case TileEffectKind::FLIP:
+            return glm::scale(glm::rotate(model, glm::radians(value), glm::vec3(1, 0, 0)), glm::vec3(0.9f, 0.05f, 0.9f));
+        case TileEffectKind::DROP:
+            return glm::scale(glm::translate(model, glm::vec3(0, value, 0)), glm::vec3(1.0f, 0.05f, 1.0f));
+        case TileEffectKind::HIGHLIGHT:
+        default:
+            return glm::scale(glm::translate(model, glm::vec3(0, 0.5f * (1.0f - value), 0)),
+                    glm::vec3(value, 0.05f, value));
     }
+}
 
-    static constexpr int numVertices = 4;
-    Vertex tileVertices[numVertices]; // mesh
+// top and bottom of the cube mesh are 0.3 grey, which is all a slab shows
+static glm::vec3 tileEffectTint(const glm::vec3& color) {
+    return color / 0.3f;
+}
+
+// components of the game's entities besides LevelState, Camera, core::CubeSwarm and the
+// editor's, see main()
+
+// on the level, set when all of it has to be remeshed
+struct TilesRedraw {
+    bool all;
 };
 
-struct LevelState {
-    std::vector<TileType> tiles;
-    glm::mat4 model;
-    std::array<Face, 6> playerRot;
-    glm::vec3 playerPos;
-} levelState = {
-    {},
-    glm::mat4({
-            1, 0, 0, 0,
-            0, 1, 0, 0,
-            0, 0, 1, 0,
-            0.5, 0.5, 0.5, 1
-            }),
-    { Face::U, Face::F, Face::D, Face::B, Face::L, Face::R },
-    glm::vec3(0.0f)};
-
-// game state globals
-bool tilesNeedUpdate = true;
-std::vector<Tile> currentGroundVertices;
+// the player's cube has a CubeInstance of its own, written every frame
+struct PlayerCube {};
 
+// a core::CubeSwarm's look and its roll in progress, 0..1
+struct SwarmCubes {
+    glm::vec3 tint;
+    core::TweenId roll;
+};
+
+// everything the cube mesh draws, every cube and tile effect is an instance
+static void gatherCubeInstances(core::EntityStore& entities, const core::TweenSystem& tweens,
+        const LevelState& level, std::vector<CubeInstance>& instances) {
+    instances.clear();
+    entities.Each<CubeInstance>([&](core::Entity, const CubeInstance& instance) {
+        instances.push_back(instance);
+    });
+    entities.Each<core::CubeSwarm, SwarmCubes>([&](core::Entity, const core::CubeSwarm& swarm, const SwarmCubes& look) {
+        const float progress = tweens.Get(look.roll, 1.0f);
+        for (int i = 0; i < swarm.GetNumCubes(); i++)
+            instances.push_back({ swarmModel(swarm, i, progress), look.tint });
+    });
+    entities.Each<TileEffect>([&](core::Entity, const TileEffect& effect) {
+        const float value = tweens.Get(effect.tween, 0.0f);
+        // dropping tiles wait for their turn out of sight
+        if (effect.kind == TileEffectKind::DROP && value >= tileDropHeight)
+            return;
+        instances.push_back({ tileEffectModel(effect, value, level), effect.tint });
+    });
+}
+
+// a saved replay played by a ghost cube, over and over
+struct Ghost {
+    std::unique_ptr<core::Replay> replay;
+    CubePose start;
+    int64_t cursor;
+};
 
 // TODO: face culling
-int main() {
+int main(int argc, char** argv) {
+    // headless mode for automated QA, nothing below (window, GL, editor) is needed
+    if (argc > 2 && std::string_view(argv[1]) == "--server")
+        return server::serverMain(argv[2], argc > 3 ? std::atoi(argv[3]) : 0);
+
+    // side of the empty level the game starts with, levels loaded later bring their own
+    int sideNum = 100;
+    const char* streamPath = nullptr;
+    if (argc > 2 && std::string_view(argv[1]) == "--side")
+        sideNum = std::clamp(std::atoi(argv[2]), 1, 32767);
+    else if (argc > 2 && std::string_view(argv[1]) == "--stream")
+        streamPath = argv[2];
+
     // no error checking
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         SDL_ERROR();
@@ -213,8 +311,8 @@ int main() {
     ImGui_ImplOpenGL3_Init();
 
 
-    glm::vec3 frontFaceColor = hexToRgb(LIGHT_TILE_COLOR);
-    glm::vec3 backFaceColor = hexToRgb(TARGET_ON_TILE_COLOR);
+    glm::vec3 frontFaceColor = hexToRgb(core::tileInfo[(int)TileType::LIGHT_TILE].color);
+    glm::vec3 backFaceColor = hexToRgb(core::tileInfo[(int)TileType::TARGET_ON_TILE].color);
     std::vector<Vertex> cubeVertices = {
         // up
         {glm::vec3(0.5f,  0.5f,  0.5f),  glm::vec3(0.3f, 0.3f, 0.3f),  glm::vec2(1.0f, 1.0f)},
@@ -254,34 +352,32 @@ int main() {
     };
 
 
-    // level tiles
-    static constexpr int sideNum = 100;
-    static constexpr int offset = sideNum / 2;
-    static constexpr int numTiles = sideNum * sideNum;
-    std::vector<Tile> tilesVertices;
-    tilesVertices.reserve(numTiles);
-    levelState.tiles = std::vector(numTiles, TileType::EMPTY_TILE);
-    currentGroundVertices.reserve(numTiles);
-
-    for (int z = 0; z < sideNum; z++) {
-        for (int x = 0; x < sideNum; x++) {
-            tilesVertices.push_back({
-                Vertex{glm::vec3(x - offset, 0.0f, z - offset),         glm::vec3(1.0f),  glm::vec2(0.0f, 0.0f)},
-                Vertex{glm::vec3(x + 1 - offset, 0.0f, z - offset),     glm::vec3(1.0f),  glm::vec2(1.0f, 0.0f)},
-                Vertex{glm::vec3(x + 1 - offset, 0.0f, z + 1 - offset), glm::vec3(1.0f),  glm::vec2(1.0f, 1.0f)},
-                Vertex{glm::vec3(x - offset, 0.0f, z + 1 - offset),     glm::vec3(1.0f),  glm::vec2(0.0f, 1.0f)}
-            });
+    // what the game is made of. The level, the camera, the editor, the player's cube and the two
+    // swarms live as long as the game and never change components, and nothing else shares their
+    // archetypes, so references to their components stay valid. Tile effects come and go
+    core::EntityStore entities;
+    const core::Entity level = entities.Create(core::makeLevelState(sideNum), TilesRedraw{ true });
+    LevelState& levelState = *entities.Get<LevelState>(level);
+    bool& tilesNeedUpdate = entities.Get<TilesRedraw>(level)->all;
+
+    // chunk files come in around the player instead of at once
+    core::ChunkStreamer streamer;
+    if (streamPath != nullptr) {
+        std::string error;
+        if (!streamer.Open(streamPath, levelState, error)) {
+            LOG_ERROR("Error while opening chunk file {}: {}", streamPath, error);
+            exit(EXIT_FAILURE);
         }
+        streamer.Prefetch(levelState.tiles, levelState.player.x, levelState.player.z);
     }
 
-    levelEditor::Init(sideNum, glm::vec3(0.5f), 
+    levelEditor::Init(levelState.tiles.GetSideLength(), glm::vec3(0.5f), 
             ABS_PATH("/res/shaders/editorTileShader.vert"),
             ABS_PATH("/res/shaders/editorTileShader.frag"),
             ABS_PATH("/res/shaders/selectedTileShader.frag"),
             ABS_PATH("/res/shaders/axisShader.vert"));
 
     std::vector<uint32_t> cubeIndices = generateQuadIndices(6);
-    std::vector<uint32_t> tilesIndices = generateQuadIndices(numTiles);
 
     std::vector<Layout> cubeLayout = {
         { GL_FLOAT, 3 },
@@ -289,12 +385,6 @@ int main() {
         { GL_FLOAT, 2 }
     };
 
-    std::vector<Layout> tilesLayout = {
-        { GL_FLOAT, 3 },
-        { GL_FLOAT, 3 },
-        { GL_FLOAT, 2 }
-    };
-
     Mesh cubeMesh = Mesh(
             cubeVertices.data(),
             cubeVertices.size(),
@@ -304,22 +394,23 @@ int main() {
             cubeIndices.data(),
             cubeIndices.size(),
             cubeIndices.size() * sizeof(uint32_t));
+    // the player, the swarm and the ghosts are all drawn with a single instanced draw
+    cubeMesh.SetInstanceLayout(3, {
+        { GL_FLOAT, 4 },
+        { GL_FLOAT, 4 },
+        { GL_FLOAT, 4 },
+        { GL_FLOAT, 4 },
+        { GL_FLOAT, 3 }
+    });
     
-    // TODO: dynamic or stream?
-    Mesh tilesMesh = Mesh(
-            tilesVertices.data(),
-            tilesVertices.size() * Tile::numVertices,
-            tilesVertices.size() * sizeof(Tile),
-            tilesLayout,
-            GL_DYNAMIC_DRAW,
-            tilesIndices.data(),
-            tilesIndices.size(),
-            tilesIndices.size() * sizeof(uint32_t));
+    // one mesh per chunk of the level, rebuilt only where tiles change
+    TileMeshes tileMeshes;
+    tileMeshes.Init();
 
 
     // compile and link shaders
     Shader cubeShader = Shader(
-            ABS_PATH("/res/shaders/cubeShader.vert"),
+            ABS_PATH("/res/shaders/cubeInstancedShader.vert"),
             ABS_PATH("/res/shaders/cubeShader.frag"));
 
     Shader tilesShader = Shader(
@@ -333,19 +424,194 @@ int main() {
     static const glm::vec3 cameraFront = - glm::normalize(cameraPos);
     // with such a small fov, perspective starts to look like an ortrographic projection 
     // since lines are almost parallel
-    Camera camera = Camera(SCREEN_WIDTH, SCREEN_HEIGHT, 0.1f, 10000.0f, cameraPos, cameraFront,
-            glm::vec3(0.0f, 1.0f, 0.0f), 10.0f, 10.0f, 0.1f, 20.0f);
-    glm::vec3 absoluteTrans = glm::vec3(0.5f);
-    glm::mat4 frozenModel = levelState.model;
-    bool rotating = false;
-    float angle = 0.0f;
-    glm::vec3 axis = glm::vec3(0);
-    glm::vec3 translationAxis = glm::vec3(0);
-    float curAngle = 0.0f;
-    float rotationSpeed = 10.0f;
-    float t = 0.0f;
-    Rotation rotation;
+    const core::Entity cameraEntity = entities.Create(Camera(SCREEN_WIDTH, SCREEN_HEIGHT, 0.1f, 10000.0f, cameraPos,
+                cameraFront, glm::vec3(0.0f, 1.0f, 0.0f), 10.0f, 10.0f, 0.1f, 20.0f));
+    Camera& camera = *entities.Get<Camera>(cameraEntity);
+    const core::Entity editor = entities.Create(levelEditor::Cursor{}, levelEditor::Edits{});
+    levelEditor::Cursor& cursor = *entities.Get<levelEditor::Cursor>(editor);
+    levelEditor::Edits& edits = *entities.Get<levelEditor::Edits>(editor);
+    const core::Entity player = entities.Create(CubeInstance{ glm::mat4(1.0f), glm::vec3(1.0f) }, PlayerCube{});
+    core::Simulation simulation = core::Simulation(levelState);
+    core::Replay replay;
+    bool replayActive = false; // the replay owns the level, the simulation is paused
+    bool replayPaused = false;
+    float replaySpeed = 1.0f;
+    double replayProgress = 0.0; // of the next roll, 0..1
+    // more cubes on the level, the player can't roll onto the swarm but goes through ghosts
+    const core::Entity swarmEntity = entities.Create(core::CubeSwarm(true, false),
+            SwarmCubes{ glm::vec3(0.8f, 0.9f, 1.0f), 0 });
+    const core::Entity ghostsEntity = entities.Create(core::CubeSwarm(false), SwarmCubes{ glm::vec3(0.5f, 0.6f, 0.9f), 0 });
+    core::CubeSwarm& swarm = *entities.Get<core::CubeSwarm>(swarmEntity);
+    core::CubeSwarm& ghosts = *entities.Get<core::CubeSwarm>(ghostsEntity);
+    std::vector<Ghost> ghostReplays;
+    swarm.Clear(levelState);
+    ghosts.Clear(levelState);
+    simulation.SetObstacles(&swarm);
+    SwarmMode swarmMode = SwarmMode::FOLLOW;
+    bool swarmTogglesTiles = false;
+    int swarmSpawnCount = 100;
+    int swarmMoved = 0;
+    std::mt19937 swarmRng(1234);
+    std::vector<uint8_t> swarmActions;
+    std::vector<CubeInstance> cubeInstances;
+
+    // everything animated besides the player's rolls, which stay on the simulation's ticks
+    core::TweenSystem tweens;
+    core::TweenId& swarmRoll = entities.Get<SwarmCubes>(swarmEntity)->roll;
+    core::TweenId& ghostRoll = entities.Get<SwarmCubes>(ghostsEntity)->roll;
+    int numTileEffects = 0;
+    std::vector<core::Entity> finishedEffects;
+    std::array<core::TweenId, 3> cameraMove = {}; // the orbit target's x, y and z
+    bool cameraMoving = false;
+    auto rollTime = [&] {
+        return 1.0f / simulation.GetConfig().rollsPerSecond;
+    };
+
+    // a tile the cubes rolled over turns over to its new color
+    auto flipTile = [&](int tileIx) {
+        const glm::vec3 tint = tileEffectTint(hexToRgb(core::tileInfo[(int)levelState.tiles.Get(tileIx)].color));
+        entities.Create(TileEffect{ tileIx, TileEffectKind::FLIP,
+                tweens.Start(180.0f, 0.0f, 0.3f, core::Ease::OUT_QUAD), tint });
+    };
+
+    // a loaded level comes in tile by tile from around the player, huge ones just appear
+    auto dropTiles = [&] {
+        static constexpr int maxDroppedTiles = 1 << 16;
+        finishedEffects.clear();
+        entities.Each<TileEffect>([&](core::Entity effect, const TileEffect& tileEffect) {
+            tweens.Cancel(tileEffect.tween);
+            finishedEffects.push_back(effect);
+        });
+        for (core::Entity effect : finishedEffects)
+            entities.Destroy(effect);
+        const TileGrid& tiles = levelState.tiles;
+        if (tiles.GetNumTiles() > maxDroppedTiles)
+            return;
+        const int side = tiles.GetSideLength();
+        for (int chunkIx = 0; chunkIx < tiles.GetNumChunks(); chunkIx++) {
+            tiles.ForEachInChunk(chunkIx, [&](int tileIx, TileType type) {
+                const float distance = std::hypot((float)(tileIx % side - side / 2 - levelState.player.x),
+                        (float)(tileIx / side - side / 2 - levelState.player.z));
+                const core::TweenId tween = tweens.Start(tileDropHeight, 0.0f, 0.4f, core::Ease::IN_QUAD,
+                        std::min(1.5f, distance * 0.03f));
+                entities.Create(TileEffect{ tileIx, TileEffectKind::DROP, tween,
+                        tileEffectTint(hexToRgb(core::tileInfo[(int)type].color)) });
+            });
+        }
+    };
+
+    // the orbit target glides over to the player
+    auto focusPlayer = [&] {
+        const glm::vec3 from = camera.GetOrbitTarget();
+        const glm::vec3 to = glm::vec3(levelState.player.x + 0.5f, 0.0f, levelState.player.z + 0.5f);
+        for (int axis = 0; axis < 3; axis++) {
+            tweens.Cancel(cameraMove[axis]);
+            // all three end in the same update, the last one puts the camera exactly in place
+            cameraMove[axis] = tweens.Start(from[axis], to[axis], 0.6f, core::Ease::SMOOTH, 0.0f,
+                    axis < 2 ? core::TweenSystem::Callback() : [&camera, &cameraMoving, to] {
+                camera.SetOrbitTarget(to);
+                cameraMoving = false;
+            });
+        }
+        cameraMoving = true;
+    };
+
+    // whatever the swarm did to the tiles, the player's undo history doesn't know about it
+    std::function<void()> swarmWander;
+    auto swarmStepped = [&](int moved) {
+        swarmMoved = moved;
+        for (int tileIx : swarm.GetChangedTiles()) {
+            tileMeshes.MarkTileDirty(levelState.tiles, tileIx);
+            flipTile(tileIx);
+        }
+        if (!swarm.GetChangedTiles().empty())
+            simulation.ResetHistory();
+        // a wandering swarm takes its next step as soon as this one is played
+        tweens.Cancel(swarmRoll);
+        swarmRoll = tweens.Start(0.0f, 1.0f, rollTime(), core::Ease::LINEAR, 0.0f, [&] {
+            if (swarmMode == SwarmMode::WANDER && !replayActive)
+                swarmWander();
+        });
+    };
+    swarmWander = [&] {
+        if (swarm.GetNumCubes() == 0)
+            return;
+        swarmActions.resize(swarm.GetNumCubes());
+        for (uint8_t& action : swarmActions)
+            action = swarmRng() & 3;
+        swarmStepped(swarm.Step(levelState, swarmActions.data()));
+    };
+
+    // ghosts take a step per roll time, the same way
+    std::function<void()> ghostStep;
+    ghostStep = [&] {
+        // a ghost at the end of its replay starts over, which means building the swarm anew
+        bool restart = false;
+        for (const Ghost& ghost : ghostReplays)
+            restart |= ghost.cursor == ghost.replay->GetNumMoves();
+        if (restart) {
+            std::vector<CubePose> poses;
+            for (int i = 0; i < ghosts.GetNumCubes(); i++)
+                poses.push_back(ghosts.GetPose(i));
+            ghosts.Clear(levelState);
+            for (size_t i = 0; i < ghostReplays.size(); i++) {
+                Ghost& ghost = ghostReplays[i];
+                if (ghost.cursor == ghost.replay->GetNumMoves()) {
+                    ghost.cursor = 0;
+                    poses[i] = ghost.start;
+                }
+                ghosts.Add(levelState, poses[i]);
+            }
+        } else {
+            swarmActions.resize(ghostReplays.size());
+            for (size_t i = 0; i < ghostReplays.size(); i++)
+                swarmActions[i] = (uint8_t)ghostReplays[i].replay->GetMove(ghostReplays[i].cursor++);
+            ghosts.Step(levelState, swarmActions.data());
+        }
+        ghostRoll = tweens.Start(0.0f, 1.0f, rollTime(), core::Ease::LINEAR, 0.0f, [&] {
+            if (!ghostReplays.empty() && !replayActive)
+                ghostStep();
+        });
+    };
+
+    // the swarm steps on the press and before the player, so a cube right in front gets out of the way
+    auto requestRoll = [&](Rotation rotation, const SDL_KeyboardEvent& key) {
+        const bool taken = !key.repeat || (!simulation.IsRolling() && simulation.GetQueue().Empty());
+        if (swarmMode == SwarmMode::FOLLOW && taken && !replayActive && swarm.GetNumCubes() > 0)
+            swarmStepped(swarm.StepAll(levelState, rotation));
+        simulation.RequestRoll(rotation, key.timestamp / 1000.0, key.repeat);
+    };
     bool editorMode = true; // maybe this will turn into an enum
+    // play testing (e) runs on the edited level and going back to the editor puts it back as it
+    // was. The snapshot shares every chunk with the level, so taking it is a pointer copy per chunk
+    LevelState playtestStart;
+    bool playtesting = false;
+
+    // the edited level for work off the frame loop, a new version at the end of every frame
+    // with edits in it. Readers never block the loop, see core::LevelPublisher
+    core::LevelPublisher levelPublisher;
+    levelPublisher.Publish(levelState);
+    bool levelPublishPending = false;
+    // autosave is such a reader, it writes the latest version every few seconds if there is a new one
+    std::atomic<bool> autosaveStop = false;
+    std::atomic<uint64_t> autosavedVersion = 1; // the level the game started with isn't an edit
+    std::thread autosaveThread([&] {
+        const int reader = levelPublisher.RegisterReader();
+        for (int tick = 1; !autosaveStop; tick++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (tick % 30 != 0)
+                continue;
+            core::LevelPublisher::ReadGuard guard = levelPublisher.Read(reader);
+            if (guard.Get() == nullptr || guard->number == autosavedVersion)
+                continue;
+            std::filesystem::create_directories(ABS_PATH("/res/autosave"));
+            if (core::saveLevelFile(ABS_PATH("/res/autosave/level.txt"), guard->level))
+                autosavedVersion = guard->number;
+            else
+                LOG_ERROR("Autosave of level version {} failed", guard->number);
+        }
+        levelPublisher.UnregisterReader(reader);
+    });
     double deltaTime = 0; // time between current and last frame
     double lastTime = 0; // time of last frame
     double prevTime = 0; // start time of the current second
@@ -356,8 +622,7 @@ int main() {
     bool mouseOnUI = false;
     bool leftMouseDown = false;
     bool rightMouseDown = false;
-
-#define GET_TILE(x, z) ((z) + offset) * sideNum + (x) + offset
+    int numChunksDrawn = 0;
 
     // game loop
     while(!quit) {
@@ -401,60 +666,25 @@ int main() {
                                 camera.Move(Direction::DOWN);
                             break;
                         case SDLK_DOWN:
-                            if (!rotating) {
-                                int tileIx = GET_TILE(levelState.playerPos.x, levelState.playerPos.z + 1);
-                                if (levelState.tiles[tileIx] != TileType::EMPTY_TILE) {
-                                    axis = glm::vec3(1,0,0);
-                                    angle = 90.0f;
-                                    rotating = true;
-                                    frozenModel = levelState.model;
-                                    translationAxis = glm::vec3(0, 0.5, -0.5);
-                                    rotation = Rotation::DOWN;
-                                    turn(levelState.playerRot, rotation);
-                                }
-                            }
+                            requestRoll(Rotation::DOWN, event.key);
                             break;
                         case SDLK_UP:
-                            if (!rotating) {
-                                int tileIx = GET_TILE(levelState.playerPos.x, levelState.playerPos.z - 1);
-                                if (levelState.tiles[tileIx] != TileType::EMPTY_TILE) {
-                                    axis = glm::vec3(1,0,0);
-                                    angle = -90.0f;
-                                    rotating = true;
-                                    frozenModel = levelState.model;
-                                    translationAxis = glm::vec3(0, 0.5, 0.5);
-                                    rotation = Rotation::UP;
-                                    turn(levelState.playerRot, rotation);
-                                }
-                            }
+                            requestRoll(Rotation::UP, event.key);
                             break;
                         case SDLK_LEFT:
-                            if (!rotating) {
-                                int tileIx = GET_TILE(levelState.playerPos.x - 1, levelState.playerPos.z);
-                                if (levelState.tiles[tileIx] != TileType::EMPTY_TILE) {
-                                    axis = glm::vec3(0,0,1);
-                                    angle = 90.0f;
-                                    rotating = true;
-                                    frozenModel = levelState.model;
-                                    translationAxis = glm::vec3(0.5, 0.5, 0);
-                                    rotation = Rotation::LEFT;
-                                    turn(levelState.playerRot, rotation);
-                                }
-                            }
+                            requestRoll(Rotation::LEFT, event.key);
                             break;
                         case SDLK_RIGHT:
-                            if (!rotating) {
-                                axis = glm::vec3(0,0,1);
-                                int tileIx = GET_TILE(levelState.playerPos.x + 1, levelState.playerPos.z);
-                                if (levelState.tiles[tileIx] != TileType::EMPTY_TILE) {
-                                    angle = -90.0f;
-                                    rotating = true;
-                                    frozenModel = levelState.model;
-                                    translationAxis = glm::vec3(-0.5, 0.5, 0);
-                                    rotation = Rotation::RIGHT;
-                                    turn(levelState.playerRot, rotation);
-                                }
-                            }
+                            requestRoll(Rotation::RIGHT, event.key);
+                            break;
+                        case SDLK_z:
+                            simulation.Undo();
+                            break;
+                        case SDLK_y:
+                            simulation.Redo();
+                            break;
+                        case SDLK_f:
+                            focusPlayer();
                             break;
                         case SDLK_LSHIFT:
                             shiftPressed = true;
@@ -499,6 +729,25 @@ int main() {
                             break;
                         case SDLK_e:
                             editorMode = !editorMode;
+                            if (!editorMode && !streamer.IsOpen() && !replayActive) {
+                                playtestStart = levelState;
+                                playtesting = true;
+                                focusPlayer();
+                            } else if (editorMode && playtesting) {
+                                // only the chunks the play test wrote to are not shared anymore
+                                for (int chunkIx = 0; chunkIx < levelState.tiles.GetNumChunks(); chunkIx++) {
+                                    if (!levelState.tiles.SharesChunk(playtestStart.tiles, chunkIx) ||
+                                            !levelState.voxels.SharesChunk(playtestStart.voxels, chunkIx))
+                                        tileMeshes.MarkChunkDirty(chunkIx);
+                                }
+                                levelState = std::move(playtestStart);
+                                playtestStart = {};
+                                playtesting = false;
+                                levelPublishPending = true;
+                                replayActive = false;
+                                saveReplay(simulation.GetRecorder());
+                                simulation.ResetHistory();
+                            }
                             break;
                         case SDLK_LSHIFT:
                             shiftPressed = false;
@@ -585,67 +834,68 @@ int main() {
         }
 
         if (leftMouseDown) {
-            if (levelEditor::castedTile != -1) {
-                levelEditor::AddCastedToSelected();
+            if (cursor.tile != -1) {
+                levelEditor::AddCastedToSelected(cursor);
             }
         }
 
         if (rightMouseDown) {
-            if (levelEditor::castedTile != -1) {
-                levelEditor::RemoveCastedFromSelected();
+            if (cursor.tile != -1) {
+                levelEditor::RemoveCastedFromSelected(cursor);
             }
         }
 
+        // animations first, their callbacks step cubes and move the camera
+        tweens.Update((float)deltaTime);
+        finishedEffects.clear();
+        entities.Each<TileEffect>([&](core::Entity effect, const TileEffect& tileEffect) {
+            if (!tweens.IsActive(tileEffect.tween))
+                finishedEffects.push_back(effect);
+        });
+        for (core::Entity effect : finishedEffects)
+            entities.Destroy(effect);
+        numTileEffects = 0;
+        entities.EachBlock<TileEffect>([&](int count, const core::Entity*, const TileEffect*) {
+            numTileEffects += count;
+        });
+        if (cameraMoving) {
+            const glm::vec3& target = camera.GetOrbitTarget();
+            camera.SetOrbitTarget(glm::vec3(tweens.Get(cameraMove[0], target.x), tweens.Get(cameraMove[1], target.y),
+                        tweens.Get(cameraMove[2], target.z)));
+        }
+
         camera.Update(deltaTime);
-        levelEditor::Update();
+        levelEditor::Update(levelState);
+
+        if (streamer.IsOpen()) {
+            // around the cube while playing, around what the camera looks at in the editor
+            int centerX = levelState.player.x;
+            int centerZ = levelState.player.z;
+            if (editorMode) {
+                glm::vec3 focus = camera.GetPos();
+                const glm::vec3& front = camera.GetFront();
+                if (front.y < 0.0f)
+                    focus -= front * (focus.y / front.y);
+                centerX = (int)floor(focus.x);
+                centerZ = (int)floor(focus.z);
+            }
+            streamer.Update(levelState.tiles, centerX, centerZ);
+            core::StreamEvents streamEvents = streamer.TakeEvents();
+            for (int chunkIx : streamEvents.changedChunks)
+                tileMeshes.MarkChunkDirty(chunkIx);
+            // undoing into a chunk that is on disk now would lose the rolls made there
+            if (streamEvents.modifiedEvicted)
+                simulation.ResetHistory();
+        }
 
         if (tilesNeedUpdate) {
             tilesNeedUpdate = false;
-            currentGroundVertices.clear();
-
-            size_t numVisible = 0;
-            for (size_t i = 0; i < levelState.tiles.size(); i++) {
-                switch (levelState.tiles[i]) {
-                    case TileType::GROUND_TILE:
-                        currentGroundVertices.push_back(tilesVertices[i]);
-                        currentGroundVertices[numVisible].SetColor(hexToRgb(GROUND_TILE_COLOR));
-                        numVisible++;
-                        break;
-                    case TileType::DARK_TILE:
-                        currentGroundVertices.push_back(tilesVertices[i]);
-                        currentGroundVertices[numVisible].SetColor(hexToRgb(DARK_TILE_COLOR));
-                        numVisible++;
-                        break;
-                    case TileType::LIGHT_TILE:
-                        currentGroundVertices.push_back(tilesVertices[i]);
-                        currentGroundVertices[numVisible].SetColor(hexToRgb(LIGHT_TILE_COLOR));
-                        numVisible++;
-                        break;
-                    case TileType::TARGET_ON_TILE:
-                        currentGroundVertices.push_back(tilesVertices[i]);
-                        currentGroundVertices[numVisible].SetColor(hexToRgb(TARGET_ON_TILE_COLOR));
-                        numVisible++;
-                        break;
-                    case TileType::TARGET_OFF_TILE:
-                        currentGroundVertices.push_back(tilesVertices[i]);
-                        currentGroundVertices[numVisible].SetColor(hexToRgb(TARGET_OFF_TILE_COLOR));
-                        numVisible++;
-                        break;
-                    case TileType::EMPTY_TILE:
-                        break;
-                }
-            }
-
-            tilesIndices = generateQuadIndices(numVisible);
-
-            tilesMesh.UpdateBufferData(0, currentGroundVertices.size(),
-                    currentGroundVertices.size() * sizeof(Tile), currentGroundVertices.data());
-            tilesMesh.UpdateElementBufferData(0, tilesIndices.size(),
-                    tilesIndices.size() * sizeof(uint32_t), tilesIndices.data());
+            tileMeshes.MarkAllDirty();
         }
+        tileMeshes.Update(levelState);
 
         // raycast
-        levelEditor::castedTile = -1;
+        cursor.tile = -1;
         if (!mouseOnUI) {
             if (editorMode && camera.GetMode() == CameraMode::ORBIT) {
                 int x, y;
@@ -654,7 +904,6 @@ int main() {
                         2.0f * x / SCREEN_WIDTH - 1.0f, -2.0f * y / SCREEN_HEIGHT + 1.0f, -1.0f, 1.0f);
 
                 glm::vec4 rayEye;
-                glm::vec3 planeNormal = glm::vec3(0.0f, -1.0f, 0.0f);
                 glm::vec3 rayWorld;
                 glm::vec3 cameraPos;
 
@@ -677,28 +926,19 @@ int main() {
                     glm::vec3 up = glm::normalize(glm::cross(right, camera.GetFront()));
                     cameraPos = camera.GetPos() + right * xOrthoOffset + up * yOrthoOffset;
                 }
-                float dot = glm::dot(rayWorld, planeNormal);
-                if (dot >= 0.0f) {
-                    float t = cameraPos.y / dot;
-                    glm::vec3 raycastedPoint = cameraPos + rayWorld * t;
-
-                    int tileX = floor(raycastedPoint.x);
-                    int tileZ = floor(raycastedPoint.z);
-                    int tileIx = levelEditor::GetTileIndex(tileX, tileZ);
-                    if (tileIx != -1) {
-                        // TODO: kinda ugly, refactor
-                        levelEditor::castedTile = tileIx;
-                        levelEditor::castedTileQuad = levelEditor::gridVertices[tileIx];
-                        levelEditor::castedTileQuad.SetColor(tileColor);
-                        levelEditor::castedTileMesh.UpdateBufferData(0, levelEditor::TileQuad::numVertices,
-                                sizeof(levelEditor::TileQuad), &levelEditor::castedTileQuad);
-                    }
+                // first voxel along the ray, or the tile under it. Either way the whole column is picked
+                const core::RayHit hit = core::raycast(levelState.voxels, { cameraPos.x, cameraPos.y, cameraPos.z },
+                        { rayWorld.x, rayWorld.y, rayWorld.z });
+                int tileIx = hit.hit ? levelEditor::GetTileIndex(hit.x, hit.z) : -1;
+                if (tileIx != -1) {
+                    const float top = (float)levelState.voxels.ColumnHeight(hit.x, hit.z);
+                    levelEditor::SetCursor(cursor, tileIx, top, tileColor);
                 }
             }
         }
 
         glm::vec3 normalizedCameraPos = glm::normalize(camera.GetPos());
-        levelEditor::axisOffset = 0.1f * normalizedCameraPos;
+        const glm::vec3 axisOffset = 0.1f * normalizedCameraPos;
 
         // render
         const glm::vec3 background = hexToRgb(BG_COLOR);
@@ -712,58 +952,45 @@ int main() {
         /* ImGui::Begin("Viewport"); */
         /* ImGui::End(); */
 
-        if (rotating) {
-            t += deltaTime * rotationSpeed; // make it a fixed update maybe
-            if (t >= 1.0f) {
-                t = 1.0f;
-                rotating = false;
+        glm::mat4 playerModel;
+        if (replayActive) {
+            // same rules as the game, just fed from the file. At high speeds several rolls land per frame
+            if (!replayPaused)
+                replayProgress += deltaTime * simulation.GetConfig().rollsPerSecond * replaySpeed;
+            while (replayProgress >= 1.0 && !replay.Done()) {
+                const core::StepResult result = replay.Next(levelState);
+                for (int i = 0; i < result.numChangedTiles; i++)
+                    tileMeshes.MarkTileDirty(levelState.tiles, result.changedTiles[i].tileIx);
+                replayProgress -= 1.0;
             }
-            curAngle = t * angle;
-            glm::mat4 trans = glm::translate(glm::mat4(1.0), - absoluteTrans - levelState.playerPos + translationAxis);
-            glm::mat4 transBack = glm::translate(glm::mat4(1.0), absoluteTrans + levelState.playerPos - translationAxis);
-            levelState.model = transBack * glm::rotate(glm::mat4(1.0), glm::radians(curAngle), axis) * trans * frozenModel;
-            if (!rotating) {
-                curAngle = 0.0f;
-                t = 0.0f;
-                // update the position only after the rotation has finished
-                switch (rotation) {
-                    case Rotation::UP:
-                        levelState.playerPos.z -= 1;
-                        break;
-                    case Rotation::DOWN:
-                        levelState.playerPos.z += 1;
-                        break;
-                    case Rotation::LEFT:
-                        levelState.playerPos.x -= 1;
-                        break;
-                    case Rotation::RIGHT:
-                        levelState.playerPos.x += 1;
-                        break;
-                    default:
-                        break;
-                }
-                Face downFace = levelState.playerRot[(int)Orientation::DOWN];
-                int tileIx = GET_TILE(levelState.playerPos.x, levelState.playerPos.z);
-
-                // check if it's a valid position
-                // TODO: find a better way that's not a hack
-                if (levelState.playerPos.x >= 0 - offset &&
-                    levelState.playerPos.z >= 0 - offset &&
-                    levelState.playerPos.x < sideNum - offset &&
-                    levelState.playerPos.z < sideNum - offset) {
-                    if (downFace == Face::F) {
-                        if (levelState.tiles[tileIx] == TileType::DARK_TILE) {
-                            levelState.tiles[tileIx] = TileType::LIGHT_TILE;
-                            tilesNeedUpdate = true;
-                        }
-                    } else {
-                        if (levelState.tiles[tileIx] == TileType::LIGHT_TILE) {
-                            levelState.tiles[tileIx] = TileType::DARK_TILE;
-                            tilesNeedUpdate = true;
-                        }
-                    }
-                }
+
+            if (replay.Done()) {
+                replayProgress = 0.0;
+                playerModel = poseModel(levelState.player);
+            } else {
+                core::RollSnapshot roll = { true, levelState.player, replay.GetMove(replay.GetCursor()),
+                    (int)replay.GetCursor(), (float)replayProgress };
+                playerModel = rollModel(roll);
             }
+        } else {
+            // fixed rate simulation, the cube is drawn in between its last two ticks
+            simulation.Update(time);
+            core::SimEvents simEvents = simulation.TakeEvents();
+            for (int tileIx : simEvents.changedTiles) {
+                tileMeshes.MarkTileDirty(levelState.tiles, tileIx);
+                flipTile(tileIx);
+            }
+            if (simEvents.levelCompleted && !editorMode)
+                LOG_INFO("Level complete");
+
+            core::RollSnapshot roll = simulation.GetInterpolated();
+            playerModel = roll.rolling ? rollModel(roll) : poseModel(levelState.player);
+
+            // each step starts the next one when it is played, this only gets them going
+            if (swarmMode == SwarmMode::WANDER && !tweens.IsActive(swarmRoll))
+                swarmWander();
+            if (!ghostReplays.empty() && !tweens.IsActive(ghostRoll))
+                ghostStep();
         }
 
         const glm::mat4& projection = camera.GetType() == CameraType::PERSPECTIVE ?
@@ -773,14 +1000,19 @@ int main() {
 
         glm::mat4 vp = projection * view;
     
-        // render cube
+        // render cubes
         {
-            glm::mat4 mvp = vp * levelState.model;
+            entities.Get<CubeInstance>(player)->model = playerModel;
+            gatherCubeInstances(entities, tweens, levelState, cubeInstances);
+            cubeMesh.SetInstanceData(cubeInstances.size(), cubeInstances.size() * sizeof(CubeInstance),
+                    cubeInstances.data());
+
             cubeShader.Bind();
-            cubeShader.SetUniformMatrix4fv("mvp", mvp);
+            cubeShader.SetUniformMatrix4fv("vp", vp);
 
             cubeMesh.BindVao();
-            glDrawElements(GL_TRIANGLES, cubeMesh.GetNumIndices(), GL_UNSIGNED_INT, 0);
+            glDrawElementsInstanced(GL_TRIANGLES, cubeMesh.GetNumIndices(), GL_UNSIGNED_INT, 0,
+                    cubeMesh.GetNumInstances());
         }
 
         // render tiles
@@ -788,21 +1020,210 @@ int main() {
             tilesShader.Bind();
             tilesShader.SetUniformMatrix4fv("mvp", vp);
 
-            tilesMesh.BindVao();
-            glDrawElements(GL_TRIANGLES, tilesMesh.GetNumIndices(), GL_UNSIGNED_INT, 0);
+            numChunksDrawn = tileMeshes.Render(vp);
         }
 
         // render level editor 
         if (editorMode) {
             // hack to allow the editor to access the level tiles
-            levelEditor::Render(vp, tilesNeedUpdate, levelState);
+            bool levelEdited = false;
+            levelEditor::Render(vp, axisOffset, cursor, edits, levelEdited, levelState);
+            // edited tiles light up for a moment
+            auto highlightTile = [&](int tileIx) {
+                entities.Create(TileEffect{ tileIx, TileEffectKind::HIGHLIGHT,
+                        tweens.Start(1.0f, 0.0f, 0.4f, core::Ease::OUT_QUAD), tileEffectTint(tileColor) });
+            };
+            for (int tileIx : edits.tiles) {
+                tileMeshes.MarkTileDirty(levelState.tiles, tileIx);
+                highlightTile(tileIx);
+            }
+            for (int tileIx : edits.columns) {
+                tileMeshes.MarkColumnDirty(levelState.tiles, tileIx);
+                highlightTile(tileIx);
+            }
+            if (levelEdited) {
+                tilesNeedUpdate = true;
+                dropTiles();
+                // the editor put another level in place of the streamed one
+                streamer.Close();
+                swarm.Clear(levelState);
+                ghosts.Clear(levelState);
+                ghostReplays.clear();
+            }
+            if (levelEdited || !edits.tiles.empty() || !edits.columns.empty()) {
+                levelPublishPending = true;
+                edits.tiles.clear();
+                edits.columns.clear();
+                replayActive = false;
+                saveReplay(simulation.GetRecorder());
+                simulation.ResetHistory();
+            }
+
+            ImGui::Begin("Input");
+            core::SimConfig simConfig = simulation.GetConfig();
+            ImGui::Checkbox("Snap rolls", &simConfig.snapRolls);
+            ImGui::SliderFloat("Rolls per second", &simConfig.rollsPerSecond, 1.0f, 30.0f);
+            ImGui::SliderInt("Tick rate", &simConfig.tickRate, 30, 480);
+            simulation.SetConfig(simConfig);
+            const core::LatencyStats& inputLatency = simulation.GetLatency();
+            ImGui::Text("Queued: %d / %d", simulation.GetQueue().Size(), core::MoveQueue::capacity);
+            ImGui::Text("Input latency (ms): last %.1f, avg %.1f, max %.1f",
+                    inputLatency.last * 1000.0, inputLatency.Average() * 1000.0, inputLatency.max * 1000.0);
+            if (ImGui::Button("Reset latency"))
+                simulation.ResetLatency();
+            const core::UndoLog& undoLog = simulation.GetUndoLog();
+            ImGui::Text("Undo (z/y): roll %lld of %lld, %.1f KB",
+                    (long long)undoLog.GetCursor(), (long long)undoLog.GetLastMove(),
+                    undoLog.GetMemoryUsage() / 1024.0);
+            ImGui::Text("Tile meshes: %d of %d chunks drawn, %lld quads",
+                    numChunksDrawn, (int)tileMeshes.GetNumMeshes(), (long long)tileMeshes.GetNumQuads());
+            bool greedyMeshing = tileMeshes.GetGreedy();
+            if (ImGui::Checkbox("Greedy meshing", &greedyMeshing))
+                tileMeshes.SetGreedy(greedyMeshing);
+            ImGui::Text("Tweens: %d running, %d tile effects (f: camera to the cube)", tweens.GetNumActive(),
+                    numTileEffects);
+            ImGui::Text("Entities: %d in %d archetypes", entities.GetNumEntities(), entities.GetNumArchetypes());
+            ImGui::Text("Level version %llu, %d older ones still read, autosaved %llu",
+                    (unsigned long long)levelPublisher.GetNumPublished(), levelPublisher.GetNumRetired(),
+                    (unsigned long long)autosavedVersion.load());
+            ImGui::End();
+
+            if (streamer.IsOpen()) {
+                ImGui::Begin("Streaming");
+                core::StreamConfig streamConfig = streamer.GetConfig();
+                ImGui::SliderInt("Radius (chunks)", &streamConfig.radius, 1, 16);
+                ImGui::SliderInt("Evict margin", &streamConfig.evictMargin, 0, 4);
+                streamer.SetConfig(streamConfig);
+                const core::StreamStats& streamStats = streamer.GetStats();
+                ImGui::Text("Resident: %d chunks (max %d), %.1f MB, %d loading",
+                        streamStats.resident, streamStats.maxResident,
+                        levelState.tiles.GetMemoryUsage() / (1024.0 * 1024.0), streamStats.pending);
+                ImGui::Text("Loads %lld, evictions %lld, written back %lld, read errors %lld",
+                        (long long)streamStats.loads, (long long)streamStats.evictions,
+                        (long long)streamStats.writeBacks, (long long)streamStats.ioErrors);
+                ImGui::Text("Read (ms): avg %.2f, max %.2f",
+                        streamStats.readLatency.Average() * 1000.0, streamStats.readLatency.max * 1000.0);
+                ImGui::Text("In grid (ms): last %.2f, avg %.2f, max %.2f",
+                        streamStats.loadLatency.last * 1000.0, streamStats.loadLatency.Average() * 1000.0,
+                        streamStats.loadLatency.max * 1000.0);
+                ImGui::Text("Stalls (next tile still on disk): %lld", (long long)streamStats.stalls);
+                if (ImGui::Button("Reset stats"))
+                    streamer.ResetStats();
+                ImGui::End();
+            }
+
+            ImGui::Begin("Cubes");
+            int mode = (int)swarmMode;
+            ImGui::RadioButton("Idle", &mode, (int)SwarmMode::IDLE);
+            ImGui::SameLine();
+            ImGui::RadioButton("Follow", &mode, (int)SwarmMode::FOLLOW);
+            ImGui::SameLine();
+            ImGui::RadioButton("Wander", &mode, (int)SwarmMode::WANDER);
+            swarmMode = static_cast<SwarmMode>(mode);
+            if (ImGui::Checkbox("Toggle tiles (resets undo)", &swarmTogglesTiles))
+                swarm.SetTogglesTiles(swarmTogglesTiles);
+            ImGui::SliderInt("Count", &swarmSpawnCount, 1, 10000, "%d", ImGuiSliderFlags_Logarithmic);
+            if (ImGui::Button("Spawn")) {
+                // on free tiles in a square around the player, about half of it filled
+                const int radius = std::max(4, (int)std::sqrt((double)swarmSpawnCount * 2.0) / 2 + 1);
+                std::uniform_int_distribution<int> offset(-radius, radius);
+                std::uniform_int_distribution<int> orientation(0, core::numOrientations - 1);
+                for (int tries = 0, added = 0; added < swarmSpawnCount && tries < swarmSpawnCount * 16; tries++) {
+                    const CubePose pose = { (int16_t)(levelState.player.x + offset(swarmRng)),
+                        (int16_t)(levelState.player.z + offset(swarmRng)), (uint8_t)orientation(swarmRng) };
+                    added += swarm.Add(levelState, pose) != -1;
+                }
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Remove all"))
+                swarm.Clear(levelState);
+            // ghosts replay this level's session, saved as it is now
+            if (!streamer.IsOpen() && ImGui::Button("Add ghost")) {
+                saveReplay(simulation.GetRecorder());
+                const std::string path = replayPath(simulation.GetRecorder().GetLevelHash());
+                Ghost ghost = { std::make_unique<core::Replay>(), {}, 0 };
+                if (simulation.GetRecorder().GetNumMoves() > 0 && ghost.replay->Open(path)) {
+                    LevelState start = core::makeLevelState(ghost.replay->GetSideLength());
+                    ghost.replay->Seek(start, 0);
+                    ghost.start = start.player;
+                    if (ghosts.Add(levelState, ghost.start) != -1)
+                        ghostReplays.push_back(std::move(ghost));
+                } else {
+                    LOG_ERROR("No replay to make a ghost of");
+                }
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Remove ghosts")) {
+                ghosts.Clear(levelState);
+                ghostReplays.clear();
+            }
+            ImGui::Text("Swarm: %d cubes, %d moved in the last step", swarm.GetNumCubes(), swarmMoved);
+            ImGui::Text("Ghosts: %d, all cubes in 1 draw of %d instances", ghosts.GetNumCubes(),
+                    (int)cubeMesh.GetNumInstances());
+            ImGui::End();
+
+            ImGui::Begin("Replay");
+            const core::ReplayRecorder& recorder = simulation.GetRecorder();
+            ImGui::Text("Level %016llx, %lld moves recorded",
+                    (unsigned long long)recorder.GetLevelHash(), (long long)recorder.GetNumMoves());
+            if (!replayActive) {
+                if (ImGui::Button("Save"))
+                    saveReplay(recorder);
+                // replays start from a whole level, a streamed one is only partly in memory
+                if (!streamer.IsOpen()) {
+                    ImGui::SameLine();
+                    if (ImGui::Button("Play")) {
+                        // the session so far is what gets played back
+                        saveReplay(recorder);
+                        std::string path = replayPath(recorder.GetLevelHash());
+                        if (replay.Open(path)) {
+                            replay.Seek(levelState, 0);
+                            replayActive = true;
+                            replayPaused = false;
+                            replayProgress = 0.0;
+                            tilesNeedUpdate = true;
+                        } else {
+                            LOG_ERROR("Could not open replay {}", path);
+                        }
+                    }
+                }
+            } else {
+                ImGui::Checkbox("Paused", &replayPaused);
+                ImGui::SliderFloat("Speed", &replaySpeed, 0.25f, 1000.0f, "%.2fx", ImGuiSliderFlags_Logarithmic);
+                int64_t move = replay.GetCursor();
+                const int64_t firstMove = 0;
+                const int64_t lastMove = replay.GetNumMoves();
+                if (ImGui::SliderScalar("Move", ImGuiDataType_S64, &move, &firstMove, &lastMove)) {
+                    replay.Seek(levelState, move);
+                    replayProgress = 0.0;
+                    tilesNeedUpdate = true;
+                }
+                if (ImGui::Button("Stop")) {
+                    // go on playing from wherever the replay got to
+                    replayActive = false;
+                    simulation.ResetHistory();
+                }
+            }
+            ImGui::End();
         }
 
+        // a streamed level is only partly in memory, there is nothing whole to publish
+        if (levelPublishPending && !streamer.IsOpen())
+            levelPublisher.Publish(levelState);
+        else
+            levelPublisher.Reclaim();
+        levelPublishPending = false;
+
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         SDL_GL_SwapWindow(window);
     }
 
+    autosaveStop = true;
+    autosaveThread.join();
+
+    if (!replayActive)
+        saveReplay(simulation.GetRecorder());
     levelEditor::SaveCurrentLevel(levelState);
 
     ImGui_ImplOpenGL3_Shutdown();
@@ -67,9 +67,11 @@ public:
         m_Vao(0),
         m_Vbo(0),
         m_Ebo(0),
+        m_InstanceVbo(0),
         m_Stride(0),
         m_VerticesCount(0),
-        m_IndicesCount(0)
+        m_IndicesCount(0),
+        m_InstancesCount(0)
     { }
 
     Mesh(const void* verticesData, size_t verticesCount, size_t verticesSize,
@@ -78,9 +80,11 @@ public:
         m_Vao(0),
         m_Vbo(0),
         m_Ebo(0),
+        m_InstanceVbo(0),
         m_Stride(verticesSize / verticesCount),
         m_VerticesCount(verticesCount),
-        m_IndicesCount(indicesCount)
+        m_IndicesCount(indicesCount),
+        m_InstancesCount(0)
     {
         // create vao
         glGenVertexArrays(1, &m_Vao);
@@ -133,6 +137,62 @@ public:
     }
 
 
+    // reallocates the vertex buffer, for meshes that grow and shrink
+    inline void SetBufferData(size_t count, size_t size, const void* data, GLenum usage) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_Vbo);
+        glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_VerticesCount = count;
+    }
+
+    // reallocates the element buffer, same as above
+    inline void SetElementBufferData(size_t count, size_t size, const void* data) {
+        BindVao();
+        if (m_Ebo == 0)
+            glGenBuffers(1, &m_Ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, GL_DYNAMIC_DRAW);
+        m_IndicesCount = count;
+    }
+
+    // uses an element buffer owned by someone else, several meshes can share one
+    inline void SetSharedElementBuffer(uint32_t ebo, size_t count) {
+        BindVao();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        m_IndicesCount = count;
+    }
+
+    // per instance attributes from a second vertex buffer, starting at firstLocation and
+    // advancing once per instance. A mat4 takes 4 locations, so it goes in as 4 vec4s
+    inline void SetInstanceLayout(GLuint firstLocation, const std::vector<Layout>& layouts) {
+        BindVao();
+        if (m_InstanceVbo == 0)
+            glGenBuffers(1, &m_InstanceVbo);
+        glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVbo);
+
+        GLsizei stride = 0;
+        for (const Layout& layout : layouts)
+            stride += layout.count * getSizeOfType(layout.type);
+
+        uint64_t offset = 0;
+        for (size_t i = 0; i < layouts.size(); i++) {
+            const GLuint location = firstLocation + i;
+            glVertexAttribPointer(location, layouts[i].count, layouts[i].type, GL_FALSE, stride, (void*) offset);
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+            offset += layouts[i].count * getSizeOfType(layouts[i].type);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // reallocates the instance buffer, which also keeps it from waiting on the draw of the last frame
+    inline void SetInstanceData(size_t count, size_t size, const void* data) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVbo);
+        glBufferData(GL_ARRAY_BUFFER, size, data, GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_InstancesCount = count;
+    }
+
     inline void BindVao() {
         glBindVertexArray(m_Vao);
     }
@@ -149,6 +209,10 @@ public:
         return m_IndicesCount;
     }
 
+    inline size_t GetNumInstances() const {
+        return m_InstancesCount;
+    }
+
     inline uint32_t GetVaoId() const {
         return m_Vao;
     }
@@ -157,9 +221,11 @@ private:
     uint32_t m_Vao;
     uint32_t m_Vbo;
     uint32_t m_Ebo;
+    uint32_t m_InstanceVbo;
     size_t m_Stride;
     size_t m_VerticesCount;
     size_t m_IndicesCount;
+    size_t m_InstancesCount;
 };
 
 #endif // MESH_H
@@ -0,0 +1,83 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <cstdint>
+
+/*
+    Binary protocol of the headless simulation server, little endian.
+
+    Every request is a RequestHeader followed by size bytes of body, every response a
+    ResponseHeader and its body. Requests can be pipelined: a client may send any
+    number of them before reading, responses come back in order and carry the id of
+    their request.
+
+    LOAD_LEVEL      body: level file text                   reply: LevelInfo
+    APPLY_MOVES     body: one Rotation per byte             reply: MovesResult
+    QUERY_STATE     body: empty, or 1 byte != 0 for tiles   reply: StateInfo [+ tile glyphs, row major]
+    SNAPSHOT        body: empty                             reply: uint32 snapshot id
+    RESTORE         body: uint32 snapshot id                reply: StateInfo
+
+    A failed request gets a non OK status and an error message as body.
+*/
+namespace protocol {
+    enum class RequestType : uint8_t {
+        LOAD_LEVEL = 1,
+        APPLY_MOVES = 2,
+        QUERY_STATE = 3,
+        SNAPSHOT = 4,
+        RESTORE = 5
+    };
+
+    enum class Status : uint8_t {
+        OK = 0,
+        BAD_REQUEST = 1,
+        NO_LEVEL = 2,
+        UNKNOWN_SNAPSHOT = 3,
+        INVALID_LEVEL = 4
+    };
+
+    // bodies above this close the connection, nothing legit gets close
+    static constexpr uint32_t maxBodySize = 64 * 1024 * 1024;
+
+    struct RequestHeader {
+        uint32_t size;
+        uint32_t id;
+        RequestType type;
+        uint8_t reserved[3];
+    };
+
+    struct ResponseHeader {
+        uint32_t size;
+        uint32_t id;
+        Status status;
+        uint8_t reserved[3];
+    };
+
+    struct LevelInfo {
+        uint64_t levelHash;
+        int32_t sideLength;
+        uint32_t reserved;
+    };
+
+    struct StateInfo {
+        uint64_t stateHash; // core::hashLevel of the current state
+        int32_t darkTiles;
+        int16_t x;
+        int16_t z;
+        uint8_t orientation;
+        uint8_t complete;
+        uint8_t reserved[6];
+    };
+
+    struct MovesResult {
+        uint32_t moved; // rolls that were legal
+        uint32_t reserved;
+        StateInfo state;
+    };
+
+    // no implicit padding, the structs go over the wire as they are
+    static_assert(sizeof(RequestHeader) == 12 && sizeof(ResponseHeader) == 12);
+    static_assert(sizeof(LevelInfo) == 16 && sizeof(StateInfo) == 24 && sizeof(MovesResult) == 32);
+}
+
+#endif // PROTOCOL_H
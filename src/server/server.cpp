@@ -0,0 +1,412 @@
+#include "server.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "protocol.h"
+#include "core/levelFile.h"
+#include "core/replay.h"
+#include "core/rules.h"
+
+namespace server {
+    using namespace protocol;
+
+    // a client that stops reading doesn't get more requests run until it catches up
+    static constexpr size_t maxPendingOutput = 16 * 1024 * 1024;
+    static constexpr int maxSnapshots = 4096;
+
+    struct Session {
+        LevelState level;
+        bool hasLevel;
+        std::vector<LevelState> snapshots;
+    };
+
+    struct Connection {
+        int fd;
+        std::vector<char> in;
+        std::vector<char> out;
+        size_t outSent;
+        Session session;
+        // nothing more is read: the client shut down its side (what is left in still gets
+        // answered) or a request threw. The connection closes once the output is sent
+        bool readClosed;
+    };
+
+    template<typename T>
+    static void append(std::vector<char>& out, const T& value) {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    static void respond(std::vector<char>& out, uint32_t id, Status status, const void* body, size_t size) {
+        ResponseHeader header = { (uint32_t)size, id, status, {} };
+        append(out, header);
+        const char* bytes = static_cast<const char*>(body);
+        out.insert(out.end(), bytes, bytes + size);
+    }
+
+    static void respondError(std::vector<char>& out, uint32_t id, Status status, std::string_view message) {
+        respond(out, id, status, message.data(), message.size());
+    }
+
+    static StateInfo stateInfo(const LevelState& level) {
+        StateInfo info = {};
+        info.stateHash = core::hashLevel(level);
+        info.darkTiles = level.tiles.Count(TileType::DARK_TILE);
+        info.x = level.player.x;
+        info.z = level.player.z;
+        info.orientation = level.player.orientation;
+        info.complete = core::isLevelComplete(level);
+        return info;
+    }
+
+    static void handleRequest(Session& session, const RequestHeader& header, const char* body, std::vector<char>& out) {
+        if (header.type != RequestType::LOAD_LEVEL && !session.hasLevel) {
+            respondError(out, header.id, Status::NO_LEVEL, "no level loaded");
+            return;
+        }
+
+        switch (header.type) {
+            case RequestType::LOAD_LEVEL: {
+                std::istringstream in(std::string(body, header.size));
+                std::string error;
+                if (!core::readLevel(in, session.level, error)) {
+                    respondError(out, header.id, Status::INVALID_LEVEL, error);
+                    return;
+                }
+                session.hasLevel = true;
+                session.snapshots.clear();
+                LevelInfo info = { core::hashLevel(session.level), session.level.tiles.GetSideLength(), 0 };
+                respond(out, header.id, Status::OK, &info, sizeof(info));
+                return;
+            }
+            case RequestType::APPLY_MOVES: {
+                for (uint32_t i = 0; i < header.size; i++) {
+                    if ((uint8_t)body[i] > 3) {
+                        respondError(out, header.id, Status::BAD_REQUEST, "move is not a rotation");
+                        return;
+                    }
+                }
+                MovesResult result = {};
+                for (uint32_t i = 0; i < header.size; i++)
+                    result.moved += core::step(session.level, static_cast<Rotation>(body[i])).moved;
+                result.state = stateInfo(session.level);
+                respond(out, header.id, Status::OK, &result, sizeof(result));
+                return;
+            }
+            case RequestType::QUERY_STATE: {
+                StateInfo info = stateInfo(session.level);
+                const bool withTiles = header.size > 0 && body[0] != 0;
+                const int numTiles = withTiles ? session.level.tiles.GetNumTiles() : 0;
+                ResponseHeader response = { (uint32_t)(sizeof(info) + numTiles), header.id, Status::OK, {} };
+                append(out, response);
+                append(out, info);
+                for (int i = 0; i < numTiles; i++)
+                    out.push_back(core::tileGlyph(session.level.tiles.Get(i)));
+                return;
+            }
+            case RequestType::SNAPSHOT: {
+                if ((int)session.snapshots.size() == maxSnapshots) {
+                    respondError(out, header.id, Status::BAD_REQUEST, "too many snapshots");
+                    return;
+                }
+                uint32_t snapshotId = (uint32_t)session.snapshots.size();
+                session.snapshots.push_back(session.level);
+                respond(out, header.id, Status::OK, &snapshotId, sizeof(snapshotId));
+                return;
+            }
+            case RequestType::RESTORE: {
+                uint32_t snapshotId;
+                if (header.size != sizeof(snapshotId)) {
+                    respondError(out, header.id, Status::BAD_REQUEST, "expected a snapshot id");
+                    return;
+                }
+                std::memcpy(&snapshotId, body, sizeof(snapshotId));
+                if (snapshotId >= session.snapshots.size()) {
+                    respondError(out, header.id, Status::UNKNOWN_SNAPSHOT, "unknown snapshot");
+                    return;
+                }
+                session.level = session.snapshots[snapshotId];
+                StateInfo info = stateInfo(session.level);
+                respond(out, header.id, Status::OK, &info, sizeof(info));
+                return;
+            }
+        }
+        respondError(out, header.id, Status::BAD_REQUEST, "unknown request type");
+    }
+
+    Server::Server(const std::string& socketPath, int numThreads) :
+        m_SocketPath(socketPath),
+        m_NumThreads(numThreads > 0 ? numThreads : (int)std::max(1u, std::thread::hardware_concurrency())),
+        m_ListenFd(-1),
+        m_Epoll(-1),
+        m_Workers(),
+        m_Stopping(false),
+        m_Requests(0),
+        m_Accepted(0),
+        m_ConnectionsMutex(),
+        m_Connections()
+    {
+    }
+
+    Server::~Server() {
+        Stop();
+    }
+
+    bool Server::Start(std::string& error) {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (m_SocketPath.size() >= sizeof(address.sun_path)) {
+            error = "socket path too long";
+            return false;
+        }
+        std::strcpy(address.sun_path, m_SocketPath.c_str());
+
+        m_ListenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_ListenFd == -1) {
+            error = std::string("socket: ") + std::strerror(errno);
+            return false;
+        }
+
+        // a stale socket file from a previous run would make bind fail
+        unlink(m_SocketPath.c_str());
+        if (bind(m_ListenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 ||
+                listen(m_ListenFd, SOMAXCONN) == -1) {
+            error = m_SocketPath + ": " + std::strerror(errno);
+            close(m_ListenFd);
+            m_ListenFd = -1;
+            return false;
+        }
+
+        m_Epoll = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.ptr = nullptr; // the listening socket
+        epoll_ctl(m_Epoll, EPOLL_CTL_ADD, m_ListenFd, &event);
+
+        m_Stopping = false;
+        for (int i = 0; i < m_NumThreads; i++)
+            m_Workers.emplace_back(&Server::WorkerLoop, this);
+        return true;
+    }
+
+    void Server::Stop() {
+        if (m_Workers.empty())
+            return;
+
+        m_Stopping = true;
+        for (std::thread& worker : m_Workers)
+            worker.join();
+        m_Workers.clear();
+
+        for (Connection* connection : m_Connections) {
+            close(connection->fd);
+            delete connection;
+        }
+        m_Connections.clear();
+        close(m_Epoll);
+        close(m_ListenFd);
+        unlink(m_SocketPath.c_str());
+        m_Epoll = -1;
+        m_ListenFd = -1;
+    }
+
+    ServerStats Server::GetStats() const {
+        std::lock_guard lock(m_ConnectionsMutex);
+        return ServerStats{ m_Requests, m_Accepted, (int)m_Connections.size() };
+    }
+
+    void Server::WorkerLoop() {
+        while (!m_Stopping) {
+            epoll_event event;
+            // the timeout is only there to notice Stop()
+            if (epoll_wait(m_Epoll, &event, 1, 100) != 1)
+                continue;
+
+            if (event.data.ptr == nullptr) {
+                AcceptAll();
+                epoll_event rearm = {};
+                rearm.events = EPOLLIN | EPOLLONESHOT;
+                rearm.data.ptr = nullptr;
+                epoll_ctl(m_Epoll, EPOLL_CTL_MOD, m_ListenFd, &rearm);
+                continue;
+            }
+
+            Connection* connection = static_cast<Connection*>(event.data.ptr);
+            if (HandleEvent(*connection, event.events))
+                Rearm(*connection);
+            else
+                Close(connection);
+        }
+    }
+
+    void Server::AcceptAll() {
+        while (true) {
+            int fd = accept4(m_ListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd == -1)
+                return;
+
+            Connection* connection = new Connection{ fd, {}, {}, 0, Session{ core::makeLevelState(1), false, {} }, false };
+            {
+                std::lock_guard lock(m_ConnectionsMutex);
+                m_Connections.insert(connection);
+            }
+            m_Accepted++;
+
+            epoll_event event = {};
+            event.events = EPOLLIN | EPOLLONESHOT;
+            event.data.ptr = connection;
+            epoll_ctl(m_Epoll, EPOLL_CTL_ADD, fd, &event);
+        }
+    }
+
+    static bool hasCompleteRequest(const Connection& connection) {
+        if (connection.in.size() < sizeof(RequestHeader))
+            return false;
+        RequestHeader header;
+        std::memcpy(&header, connection.in.data(), sizeof(header));
+        // an oversized one counts, handling it is what closes the connection
+        return header.size > maxBodySize || connection.in.size() - sizeof(header) >= header.size;
+    }
+
+    bool Server::HandleEvent(Connection& connection, uint32_t events) {
+        if (events & EPOLLERR)
+            return false;
+
+        if ((events & (EPOLLIN | EPOLLHUP)) && !connection.readClosed) {
+            char buffer[64 * 1024];
+            while (true) {
+                ssize_t n = recv(connection.fd, buffer, sizeof(buffer), 0);
+                if (n > 0) {
+                    connection.in.insert(connection.in.end(), buffer, buffer + n);
+                } else if (n == 0) {
+                    connection.readClosed = true;
+                    break;
+                } else {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK)
+                        break;
+                    if (errno == EINTR)
+                        continue;
+                    return false;
+                }
+            }
+        }
+
+        // every complete request that came in, in order. Output held back by a slow reader
+        // is retried here, once it is gone the remaining requests get their turn
+        while (true) {
+            size_t offset = 0;
+            bool failed = false;
+            while (!failed && connection.in.size() - offset >= sizeof(RequestHeader) &&
+                    connection.out.size() - connection.outSent < maxPendingOutput) {
+                RequestHeader header;
+                std::memcpy(&header, connection.in.data() + offset, sizeof(header));
+                if (header.size > maxBodySize)
+                    return false;
+                if (connection.in.size() - offset - sizeof(header) < header.size)
+                    break;
+
+                // a request that throws (out of memory, most likely) ends its own connection, not the server
+                const size_t outSize = connection.out.size();
+                try {
+                    handleRequest(connection.session, header, connection.in.data() + offset + sizeof(header),
+                            connection.out);
+                } catch (const std::exception& e) {
+                    connection.out.resize(outSize);
+                    respondError(connection.out, header.id, header.type == RequestType::LOAD_LEVEL ?
+                            Status::INVALID_LEVEL : Status::BAD_REQUEST, e.what());
+                    failed = true;
+                }
+                offset += sizeof(header) + header.size;
+                m_Requests++;
+            }
+            connection.in.erase(connection.in.begin(), connection.in.begin() + offset);
+            if (failed) {
+                // the session may be half way through a change, nothing else runs on it
+                connection.in.clear();
+                connection.readClosed = true;
+            }
+
+            while (connection.outSent < connection.out.size()) {
+                ssize_t n = send(connection.fd, connection.out.data() + connection.outSent,
+                        connection.out.size() - connection.outSent, MSG_NOSIGNAL);
+                if (n > 0)
+                    connection.outSent += n;
+                else if (n == -1 && errno == EINTR)
+                    continue;
+                else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                    return true;
+                else
+                    return false;
+            }
+            connection.out.clear();
+            connection.outSent = 0;
+
+            // everything sent, go on while requests are left that the output limit held back
+            if (!hasCompleteRequest(connection))
+                return !connection.readClosed;
+        }
+    }
+
+    void Server::Rearm(Connection& connection) {
+        const bool pending = connection.outSent < connection.out.size();
+        epoll_event event = {};
+        event.events = EPOLLONESHOT;
+        // stop reading while the client lags behind on its responses
+        if (connection.out.size() - connection.outSent < maxPendingOutput && !connection.readClosed)
+            event.events |= EPOLLIN;
+        if (pending)
+            event.events |= EPOLLOUT;
+        event.data.ptr = &connection;
+        epoll_ctl(m_Epoll, EPOLL_CTL_MOD, connection.fd, &event);
+    }
+
+    void Server::Close(Connection* connection) {
+        {
+            std::lock_guard lock(m_ConnectionsMutex);
+            m_Connections.erase(connection);
+        }
+        close(connection->fd);
+        delete connection;
+    }
+
+    static std::atomic<bool> interrupted = false;
+
+    static void onSignal(int) {
+        interrupted = true;
+    }
+
+    int serverMain(const char* socketPath, int numThreads) {
+        struct sigaction action = {};
+        action.sa_handler = onSignal;
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+
+        Server server(socketPath, numThreads);
+        std::string error;
+        if (!server.Start(error)) {
+            std::fprintf(stderr, "could not start the server: %s\n", error.c_str());
+            return EXIT_FAILURE;
+        }
+        std::printf("listening on %s\n", socketPath);
+        std::fflush(stdout);
+
+        while (!interrupted)
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        server.Stop();
+        ServerStats stats = server.GetStats();
+        std::printf("served %llu requests over %llu connections\n",
+                (unsigned long long)stats.requests, (unsigned long long)stats.connections);
+        return EXIT_SUCCESS;
+    }
+
+}
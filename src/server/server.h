@@ -0,0 +1,67 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace server {
+    struct Connection;
+
+    struct ServerStats {
+        uint64_t requests;
+        uint64_t connections; // accepted since Start()
+        int openConnections;
+    };
+
+    /*
+        Headless simulation server on a Unix domain socket, see protocol.h.
+
+        A fixed set of worker threads waits on one epoll instance. Every connection is
+        armed one shot, so exactly one worker at a time reads it, runs all its complete
+        requests through the core rules and writes the responses back, and no locking
+        is needed around the session. Every connection owns its own session (level,
+        snapshots), nothing is shared between clients. A client that shuts down its
+        sending side still gets the responses to everything it sent before that.
+    */
+    class Server {
+    public:
+        Server(const std::string& socketPath, int numThreads);
+        ~Server();
+
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        bool Start(std::string& error);
+        void Stop();
+        ServerStats GetStats() const;
+
+    private:
+        void WorkerLoop();
+        void AcceptAll();
+        // false once the connection has to be closed
+        bool HandleEvent(Connection& connection, uint32_t events);
+        void Rearm(Connection& connection);
+        void Close(Connection* connection);
+
+        std::string m_SocketPath;
+        int m_NumThreads;
+        int m_ListenFd;
+        int m_Epoll;
+        std::vector<std::thread> m_Workers;
+        std::atomic<bool> m_Stopping;
+        std::atomic<uint64_t> m_Requests;
+        std::atomic<uint64_t> m_Accepted;
+        mutable std::mutex m_ConnectionsMutex;
+        std::unordered_set<Connection*> m_Connections;
+    };
+
+    // runs a server until SIGINT/SIGTERM, numThreads <= 0 means one per core
+    int serverMain(const char* socketPath, int numThreads);
+}
+
+#endif // SERVER_H
@@ -0,0 +1,184 @@
+#include "tileMeshes.h"
+#include <algorithm>
+#include "render.h"
+#include "core/tileRules.h"
+
+static const std::vector<Layout> tileLayout = {
+    { GL_FLOAT, 3 },
+    { GL_FLOAT, 3 },
+    { GL_FLOAT, 2 }
+};
+
+// light is fixed, faces are told apart by how much of it they get. Indexed by core::MeshShade
+static constexpr float shadeFactor[] = { 1.0f, 0.8f, 0.65f, 0.5f, 0.9f };
+
+// true when the box is entirely on the outer side of one of the clip planes
+static bool outsideView(const glm::mat4& vp, const glm::vec3& min, const glm::vec3& max) {
+    glm::vec4 corners[8];
+    for (int i = 0; i < 8; i++) {
+        corners[i] = vp * glm::vec4(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z, 1.0f);
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        bool allBelow = true;
+        bool allAbove = true;
+        for (const glm::vec4& c : corners) {
+            allBelow &= c[axis] < -c.w;
+            allAbove &= c[axis] > c.w;
+        }
+        if (allBelow || allAbove)
+            return true;
+    }
+    return false;
+}
+
+TileMeshes::TileMeshes() :
+    m_Meshes(),
+    m_Dirty(),
+    m_MeshQuads(),
+    m_Quads(),
+    m_Ebo(0),
+    m_EboQuads(0),
+    m_NumQuads(0),
+    m_AllDirty(true),
+    m_Greedy(true)
+{
+}
+
+void TileMeshes::Init() {
+    // a chunk's quads are always 0..n, so one index buffer for the biggest chunk serves every mesh
+    std::vector<uint32_t> indices = generateQuadIndices(TileChunk::numCells);
+    glGenBuffers(1, &m_Ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    m_EboQuads = TileChunk::numCells;
+    m_Quads.reserve(TileChunk::numCells);
+}
+
+void TileMeshes::MarkAllDirty() {
+    m_AllDirty = true;
+}
+
+void TileMeshes::MarkTileDirty(const TileGrid& tiles, int tileIx) {
+    m_Dirty.push_back(tiles.ChunkOf(tileIx));
+}
+
+void TileMeshes::MarkColumnDirty(const TileGrid& tiles, int tileIx) {
+    const int side = tiles.GetSideLength();
+    const int x = tileIx % side;
+    const int z = tileIx / side;
+    m_Dirty.push_back(tiles.ChunkOf(tileIx));
+    if (x > 0)
+        m_Dirty.push_back(tiles.ChunkOf(tileIx - 1));
+    if (x < side - 1)
+        m_Dirty.push_back(tiles.ChunkOf(tileIx + 1));
+    if (z > 0)
+        m_Dirty.push_back(tiles.ChunkOf(tileIx - side));
+    if (z < side - 1)
+        m_Dirty.push_back(tiles.ChunkOf(tileIx + side));
+}
+
+void TileMeshes::MarkChunkDirty(int chunkIx) {
+    m_Dirty.push_back(chunkIx);
+}
+
+void TileMeshes::SetGreedy(bool greedy) {
+    if (greedy == m_Greedy)
+        return;
+    m_Greedy = greedy;
+    m_AllDirty = true;
+}
+
+void TileMeshes::Update(const LevelState& level) {
+    const TileGrid& tiles = level.tiles;
+    if (m_AllDirty) {
+        m_AllDirty = false;
+        m_Dirty.clear();
+        // chunks that had tiles before, they may be empty (or gone) now
+        for (auto& [chunkIx, chunkMesh] : m_Meshes)
+            m_Dirty.push_back(chunkIx);
+        for (int chunkIx = 0; chunkIx < tiles.GetNumChunks(); chunkIx++) {
+            const TileChunk* chunk = tiles.GetChunk(chunkIx);
+            const VoxelChunk* voxels = level.voxels.GetChunk(chunkIx);
+            const bool used = (chunk != nullptr && chunk->numOccupied > 0) || (voxels != nullptr && voxels->numSolid > 0);
+            if (used && !m_Meshes.contains(chunkIx))
+                m_Dirty.push_back(chunkIx);
+        }
+    }
+
+    std::sort(m_Dirty.begin(), m_Dirty.end());
+    m_Dirty.erase(std::unique(m_Dirty.begin(), m_Dirty.end()), m_Dirty.end());
+    for (int chunkIx : m_Dirty)
+        Rebuild(level, chunkIx);
+    m_Dirty.clear();
+}
+
+void TileMeshes::Rebuild(const LevelState& level, int chunkIx) {
+    m_MeshQuads.clear();
+    m_Quads.clear();
+    if (chunkIx < level.tiles.GetNumChunks())
+        core::meshChunk(level.tiles, level.voxels, chunkIx, m_Greedy, m_MeshQuads);
+
+    glm::vec3 min = glm::vec3(1e30f);
+    glm::vec3 max = glm::vec3(-1e30f);
+    for (const core::MeshQuad& quad : m_MeshQuads) {
+        const uint32_t hex = quad.voxel ? core::voxelInfo[quad.type].color : core::tileInfo[quad.type].color;
+        const glm::vec3 color = hexToRgb(hex) * shadeFactor[(int)quad.shade];
+        // in tiles, so the border the tile shader draws repeats over a merged quad
+        const glm::vec2 texture[4] = {
+            glm::vec2(0.0f, 0.0f),
+            glm::vec2(quad.width, 0.0f),
+            glm::vec2(quad.width, quad.height),
+            glm::vec2(0.0f, quad.height)
+        };
+        Tile& tile = m_Quads.emplace_back();
+        for (int c = 0; c < Tile::numVertices; c++) {
+            const glm::vec3 position = glm::vec3(quad.corners[c][0], quad.corners[c][1], quad.corners[c][2]);
+            tile.tileVertices[c] = Vertex{ position, color, texture[c] };
+            min = glm::min(min, position);
+            max = glm::max(max, position);
+        }
+    }
+
+    if (m_Quads.size() > m_EboQuads) {
+        // same buffer, so the meshes already pointing at it see the longer one
+        m_EboQuads = std::max(m_Quads.size(), m_EboQuads * 2);
+        std::vector<uint32_t> indices = generateQuadIndices(m_EboQuads);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    auto it = m_Meshes.find(chunkIx);
+    if (it != m_Meshes.end()) {
+        m_NumQuads -= it->second.numQuads;
+    } else {
+        if (m_Quads.empty())
+            return;
+        it = m_Meshes.emplace(chunkIx, ChunkMesh{ Mesh(m_Quads.data(), m_Quads.size() * Tile::numVertices,
+                m_Quads.size() * sizeof(Tile), tileLayout, GL_DYNAMIC_DRAW), 0, min, max }).first;
+    }
+
+    // the GL objects of a chunk are kept even when it empties, it is likely to be painted again
+    ChunkMesh& chunkMesh = it->second;
+    chunkMesh.mesh.SetBufferData(m_Quads.size() * Tile::numVertices, m_Quads.size() * sizeof(Tile),
+            m_Quads.data(), GL_DYNAMIC_DRAW);
+    chunkMesh.mesh.SetSharedElementBuffer(m_Ebo, m_Quads.size() * 6);
+    chunkMesh.numQuads = (int)m_Quads.size();
+    chunkMesh.min = min;
+    chunkMesh.max = max;
+    m_NumQuads += m_Quads.size();
+}
+
+int TileMeshes::Render(const glm::mat4& vp) {
+    int drawn = 0;
+    for (auto& [chunkIx, chunkMesh] : m_Meshes) {
+        if (chunkMesh.numQuads == 0 || outsideView(vp, chunkMesh.min, chunkMesh.max))
+            continue;
+        chunkMesh.mesh.BindVao();
+        glDrawElements(GL_TRIANGLES, chunkMesh.mesh.GetNumIndices(), GL_UNSIGNED_INT, 0);
+        drawn++;
+    }
+    return drawn;
+}
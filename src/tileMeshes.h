@@ -0,0 +1,92 @@
+#ifndef TILE_MESHES_H
+#define TILE_MESHES_H
+
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "mesh.h"
+#include "core/chunkMesher.h"
+#include "core/levelState.h"
+
+struct Vertex {
+    glm::vec3 position;
+    glm::vec3 color;
+    glm::vec2 texture; // Probably I can cut this
+};
+
+struct Tile {
+    void SetColor(const glm::vec3& color) {
+        for (auto& vertex : tileVertices) {
+            vertex.color = color;
+        }
+    }
+
+    static constexpr int numVertices = 4;
+    Vertex tileVertices[numVertices]; // mesh
+};
+
+/*
+    Meshes of the level tiles and voxels, one per TileGrid chunk.
+
+    Only chunks with tiles or voxels in them get a mesh, and a mesh only holds the
+    faces that can be seen, merged into larger quads by core::meshChunk (greedy
+    meshing), so the vertex memory goes with the surface of what is in the level and
+    not its area. A change rebuilds the chunks it touched, chunks outside the view
+    are not drawn. All the meshes share one element buffer, grown to the biggest
+    chunk seen so far.
+*/
+class TileMeshes {
+public:
+    TileMeshes();
+
+    // needs the GL context
+    void Init();
+    // the whole level changed (loaded, resized, edited in bulk)
+    void MarkAllDirty();
+    void MarkTileDirty(const TileGrid& tiles, int tileIx);
+    // a voxel column changed, the faces of the chunks next to it can change too
+    void MarkColumnDirty(const TileGrid& tiles, int tileIx);
+    // a chunk that was streamed in or out
+    void MarkChunkDirty(int chunkIx);
+    // rebuilds what was marked since the last call
+    void Update(const LevelState& level);
+    // returns the number of chunks drawn
+    int Render(const glm::mat4& vp);
+
+    // one quad per face without, for comparing. Rebuilds everything
+    void SetGreedy(bool greedy);
+
+    inline bool GetGreedy() const {
+        return m_Greedy;
+    }
+
+    inline size_t GetNumQuads() const {
+        return m_NumQuads;
+    }
+
+    inline size_t GetNumMeshes() const {
+        return m_Meshes.size();
+    }
+
+private:
+    struct ChunkMesh {
+        Mesh mesh;
+        int numQuads;
+        glm::vec3 min; // bounds, for culling
+        glm::vec3 max;
+    };
+
+    void Rebuild(const LevelState& level, int chunkIx);
+
+    std::unordered_map<int, ChunkMesh> m_Meshes; // by chunk index
+    std::vector<int> m_Dirty;
+    std::vector<core::MeshQuad> m_MeshQuads; // scratch
+    std::vector<Tile> m_Quads; // scratch
+    uint32_t m_Ebo;
+    size_t m_EboQuads; // quads the element buffer has indices for
+    size_t m_NumQuads;
+    bool m_AllDirty;
+    bool m_Greedy;
+};
+
+#endif // TILE_MESHES_H
@@ -0,0 +1,56 @@
+// aggregate throughput of core::BatchEnv for growing numbers of instances on a 100x100 level
+// usage: core-batch-bench [steps per run] [threads]
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "core/batchEnv.h"
+#include "core/rules.h"
+
+static LevelState makeBenchLevel(int sideLength) {
+    LevelState state = core::makeLevelState(sideLength);
+    for (int i = 0; i < state.tiles.GetNumTiles(); i++)
+        state.tiles.Set(i, (i % 3 == 0) ? TileType::DARK_TILE : TileType::GROUND_TILE);
+    return state;
+}
+
+static double run(const LevelState& level, int numInstances, int numThreads, long totalSteps) {
+    core::BatchEnv env(level, numInstances, numThreads);
+
+    // a few batches of actions prepared up front, so the timing is the stepping only
+    static constexpr int numBatches = 16;
+    std::vector<uint8_t> actions((size_t)numInstances * numBatches);
+    uint32_t rng = 0x9E3779B9u;
+    for (uint8_t& action : actions) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        action = rng & 3;
+    }
+
+    const long numCalls = std::max(16L, totalSteps / numInstances);
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < numCalls; i++)
+        env.Step(actions.data() + (size_t)(i % numBatches) * numInstances);
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return numCalls * (double)numInstances / seconds;
+}
+
+int main(int argc, char** argv) {
+    static constexpr int sideNum = 100;
+    const long totalSteps = argc > 1 ? std::atol(argv[1]) : 20'000'000;
+    const int maxThreads = argc > 2 ? std::atoi(argv[2]) : (int)std::max(1u, std::thread::hardware_concurrency());
+
+    LevelState level = makeBenchLevel(sideNum);
+    std::printf("grid %dx%d, %ld steps per run\n", sideNum, sideNum, totalSteps);
+    std::printf("%10s %16s %16s (%d threads)\n", "instances", "steps/sec 1T", "steps/sec MT", maxThreads);
+    for (int n = 1; n <= 65536; n *= 4) {
+        double single = run(level, n, 1, totalSteps);
+        double multi = maxThreads > 1 ? run(level, n, maxThreads, totalSteps) : single;
+        std::printf("%10d %16.0f %16.0f\n", n, single, multi);
+    }
+}
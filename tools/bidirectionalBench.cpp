@@ -0,0 +1,77 @@
+// core::solveBidirectional against core::solveBfs, the forward only search
+// usage: core-bidirectional-bench [level files or directories, res/levels by default] [--max-states n]
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "Config.h"
+#include "core/levelFile.h"
+#include "core/solver.h"
+
+static const char* const statusNames[] = { "solved", "unsolvable", "gave up", "failed" };
+
+static void addLevels(const std::filesystem::path& directory, std::vector<std::string>& paths) {
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() == ".txt")
+            paths.push_back(entry.path().string());
+    }
+}
+
+int main(int argc, char** argv) {
+    core::SolveOptions options;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--max-states") == 0 && i + 1 < argc)
+            options.maxStates = std::atoll(argv[++i]);
+        else if (std::filesystem::is_directory(argv[i]))
+            addLevels(argv[i], paths);
+        else
+            paths.push_back(argv[i]);
+    }
+    if (paths.empty())
+        addLevels(PROJECT_SOURCE_DIR "/res/levels", paths);
+    std::sort(paths.begin(), paths.end());
+
+    int failures = 0;
+    for (const std::string& path : paths) {
+        LevelState level;
+        std::string error;
+        if (!core::loadLevelFile(path, level, error)) {
+            std::printf("%s: %s\n", path.c_str(), error.c_str());
+            failures++;
+            continue;
+        }
+        const core::StateSpace space(level);
+        std::printf("%s: %d cells, %d toggles, %d goal states\n", std::filesystem::path(path).filename().string().c_str(),
+                space.GetNumCells(), space.GetNumToggles(), (int)(space.GetGoalStates().size() / space.GetNumWords()));
+
+        const core::SolveResult results[] = {
+            core::solveBfs(space, options),
+            core::solveBidirectional(space, options),
+        };
+        const char* const names[] = { "bfs", "bidirectional" };
+        std::printf("    %-14s %-10s %6s %12s %12s %10s %10s\n", "solver", "result", "moves", "expanded",
+                "visited", "ms", "vs bfs");
+        for (int s = 0; s < 2; s++) {
+            const core::SolveResult& result = results[s];
+            std::printf("    %-14s %-10s %6d %12lld %12lld %10.1f %9.1fx\n", names[s], statusNames[(int)result.status],
+                    result.status == core::SolveStatus::SOLVED ? (int)result.moves.size() : -1,
+                    (long long)result.expanded, (long long)result.visited, result.seconds * 1000.0,
+                    (double)results[0].expanded / std::max<int64_t>(result.expanded, 1));
+        }
+        // the meeting point may differ, the length may not
+        const core::SolveResult& result = results[1];
+        if ((results[0].status != core::SolveStatus::GAVE_UP && result.status != core::SolveStatus::GAVE_UP &&
+                    result.status != results[0].status) ||
+                (result.status == core::SolveStatus::SOLVED && (!core::checkSolution(level, result.moves) ||
+                    (results[0].status == core::SolveStatus::SOLVED && result.moves.size() != results[0].moves.size())))) {
+            std::printf("    bidirectional disagrees with bfs\n");
+            failures++;
+        }
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,150 @@
+// headless throughput benchmark for the game rules: random walk on a 100x100 level
+// usage: core-bench [numMoves] [replay file to save the walk to]
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include "core/rules.h"
+#include "core/simulation.h"
+#include "core/undoLog.h"
+#include "core/replay.h"
+
+static LevelState makeBenchLevel(int sideLength) {
+    LevelState state = core::makeLevelState(sideLength);
+    for (int i = 0; i < state.tiles.GetNumTiles(); i++)
+        state.tiles.Set(i, (i % 3 == 0) ? TileType::DARK_TILE : TileType::GROUND_TILE);
+    return state;
+}
+
+int main(int argc, char** argv) {
+    static constexpr int sideNum = 100;
+    const long numMoves = argc > 1 ? std::atol(argv[1]) : 50'000'000;
+
+    LevelState state = makeBenchLevel(sideNum);
+
+    // xorshift so that every run walks the exact same path
+    uint32_t rng = 0x9E3779B9u;
+    long moved = 0;
+    long toggled = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < numMoves; i++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        core::StepResult result = core::step(state, static_cast<Rotation>(rng & 3));
+        moved += result.moved;
+        toggled += result.numChangedTiles;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::printf("grid:        %dx%d\n", sideNum, sideNum);
+    std::printf("moves:       %ld (%ld legal, %ld tile toggles)\n", numMoves, moved, toggled);
+    std::printf("time:        %.3f s\n", seconds);
+    std::printf("moves/sec:   %.0f\n", numMoves / seconds);
+    std::printf("final pos:   (%d, %d)\n", state.player.x, state.player.z);
+
+    // the fixed step simulation run headless: no frames, just ticks back to back
+    LevelState simState = makeBenchLevel(sideNum);
+    core::Simulation simulation = core::Simulation(simState);
+    const long numTicks = numMoves / 10;
+
+    start = std::chrono::steady_clock::now();
+    for (long i = 0; i < numTicks; i++) {
+        if (simulation.GetQueue().Empty()) {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            simulation.RequestRoll(static_cast<Rotation>(rng & 3), simulation.GetTime());
+        }
+        simulation.Tick();
+    }
+    end = std::chrono::steady_clock::now();
+
+    seconds = std::chrono::duration<double>(end - start).count();
+    const double simulated = numTicks / (double)simulation.GetConfig().tickRate;
+    std::printf("sim ticks:   %ld at %d Hz (%.0f s of game time)\n", numTicks,
+            simulation.GetConfig().tickRate, simulated);
+    std::printf("ticks/sec:   %.0f (%.0fx real time)\n", numTicks / seconds, simulated / seconds);
+
+    // recording every roll, then walking the whole history back and jumping around in it
+    LevelState undoState = makeBenchLevel(sideNum);
+    core::UndoLog undoLog;
+    const long numRecorded = numMoves / 10;
+
+    start = std::chrono::steady_clock::now();
+    for (long i = 0; i < numRecorded; i++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        undoLog.Step(undoState, static_cast<Rotation>(rng & 3));
+    }
+    end = std::chrono::steady_clock::now();
+    const double recordSeconds = std::chrono::duration<double>(end - start).count();
+
+    start = std::chrono::steady_clock::now();
+    long numUndone = 0;
+    while (undoLog.Undo(undoState))
+        numUndone++;
+    end = std::chrono::steady_clock::now();
+    const double undoSeconds = std::chrono::duration<double>(end - start).count();
+
+    const int numSeeks = 10000;
+    const int64_t span = undoLog.GetLastMove() - undoLog.GetFirstMove() + 1;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numSeeks; i++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        undoLog.Seek(undoState, undoLog.GetFirstMove() + rng % span);
+    }
+    end = std::chrono::steady_clock::now();
+    const double seekSeconds = std::chrono::duration<double>(end - start).count();
+
+    std::printf("undo log:    %ld rolls kept in %.1f KB\n", numUndone, undoLog.GetMemoryUsage() / 1024.0);
+    std::printf("record/sec:  %.0f\n", numRecorded / recordSeconds);
+    std::printf("undo/sec:    %.0f\n", numUndone / undoSeconds);
+    std::printf("seek:        %.2f us avg\n", seekSeconds * 1e6 / numSeeks);
+
+    // snapshots of a big level, what the editor takes when play testing starts. The first
+    // write to a chunk after one copies that chunk
+    static constexpr int snapshotSide = 4096;
+    static constexpr int numSnapshots = 100;
+    LevelState bigLevel = makeBenchLevel(snapshotSide);
+    double snapshotSeconds = 0.0;
+    double writeSeconds = 0.0;
+    for (int i = 0; i < numSnapshots; i++) {
+        start = std::chrono::steady_clock::now();
+        LevelState snapshot = bigLevel;
+        end = std::chrono::steady_clock::now();
+        snapshotSeconds += std::chrono::duration<double>(end - start).count();
+        start = std::chrono::steady_clock::now();
+        core::step(bigLevel, static_cast<Rotation>(i & 3));
+        end = std::chrono::steady_clock::now();
+        writeSeconds += std::chrono::duration<double>(end - start).count();
+    }
+    std::printf("snapshot:    %.1f us for %dx%d (%d chunks), %.2f us for a roll right after\n",
+            snapshotSeconds * 1e6 / numSnapshots, snapshotSide, snapshotSide, bigLevel.tiles.GetNumChunks(),
+            writeSeconds * 1e6 / numSnapshots);
+
+    // the first random walk again, as a replay for core-replay and regression runs
+    if (argc > 2) {
+        LevelState replayState = makeBenchLevel(sideNum);
+        core::ReplayRecorder recorder;
+        recorder.Start(replayState);
+        rng = 0x9E3779B9u;
+        for (long i = 0; i < numMoves; i++) {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            if (core::step(replayState, static_cast<Rotation>(rng & 3)).moved)
+                recorder.Record(static_cast<Rotation>(rng & 3));
+        }
+        if (!recorder.Save(argv[2])) {
+            std::fprintf(stderr, "could not write %s\n", argv[2]);
+            return EXIT_FAILURE;
+        }
+        std::printf("replay:      %s (level %016llx)\n", argv[2], (unsigned long long)recorder.GetLevelHash());
+    }
+}
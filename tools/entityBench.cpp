@@ -0,0 +1,122 @@
+// core::EntityStore: creating entities, systems over them one by one, block by block and on
+// all threads, and destroying them again
+// usage: core-entity-bench [entities] [threads]
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "core/entityStore.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct Position {
+    float x, y, z;
+};
+
+struct Velocity {
+    float x, y, z;
+};
+
+// only on some entities, so the systems skip a part of the archetypes
+struct Spin {
+    float angle;
+    float speed;
+};
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    const int numEntities = argc > 1 ? std::atoi(argv[1]) : 1'000'000;
+    const int numThreads = argc > 2 ? std::atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    static constexpr int numSteps = 100;
+    static constexpr float dt = 1.0f / 60.0f;
+
+    core::EntityStore entities;
+    std::vector<core::Entity> handles;
+    handles.reserve(numEntities);
+    auto start = Clock::now();
+    for (int i = 0; i < numEntities; i++) {
+        const Position position = { 0.0f, (float)(i % 7), 0.0f };
+        const Velocity velocity = { 1.0f, 0.5f, -1.0f };
+        if (i % 4 == 0)
+            handles.push_back(entities.Create(position, velocity, Spin{ 0.0f, 2.0f }));
+        else if (i % 4 == 1)
+            handles.push_back(entities.Create(position));
+        else
+            handles.push_back(entities.Create(position, velocity));
+    }
+    const double createTime = secondsSince(start);
+    std::printf("%d entities in %d archetypes, created in %.1f ms (%.0f ns each)\n", entities.GetNumEntities(),
+            entities.GetNumArchetypes(), createTime * 1000.0, createTime * 1e9 / numEntities);
+
+    // position += velocity * dt over everything that moves, which is 3 in 4 entities
+    const int numMoving = numEntities - (numEntities + 2) / 4;
+    start = Clock::now();
+    for (int step = 0; step < numSteps; step++) {
+        entities.Each<Position, Velocity>([](core::Entity, Position& position, const Velocity& velocity) {
+            position.x += velocity.x * dt;
+            position.y += velocity.y * dt;
+            position.z += velocity.z * dt;
+        });
+    }
+    const double eachTime = secondsSince(start) / numSteps;
+
+    auto moveBlock = [](int count, const core::Entity*, Position* position, const Velocity* velocity) {
+        for (int i = 0; i < count; i++) {
+            position[i].x += velocity[i].x * dt;
+            position[i].y += velocity[i].y * dt;
+            position[i].z += velocity[i].z * dt;
+        }
+    };
+    start = Clock::now();
+    for (int step = 0; step < numSteps; step++)
+        entities.EachBlock<Position, Velocity>(moveBlock);
+    const double blockTime = secondsSince(start) / numSteps;
+
+    core::ThreadPool pool(numThreads);
+    start = Clock::now();
+    for (int step = 0; step < numSteps; step++)
+        entities.ParallelEachBlock<Position, Velocity>(pool, moveBlock);
+    const double parallelTime = secondsSince(start) / numSteps;
+
+    std::printf("%-28s %10s %12s\n", "move system", "ms/step", "ns/entity");
+    std::printf("%-28s %10.3f %12.2f\n", "Each", eachTime * 1000.0, eachTime * 1e9 / numMoving);
+    std::printf("%-28s %10.3f %12.2f\n", "EachBlock", blockTime * 1000.0, blockTime * 1e9 / numMoving);
+    char label[64];
+    std::snprintf(label, sizeof(label), "ParallelEachBlock, %d threads", pool.GetNumThreads());
+    std::printf("%-28s %10.3f %12.2f\n", label, parallelTime * 1000.0, parallelTime * 1e9 / numMoving);
+
+    // every entity moved the same, wherever the system got to it
+    const float expected = 3.0f * numSteps * dt;
+    long wrong = 0;
+    entities.Each<Position, Velocity>([&](core::Entity, const Position& position, const Velocity&) {
+        wrong += std::abs(position.x - expected) > 0.001f * expected;
+    });
+
+    // handing out a Spin and taking it back moves entities between archetypes
+    start = Clock::now();
+    for (int i = 1; i < numEntities; i += 4)
+        entities.Add(handles[i], Spin{ 0.0f, 1.0f });
+    for (int i = 1; i < numEntities; i += 4)
+        entities.Remove<Spin>(handles[i]);
+    const double changeTime = secondsSince(start);
+
+    start = Clock::now();
+    for (int i = 0; i < numEntities; i += 2)
+        entities.Destroy(handles[i]);
+    for (int i = 0; i < numEntities; i += 2)
+        wrong += entities.IsAlive(handles[i]);
+    const double destroyTime = secondsSince(start);
+    std::printf("add and remove a component: %.0f ns, destroy: %.0f ns, %d left\n",
+            changeTime * 1e9 / (2.0 * ((numEntities + 2) / 4)), destroyTime * 1e9 / ((numEntities + 1) / 2),
+            entities.GetNumEntities());
+    if (wrong != 0) {
+        std::printf("%ld entities wrong\n", wrong);
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,101 @@
+/* C client of libgame1: per call overhead and batched steps/sec on a 100x100 level */
+/* usage: game1-bench [level file] [threads] */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "capi/game1.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* same layout core-bench uses: every third tile dark */
+static game1_level* makeBenchLevel(int sideLength) {
+    size_t size = 64 + (size_t)sideLength * (sideLength + 1);
+    char* text = malloc(size + 1);
+    int n = sprintf(text, "(0,0,0)\n(0,1,2,3,4,5)\n");
+    for (int z = 0; z < sideLength; z++) {
+        for (int x = 0; x < sideLength; x++)
+            text[n++] = (z * sideLength + x) % 3 == 0 ? 'D' : '#';
+        text[n++] = '\n';
+    }
+    text[n] = '\0';
+    game1_level* level = game1_level_parse(text);
+    free(text);
+    return level;
+}
+
+static uint32_t rng = 0x9E3779B9u;
+
+static uint32_t next(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+int main(int argc, char** argv) {
+    game1_level* level = argc > 1 ? game1_level_load(argv[1]) : makeBenchLevel(100);
+    const int numThreads = argc > 2 ? atoi(argv[2]) : 1;
+    if (level == NULL) {
+        fprintf(stderr, "could not load the level: %s\n", game1_last_error());
+        return EXIT_FAILURE;
+    }
+
+    const int side = game1_level_side_length(level);
+    printf("libgame1 api %d, %dx%d level, %d threads\n", game1_api_version(), side, side, numThreads);
+
+    /* the cheapest call there is, as a floor for the overhead of crossing into the library */
+    const long numCalls = 10000000;
+    volatile int sink = 0;
+    double start = now();
+    for (long i = 0; i < numCalls; i++)
+        sink += game1_api_version();
+    double seconds = now() - start;
+    printf("empty call:   %.1f ns\n", seconds * 1e9 / numCalls);
+
+    printf("%10s %14s %16s\n", "instances", "ns/call", "steps/sec");
+    for (int n = 1; n <= 65536; n *= 4) {
+        game1_env* env = game1_env_create(level, n, numThreads);
+        if (env == NULL) {
+            fprintf(stderr, "could not create %d instances: %s\n", n, game1_last_error());
+            return EXIT_FAILURE;
+        }
+
+        /* the library steps the state in place in these */
+        game1_observations obs = { 0 };
+        obs.x = malloc(n * sizeof(int16_t));
+        obs.z = malloc(n * sizeof(int16_t));
+        obs.orientation = malloc(n);
+        obs.done = malloc(n);
+        game1_env_bind(env, &obs);
+
+        uint8_t* actions = malloc(n);
+        for (int i = 0; i < n; i++)
+            actions[i] = next() & 3;
+
+        const long calls = 20000000 / n > 16 ? 20000000 / n : 16;
+        long done = 0;
+        start = now();
+        for (long c = 0; c < calls; c++) {
+            actions[c % n] = next() & 3;
+            game1_env_step(env, actions);
+            done += obs.done[c % n];
+        }
+        seconds = now() - start;
+        printf("%10d %14.1f %16.0f\n", n, seconds * 1e9 / calls, (double)calls * n / seconds);
+        sink += (int)done;
+
+        game1_env_free(env);
+        free(obs.x);
+        free(obs.z);
+        free(obs.orientation);
+        free(obs.done);
+        free(actions);
+    }
+
+    game1_level_free(level);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// core::solveAStar and core::solveIdaStar with a core::PatternDatabase against core::solveBfs
+// usage: core-heuristic-bench [level files or directories, res/levels by default] [--max-states n]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "Config.h"
+#include "core/levelFile.h"
+#include "core/patternDatabase.h"
+#include "core/solver.h"
+
+using Clock = std::chrono::steady_clock;
+
+static const char* const statusNames[] = { "solved", "unsolvable", "gave up", "failed" };
+
+static void addLevels(const std::filesystem::path& directory, std::vector<std::string>& paths) {
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() == ".txt")
+            paths.push_back(entry.path().string());
+    }
+}
+
+int main(int argc, char** argv) {
+    core::SolveOptions options;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--max-states") == 0 && i + 1 < argc)
+            options.maxStates = std::atoll(argv[++i]);
+        else if (std::filesystem::is_directory(argv[i]))
+            addLevels(argv[i], paths);
+        else
+            paths.push_back(argv[i]);
+    }
+    if (paths.empty())
+        addLevels(PROJECT_SOURCE_DIR "/res/levels", paths);
+    std::sort(paths.begin(), paths.end());
+
+    int failures = 0;
+    for (const std::string& path : paths) {
+        LevelState level;
+        std::string error;
+        if (!core::loadLevelFile(path, level, error)) {
+            std::printf("%s: %s\n", path.c_str(), error.c_str());
+            failures++;
+            continue;
+        }
+        const core::StateSpace space(level);
+        const auto start = Clock::now();
+        const core::PatternDatabase heuristic(space);
+        const double buildTime = std::chrono::duration<double>(Clock::now() - start).count();
+        std::printf("%s: %d cells, %d toggles, pattern database %.1f KB in %.2f ms, start estimate %d\n",
+                std::filesystem::path(path).filename().string().c_str(), space.GetNumCells(), space.GetNumToggles(),
+                heuristic.GetNumBytes() / 1024.0, buildTime * 1000.0, heuristic.Estimate(space.GetStart()));
+
+        const core::SolveResult results[] = {
+            core::solveBfs(space, options),
+            core::solveAStar(space, heuristic, options),
+            core::solveIdaStar(space, heuristic, options),
+        };
+        const char* const names[] = { "bfs", "a*", "ida*" };
+        std::printf("    %-6s %-10s %6s %12s %12s %10s %10s\n", "solver", "result", "moves", "expanded",
+                "generated", "ms", "vs bfs");
+        for (int s = 0; s < 3; s++) {
+            const core::SolveResult& result = results[s];
+            std::printf("    %-6s %-10s %6d %12lld %12lld %10.1f %9.1fx\n", names[s], statusNames[(int)result.status],
+                    result.status == core::SolveStatus::SOLVED ? (int)result.moves.size() : -1,
+                    (long long)result.expanded, (long long)result.visited, result.seconds * 1000.0,
+                    (double)results[0].expanded / std::max<int64_t>(result.expanded, 1));
+            // both are optimal, so whatever they find is as long as the bfs solution
+            if (result.status == core::SolveStatus::SOLVED && (!core::checkSolution(level, result.moves) ||
+                        (results[0].status == core::SolveStatus::SOLVED && result.moves.size() != results[0].moves.size()))) {
+                std::printf("    %s found a wrong solution\n", names[s]);
+                failures++;
+            }
+        }
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
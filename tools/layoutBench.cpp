@@ -0,0 +1,160 @@
+// row major vs Morton brick tile layouts (src/core/tileLayout.h) on neighbour heavy kernels
+// usage: core-layout-bench [max side length] [repeats]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "core/tileLayout.h"
+
+// the same padded grid a TileGrid keeps, one byte per cell, 0 = empty
+template <typename Layout>
+struct BenchGrid {
+    Layout layout;
+    int sideLength;
+    std::vector<uint8_t> cells;
+
+    explicit BenchGrid(int side) :
+        layout(side + 2),
+        sideLength(side),
+        cells(layout.GetNumCells(), 0)
+    {
+        // about a quarter of the tiles are holes, the same ones for every layout
+        uint32_t rng = 0x9E3779B9u;
+        for (int z = 1; z <= side; z++) {
+            for (int x = 1; x <= side; x++) {
+                rng ^= rng << 13;
+                rng ^= rng >> 17;
+                rng ^= rng << 5;
+                cells[layout.Index(x, z)] = (rng & 3) != 0;
+            }
+        }
+    }
+};
+
+static uint32_t checksum = 0; // keeps the kernels from being optimized away
+
+// reachability from the center, 4 neighbours, the core of flood fills and solvers
+template <typename Layout>
+static long floodFill(const BenchGrid<Layout>& grid) {
+    const Layout& layout = grid.layout;
+    std::vector<uint8_t> visited(layout.GetNumCells(), 0);
+    std::vector<uint32_t> queue;
+    queue.reserve((size_t)grid.sideLength * grid.sideLength);
+
+    const int center = grid.sideLength / 2 + 1;
+    queue.push_back((uint32_t)center << 16 | (uint32_t)center);
+    visited[layout.Index(center, center)] = 1;
+
+    static constexpr int dx[4] = { 1, -1, 0, 0 };
+    static constexpr int dz[4] = { 0, 0, 1, -1 };
+    for (size_t head = 0; head < queue.size(); head++) {
+        const int x = queue[head] & 0xFFFF;
+        const int z = queue[head] >> 16;
+        for (int d = 0; d < 4; d++) {
+            const int ix = layout.Index(x + dx[d], z + dz[d]);
+            if (grid.cells[ix] && !visited[ix]) {
+                visited[ix] = 1;
+                queue.push_back((uint32_t)(z + dz[d]) << 16 | (uint32_t)(x + dx[d]));
+            }
+        }
+    }
+    checksum += (uint32_t)queue.size();
+    return (long)queue.size();
+}
+
+// number of non empty neighbours of every tile, what meshing and hint overlays do
+template <typename Layout>
+static long stencil(const BenchGrid<Layout>& grid) {
+    const Layout& layout = grid.layout;
+    uint32_t sum = 0;
+    for (int z = 1; z <= grid.sideLength; z++) {
+        for (int x = 1; x <= grid.sideLength; x++) {
+            sum += grid.cells[layout.Index(x + 1, z)] + grid.cells[layout.Index(x - 1, z)] +
+                grid.cells[layout.Index(x, z + 1)] + grid.cells[layout.Index(x, z - 1)];
+        }
+    }
+    checksum += sum;
+    return (long)grid.sideLength * grid.sideLength;
+}
+
+// editor brush: 9x9 squares painted along a random walk
+template <typename Layout>
+static long brush(BenchGrid<Layout>& grid) {
+    static constexpr int radius = 4;
+    const Layout& layout = grid.layout;
+    const int side = grid.sideLength;
+    const long numStrokes = std::max(1L, (long)side * side / 16);
+
+    uint32_t rng = 0x2545F491u;
+    int x = side / 2 + 1;
+    int z = side / 2 + 1;
+    for (long i = 0; i < numStrokes; i++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        x = std::clamp(x + (int)(rng & 7) - 3, 1 + radius, side - radius);
+        z = std::clamp(z + (int)((rng >> 3) & 7) - 3, 1 + radius, side - radius);
+        for (int bz = z - radius; bz <= z + radius; bz++) {
+            for (int bx = x - radius; bx <= x + radius; bx++)
+                grid.cells[layout.Index(bx, bz)] ^= 2;
+        }
+    }
+    checksum += grid.cells[layout.Index(x, z)];
+    return numStrokes * (2 * radius + 1) * (2 * radius + 1);
+}
+
+// walking the columns, the worst case of row major
+template <typename Layout>
+static long columns(const BenchGrid<Layout>& grid) {
+    const Layout& layout = grid.layout;
+    uint32_t sum = 0;
+    for (int x = 1; x <= grid.sideLength; x++) {
+        for (int z = 1; z <= grid.sideLength; z++)
+            sum += grid.cells[layout.Index(x, z)];
+    }
+    checksum += sum;
+    return (long)grid.sideLength * grid.sideLength;
+}
+
+// best of a few runs, in ns per cell touched
+template <typename Kernel>
+static double timeKernel(int repeats, Kernel&& kernel) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; i++) {
+        auto start = std::chrono::steady_clock::now();
+        long cells = kernel();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / cells);
+    }
+    return best;
+}
+
+template <typename Layout>
+static void runLayout(const char* name, int side, int repeats) {
+    BenchGrid<Layout> grid(side);
+    double flood = timeKernel(repeats, [&] { return floodFill(grid); });
+    double near = timeKernel(repeats, [&] { return stencil(grid); });
+    double paint = timeKernel(repeats, [&] { return brush(grid); });
+    double cols = timeKernel(repeats, [&] { return columns(grid); });
+    std::printf("%9d  %-9s  %10.2f  %10.2f  %10.2f  %10.2f  %8.1f\n", side, name, flood, near, paint, cols,
+            grid.cells.size() / (1024.0 * 1024.0));
+}
+
+int main(int argc, char** argv) {
+    const int maxSide = argc > 1 ? std::atoi(argv[1]) : 4096;
+    const int repeats = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    std::printf("ns per cell, best of %d\n", repeats);
+    std::printf("%9s  %-9s  %10s  %10s  %10s  %10s  %8s\n", "grid", "layout", "flood", "stencil", "brush",
+            "columns", "MB/plane8");
+    for (int side : { 100, 256, 1024, 2048, 4096 }) {
+        if (side > maxSide)
+            break;
+        runLayout<RowMajorLayout>("row major", side, repeats);
+        runLayout<MortonLayout>("morton", side, repeats);
+    }
+    std::printf("checksum %u\n", checksum);
+    return 0;
+}
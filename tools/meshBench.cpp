@@ -0,0 +1,123 @@
+// chunk meshing (src/core/chunkMesher.h), one quad per face against greedy, and the voxel raycast
+// usage: core-mesh-bench [side length]
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "core/chunkMesher.h"
+#include "core/rules.h"
+
+using Clock = std::chrono::steady_clock;
+
+static uint32_t nextRandom(uint32_t& rng) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+// every chunk of the level, returns the quads and the time it took
+static size_t meshLevel(const LevelState& level, bool greedy, double& ms) {
+    std::vector<core::MeshQuad> quads;
+    size_t total = 0;
+    auto start = Clock::now();
+    for (int chunkIx = 0; chunkIx < level.tiles.GetNumChunks(); chunkIx++) {
+        quads.clear();
+        core::meshChunk(level.tiles, level.voxels, chunkIx, greedy, quads);
+        total += quads.size();
+    }
+    ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return total;
+}
+
+static void printMeshing(const char* name, const LevelState& level) {
+    double naiveMs, greedyMs;
+    const size_t naive = meshLevel(level, false, naiveMs);
+    const size_t greedy = meshLevel(level, true, greedyMs);
+    std::printf("%-10s  %10d  %12zu  %12zu  %7.1fx  %10.2f  %10.2f\n", name, level.voxels.Count(), naive, greedy,
+            (double)naive / (double)greedy, naiveMs, greedyMs);
+}
+
+int main(int argc, char** argv) {
+    const int sideLength = argc > 1 ? std::atoi(argv[1]) : 1024;
+    const int low = -(sideLength / 2);
+    uint32_t rng = 0x9E3779B9u;
+
+    // all ground, the best case for merging
+    LevelState flat = core::makeLevelState(sideLength);
+    for (int i = 0; i < flat.tiles.GetNumTiles(); i++)
+        flat.tiles.Set(i, TileType::GROUND_TILE);
+
+    // ground and dark tiles in turn, nothing merges
+    LevelState checker = core::makeLevelState(sideLength);
+    for (int i = 0; i < checker.tiles.GetNumTiles(); i++)
+        checker.tiles.Set(i, (i % sideLength + i / sideLength) % 2 ? TileType::DARK_TILE : TileType::GROUND_TILE);
+
+    // ground with walls, stacks and ramps around them, what an edited level looks like
+    LevelState terrain = flat;
+    for (int z = low; z < low + sideLength; z++) {
+        for (int x = low; x < low + sideLength; x++) {
+            const uint32_t r = nextRandom(rng);
+            if ((x & 15) == 0 || (z & 31) == 0) {
+                for (int layer = 0; layer < 4; layer++)
+                    terrain.voxels.Set(x, layer, z, VoxelType::BLOCK);
+            } else if (r % 64 == 0) {
+                const int height = 1 + (int)(r >> 8) % VoxelGrid::numLayers;
+                for (int layer = 0; layer < height; layer++)
+                    terrain.voxels.Set(x, layer, z, VoxelType::BLOCK);
+            } else if (r % 64 == 1) {
+                terrain.voxels.Set(x, 0, z, static_cast<VoxelType>((int)VoxelType::RAMP_DOWN + (r >> 8) % 4));
+            }
+        }
+    }
+
+    std::printf("level:     %dx%d, %d chunks, %d layers\n\n", sideLength, sideLength, flat.tiles.GetNumChunks(),
+            VoxelGrid::numLayers);
+    std::printf("%-10s  %10s  %12s  %12s  %8s  %10s  %10s\n", "level", "voxels", "quads", "greedy", "fewer",
+            "mesh ms", "greedy ms");
+    printMeshing("flat", flat);
+    printMeshing("checker", checker);
+    printMeshing("terrain", terrain);
+
+    // a horizontal ray along x at half a layer up, stopped by a wall at some distance:
+    // the cost goes with the distance and not with the size of the level
+    std::printf("\n%10s  %10s  %10s\n", "distance", "cells", "ns/ray");
+    static constexpr int numRays = 200000;
+    for (int distance : { 1, 8, 64, 512, 4096 }) {
+        if (distance >= sideLength)
+            break;
+        LevelState level = core::makeLevelState(sideLength);
+        for (int z = low; z < low + sideLength; z++)
+            level.voxels.Set(low + distance, 0, z, VoxelType::BLOCK);
+        long cells = 0;
+        int hits = 0;
+        auto start = Clock::now();
+        for (int i = 0; i < numRays; i++) {
+            const float z = low + 0.5f + (float)(i % (sideLength / 2));
+            const core::RayHit hit = core::raycast(level.voxels, { low + 0.25f, 0.5f, z }, { 1.0f, 0.0f, 0.01f });
+            cells += hit.steps;
+            hits += hit.hit;
+        }
+        const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / numRays;
+        std::printf("%10d  %10.1f  %10.1f%s\n", distance, (double)cells / numRays, ns,
+                hits == numRays ? "" : "  (some rays missed)");
+    }
+
+    // editor picking: rays from above at the camera's angle onto random spots of the terrain
+    long cells = 0;
+    int voxelHits = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < numRays; i++) {
+        const float x = low + (float)(nextRandom(rng) % (uint32_t)sideLength) + 0.5f;
+        const float z = low + (float)(nextRandom(rng) % (uint32_t)sideLength) + 0.5f;
+        const core::RayHit hit = core::raycast(terrain.voxels, { x - 50.0f, 50.0f, z + 50.0f }, { 1.0f, -1.0f, -1.0f });
+        cells += hit.steps;
+        voxelHits += hit.hit && !hit.floor;
+    }
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / numRays;
+    std::printf("\npicking:   %.1f cells and %.1f ns per ray on the terrain, %.0f%% hit a voxel\n",
+            (double)cells / numRays, ns, 100.0 * voxelHits / numRays);
+    return 0;
+}
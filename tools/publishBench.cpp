@@ -0,0 +1,107 @@
+// core::LevelPublisher: one thread edits and publishes as fast as it can while readers keep
+// grabbing the latest version and walking it
+// usage: core-publish-bench [readers] [seconds] [side length]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "core/levelPublisher.h"
+#include "core/rules.h"
+
+using Clock = std::chrono::steady_clock;
+
+static uint32_t nextRandom(uint32_t& rng) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+int main(int argc, char** argv) {
+    const int numReaders = argc > 1 ? std::atoi(argv[1]) : (int)std::max(1u, std::thread::hardware_concurrency() - 1);
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 2.0;
+    const int sideLength = argc > 3 ? std::atoi(argv[3]) : 1024;
+    // the editor moves dark tiles around, so every version has exactly this many
+    static constexpr int numDark = 1000;
+
+    LevelState level = core::makeLevelState(sideLength);
+    for (int i = 0; i < level.tiles.GetNumTiles(); i++)
+        level.tiles.Set(i, i < numDark ? TileType::DARK_TILE : TileType::GROUND_TILE);
+
+    core::LevelPublisher publisher;
+    publisher.Publish(level);
+
+    std::atomic<bool> stop = false;
+    std::vector<long> reads(numReaders, 0);
+    std::vector<long> bad(numReaders, 0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < numReaders; r++) {
+        readers.emplace_back([&, r] {
+            const int reader = publisher.RegisterReader();
+            uint64_t last = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                core::LevelPublisher::ReadGuard guard = publisher.Read(reader);
+                // versions only ever go forward, and each one is whole
+                if (guard->number < last || guard->level.tiles.Count(TileType::DARK_TILE) != numDark)
+                    bad[r]++;
+                last = guard->number;
+                // and really there: every few reads count the dark tiles one by one
+                if (reads[r] % 64 == 0) {
+                    int dark = 0;
+                    guard->level.tiles.ForEach(TileType::DARK_TILE, [&](int) { dark++; });
+                    bad[r] += dark != numDark;
+                }
+                reads[r]++;
+            }
+            publisher.UnregisterReader(reader);
+        });
+    }
+
+    uint32_t rng = 0x9E3779B9u;
+    long numPublished = 0;
+    int maxRetired = 0;
+    double publishSeconds = 0.0;
+    double maxPublish = 0.0;
+    auto start = Clock::now();
+    while (std::chrono::duration<double>(Clock::now() - start).count() < seconds) {
+        // a batch of edits: move a few dark tiles
+        for (int i = 0; i < 8; i++) {
+            const int from = (int)(nextRandom(rng) % level.tiles.GetNumTiles());
+            const int to = (int)(nextRandom(rng) % level.tiles.GetNumTiles());
+            if (level.tiles.Get(from) == TileType::DARK_TILE && level.tiles.Get(to) == TileType::GROUND_TILE) {
+                level.tiles.Set(from, TileType::GROUND_TILE);
+                level.tiles.Set(to, TileType::DARK_TILE);
+            }
+        }
+        auto publishStart = Clock::now();
+        publisher.Publish(level);
+        const double publishTime = std::chrono::duration<double>(Clock::now() - publishStart).count();
+        publishSeconds += publishTime;
+        maxPublish = std::max(maxPublish, publishTime);
+        maxRetired = std::max(maxRetired, publisher.GetNumRetired());
+        numPublished++;
+    }
+    stop = true;
+    for (std::thread& thread : readers)
+        thread.join();
+    publisher.Reclaim();
+
+    long totalReads = 0;
+    long totalBad = 0;
+    for (int r = 0; r < numReaders; r++) {
+        totalReads += reads[r];
+        totalBad += bad[r];
+    }
+    std::printf("level %dx%d (%d chunks), %d readers, %.1f s\n", sideLength, sideLength, level.tiles.GetNumChunks(),
+            numReaders, seconds);
+    std::printf("published:   %ld (%.0f/s), publish avg %.2f us, max %.2f us\n", numPublished,
+            numPublished / seconds, publishSeconds * 1e6 / numPublished, maxPublish * 1e6);
+    std::printf("reads:       %ld (%.0f/s per reader)\n", totalReads, totalReads / seconds / numReaders);
+    std::printf("retired:     %d at most waiting for readers, %d left at the end\n", maxRetired, publisher.GetNumRetired());
+    std::printf("bad reads:   %ld\n", totalBad);
+    return totalBad == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
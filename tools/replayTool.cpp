@@ -0,0 +1,61 @@
+// plays a replay file back headless, as fast as possible, and times seeking in it
+// usage: core-replay <replay file> [move to stop at]
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include "core/replay.h"
+#include "core/rules.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <replay file> [move to stop at]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    core::Replay replay;
+    if (!replay.Open(argv[1])) {
+        std::fprintf(stderr, "could not read replay %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    std::printf("level:       %016llx (%dx%d)\n", (unsigned long long)replay.GetLevelHash(),
+            replay.GetSideLength(), replay.GetSideLength());
+    std::printf("moves:       %lld\n", (long long)replay.GetNumMoves());
+
+    LevelState state = core::makeLevelState(replay.GetSideLength());
+    replay.Seek(state, 0);
+    long toggled = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    while (!replay.Done())
+        toggled += replay.Next(state).numChangedTiles;
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::printf("playback:    %.3f s, %.0f moves/sec, %ld tile toggles\n", seconds,
+            replay.GetNumMoves() / seconds, toggled);
+    std::printf("final:       pos (%d, %d), hash %016llx, %s\n", state.player.x, state.player.z,
+            (unsigned long long)core::hashLevel(state), core::isLevelComplete(state) ? "complete" : "not complete");
+
+    // random jumps, each one costs a checkpoint read plus at most one interval of rolls
+    const int numSeeks = 1000;
+    uint32_t rng = 0x9E3779B9u;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numSeeks; i++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        replay.Seek(state, rng % (replay.GetNumMoves() + 1));
+    }
+    end = std::chrono::steady_clock::now();
+    seconds = std::chrono::duration<double>(end - start).count();
+    std::printf("seek:        %.1f us avg\n", seconds * 1e6 / numSeeks);
+
+    if (argc > 2) {
+        replay.Seek(state, std::atoll(argv[2]));
+        std::printf("at move %lld: pos (%d, %d), orientation %d, %d dark, %d light\n",
+                (long long)replay.GetCursor(), state.player.x, state.player.z, state.player.orientation,
+                state.tiles.Count(TileType::DARK_TILE), state.tiles.Count(TileType::LIGHT_TILE));
+    }
+}
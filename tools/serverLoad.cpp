@@ -0,0 +1,195 @@
+// load generator for game-server: C clients, each keeping D requests in flight
+// usage: game-server-load <socket path> [clients] [seconds] [pipeline depth] [moves per request]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "server/protocol.h"
+
+using namespace protocol;
+using Clock = std::chrono::steady_clock;
+
+// same layout core-bench uses: 100x100, every third tile dark
+static std::string benchLevelText() {
+    static constexpr int sideLength = 100;
+    std::string text = "(0,0,0)\n(0,1,2,3,4,5)\n";
+    for (int z = 0; z < sideLength; z++) {
+        for (int x = 0; x < sideLength; x++)
+            text += (z * sideLength + x) % 3 == 0 ? 'D' : '#';
+        text += '\n';
+    }
+    return text;
+}
+
+static bool sendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool recvAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = recv(fd, data, size, 0);
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+static void appendRequest(std::vector<char>& out, RequestType type, uint32_t id, const void* body, uint32_t size) {
+    RequestHeader header = { size, id, type, {} };
+    const char* bytes = reinterpret_cast<const char*>(&header);
+    out.insert(out.end(), bytes, bytes + sizeof(header));
+    out.insert(out.end(), static_cast<const char*>(body), static_cast<const char*>(body) + size);
+}
+
+struct ClientResult {
+    std::vector<double> latencies; // seconds
+    bool failed;
+};
+
+static void runClient(const std::string& socketPath, double seconds, int depth, int movesPerRequest,
+        uint32_t seed, ClientResult& result) {
+    result.failed = true;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1) {
+        std::perror("connect");
+        close(fd);
+        return;
+    }
+
+    std::vector<char> out;
+    std::vector<char> body;
+    ResponseHeader response;
+    const std::string level = benchLevelText();
+    appendRequest(out, RequestType::LOAD_LEVEL, 0, level.data(), (uint32_t)level.size());
+    if (!sendAll(fd, out.data(), out.size()) || !recvAll(fd, (char*)&response, sizeof(response)) ||
+            response.status != Status::OK) {
+        std::fprintf(stderr, "could not load the level\n");
+        close(fd);
+        return;
+    }
+    body.resize(response.size);
+    recvAll(fd, body.data(), body.size());
+
+    // a window of depth requests: one new request goes out for every response that comes back
+    std::vector<Clock::time_point> sentAt(depth);
+    std::vector<uint8_t> moves(movesPerRequest);
+    uint32_t rng = seed;
+    uint32_t nextId = 1;
+    auto sendOne = [&]() {
+        for (uint8_t& move : moves) {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            move = rng & 3;
+        }
+        out.clear();
+        // every 16th request reads the state back instead of moving
+        if (nextId % 16 == 0)
+            appendRequest(out, RequestType::QUERY_STATE, nextId, nullptr, 0);
+        else
+            appendRequest(out, RequestType::APPLY_MOVES, nextId, moves.data(), (uint32_t)moves.size());
+        sentAt[nextId % depth] = Clock::now();
+        nextId++;
+        return sendAll(fd, out.data(), out.size());
+    };
+
+    const Clock::time_point end = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(seconds));
+    for (int i = 0; i < depth; i++) {
+        if (!sendOne()) {
+            close(fd);
+            return;
+        }
+    }
+
+    uint32_t inFlight = depth;
+    while (inFlight > 0) {
+        if (!recvAll(fd, (char*)&response, sizeof(response))) {
+            close(fd);
+            return;
+        }
+        body.resize(response.size);
+        recvAll(fd, body.data(), body.size());
+        Clock::time_point now = Clock::now();
+        result.latencies.push_back(std::chrono::duration<double>(now - sentAt[response.id % depth]).count());
+        inFlight--;
+
+        if (now < end) {
+            if (!sendOne()) {
+                close(fd);
+                return;
+            }
+            inFlight++;
+        }
+    }
+
+    close(fd);
+    result.failed = false;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <socket path> [clients] [seconds] [pipeline depth] [moves per request]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+    const std::string socketPath = argv[1];
+    const int numClients = argc > 2 ? std::atoi(argv[2]) : 16;
+    const double seconds = argc > 3 ? std::atof(argv[3]) : 5.0;
+    const int depth = argc > 4 ? std::max(1, std::atoi(argv[4])) : 8;
+    const int movesPerRequest = argc > 5 ? std::max(1, std::atoi(argv[5])) : 16;
+
+    std::vector<ClientResult> results(numClients);
+    std::vector<std::thread> clients;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < numClients; i++)
+        clients.emplace_back(runClient, socketPath, seconds, depth, movesPerRequest, 0x9E3779B9u + i,
+                std::ref(results[i]));
+    for (std::thread& client : clients)
+        client.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> latencies;
+    int failed = 0;
+    for (const ClientResult& result : results) {
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        failed += result.failed;
+    }
+    if (latencies.empty()) {
+        std::fprintf(stderr, "no request got an answer\n");
+        return EXIT_FAILURE;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[std::min(latencies.size() - 1, (size_t)(p * latencies.size()))] * 1e6;
+    };
+
+    std::printf("clients:     %d (%d failed), pipeline depth %d, %d moves per request\n",
+            numClients, failed, depth, movesPerRequest);
+    std::printf("requests:    %zu in %.2f s\n", latencies.size(), elapsed);
+    std::printf("req/sec:     %.0f\n", latencies.size() / elapsed);
+    std::printf("latency us:  p50 %.1f, p99 %.1f, max %.1f\n", percentile(0.5), percentile(0.99),
+            latencies.back() * 1e6);
+    return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
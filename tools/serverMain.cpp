@@ -0,0 +1,13 @@
+// the simulation server without the game around it, same as `game-1 --server`
+// usage: game-server <socket path> [threads]
+#include <cstdio>
+#include <cstdlib>
+#include "server/server.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <socket path> [threads]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    return server::serverMain(argv[1], argc > 2 ? std::atoi(argv[2]) : 0);
+}
@@ -0,0 +1,63 @@
+// core::solveParallel at 1 to 16 threads against core::solveBfs, on one level
+// usage: core-solve-bench [level file, res/levels/level_4.txt by default] [max threads] [--huge-pages]
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "Config.h"
+#include "core/levelFile.h"
+#include "core/solver.h"
+
+int main(int argc, char** argv) {
+    std::string path = PROJECT_SOURCE_DIR "/res/levels/level_4.txt";
+    int maxThreads = 16;
+    core::SolveOptions options;
+    int numArgs = 0;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--huge-pages") == 0)
+            options.hugePages = true;
+        else if (numArgs++ == 0)
+            path = argv[i];
+        else
+            maxThreads = std::atoi(argv[i]);
+    }
+
+    LevelState level;
+    std::string error;
+    if (!core::loadLevelFile(path, level, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return EXIT_FAILURE;
+    }
+    const core::StateSpace space(level);
+    std::printf("%s: %d cells, %d toggles, %d words per state%s\n", path.c_str(), space.GetNumCells(),
+            space.GetNumToggles(), space.GetNumWords(), options.hugePages ? ", huge pages" : "");
+
+    const core::SolveResult serial = core::solveBfs(space, options);
+    std::printf("%-12s %6s %12s %12s %10s %14s %8s\n", "solver", "moves", "expanded", "visited", "ms",
+            "states/sec", "speedup");
+    std::printf("%-12s %6d %12lld %12lld %10.1f %14.0f %8s\n", "bfs", (int)serial.moves.size(),
+            (long long)serial.expanded, (long long)serial.visited, serial.seconds * 1000.0,
+            serial.expanded / serial.seconds, "");
+
+    int failures = 0;
+    double oneThread = 0.0;
+    for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        options.numThreads = numThreads;
+        const core::SolveResult result = core::solveParallel(space, options);
+        if (numThreads == 1)
+            oneThread = result.seconds;
+        char label[32];
+        std::snprintf(label, sizeof(label), "%d threads", numThreads);
+        std::printf("%-12s %6d %12lld %12lld %10.1f %14.0f %7.2fx\n", label, (int)result.moves.size(),
+                (long long)result.expanded, (long long)result.visited, result.seconds * 1000.0,
+                result.expanded / result.seconds, oneThread / result.seconds);
+        // any shortest solution will do, but it has to be one and as short as the serial one
+        if (result.status != serial.status || result.moves.size() != serial.moves.size() ||
+                (result.status == core::SolveStatus::SOLVED && !core::checkSolution(level, result.moves))) {
+            std::printf("    differs from bfs\n");
+            failures++;
+        }
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,121 @@
+// shortest solutions of level files, by breadth first search over the full game state
+// usage: core-solve [level files or directories, res/levels by default] [--max-states n]
+//     [--external [--max-memory MB] [--temp-dir path]]
+// --external keeps the layers on disk (core::solveExternal) and prints what every one read and wrote
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "Config.h"
+#include "core/levelFile.h"
+#include "core/solver.h"
+
+static const char* const rotationNames[] = { "down", "up", "left", "right" };
+static const char* const statusNames[] = { "solved", "unsolvable", "gave up", "failed" };
+
+static void printUsage(std::FILE* out, const char* program) {
+    std::fprintf(out, "usage: %s [level files or directories, res/levels by default] [--max-states n]\n"
+            "    [--external [--max-memory MB] [--temp-dir path]]\n", program);
+}
+
+int main(int argc, char** argv) {
+    core::SolveOptions options;
+    bool external = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--max-states") == 0 && i + 1 < argc) {
+            options.maxStates = std::atoll(argv[++i]);
+            continue;
+        }
+        if (std::strcmp(argv[i], "--external") == 0) {
+            external = true;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--max-memory") == 0 && i + 1 < argc) {
+            options.maxMemory = std::atoll(argv[++i]) << 20;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--temp-dir") == 0 && i + 1 < argc) {
+            options.tempDirectory = argv[++i];
+            continue;
+        }
+        if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0) {
+            printUsage(stdout, argv[0]);
+            return EXIT_SUCCESS;
+        }
+        // an unknown option, or one without its value, would otherwise be taken for a level
+        if (argv[i][0] == '-') {
+            printUsage(stderr, argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (std::filesystem::is_directory(argv[i])) {
+            for (const auto& entry : std::filesystem::directory_iterator(argv[i])) {
+                if (entry.path().extension() == ".txt")
+                    paths.push_back(entry.path().string());
+            }
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (argc == 1 || paths.empty()) {
+        for (const auto& entry : std::filesystem::directory_iterator(PROJECT_SOURCE_DIR "/res/levels")) {
+            if (entry.path().extension() == ".txt")
+                paths.push_back(entry.path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    int failures = 0;
+    std::printf("%-16s %5s %7s %8s  %-10s %6s %12s %12s %10s %12s\n", "level", "side", "toggles", "words",
+            "result", "moves", "expanded", "visited", "ms", "states/sec");
+    for (const std::string& path : paths) {
+        LevelState level;
+        std::string error;
+        const std::string name = std::filesystem::path(path).filename().string();
+        if (!core::loadLevelFile(path, level, error)) {
+            std::printf("%-16s %s\n", name.c_str(), error.c_str());
+            failures++;
+            continue;
+        }
+
+        const core::StateSpace space(level);
+        std::vector<core::ExternalLayer> layers;
+        const core::SolveResult result = external ? core::solveExternal(space, options, &layers) :
+            core::solveBfs(space, options);
+        std::printf("%-16s %5d %7d %8d  %-10s %6d %12lld %12lld %10.1f %12.0f\n", name.c_str(),
+                level.tiles.GetSideLength(), space.GetNumToggles(), space.GetNumWords(),
+                statusNames[(int)result.status], result.status == core::SolveStatus::SOLVED ? (int)result.moves.size() : -1,
+                (long long)result.expanded, (long long)result.visited, result.seconds * 1000.0,
+                result.expanded / std::max(result.seconds, 1e-9));
+
+        if (!layers.empty()) {
+            std::printf("    %5s %12s %5s %12s %12s\n", "depth", "new states", "runs", "KB written", "KB read");
+            for (const core::ExternalLayer& layer : layers) {
+                // the walk back finds the moves and adds no states
+                if (layer.depth == -1)
+                    std::printf("    %5s %12s %5s %12.1f %12.1f\n", "moves", "", "", layer.bytesWritten / 1024.0,
+                            layer.bytesRead / 1024.0);
+                else
+                    std::printf("    %5d %12lld %5d %12.1f %12.1f\n", layer.depth, (long long)layer.states, layer.runs,
+                            layer.bytesWritten / 1024.0, layer.bytesRead / 1024.0);
+            }
+        }
+
+        if (result.status != core::SolveStatus::SOLVED)
+            continue;
+        std::printf("    ");
+        for (Rotation rotation : result.moves)
+            std::printf(" %s", rotationNames[(int)rotation]);
+        std::printf("\n");
+        // the search runs on its own encoding of the rules, the real ones have to agree
+        if (!core::checkSolution(level, result.moves)) {
+            std::printf("    the moves don't solve the level with core::step()\n");
+            failures++;
+        }
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,143 @@
+// chunk streaming (src/core/chunkStreamer.h) while the cube rolls across a big level in real time
+// usage: core-stream-bench [side length] [seconds per speed] [radius in chunks]
+//        core-stream-bench convert <level.txt> <out.chunks>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include "core/chunkFile.h"
+#include "core/chunkStreamer.h"
+#include "core/levelFile.h"
+#include "core/rules.h"
+
+// so the first read of every chunk really goes to the disk
+static void dropFromPageCache(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static int convert(const char* levelPath, const char* chunkPath) {
+    LevelState level = core::makeLevelState(1);
+    std::string error;
+    if (!core::loadLevelFile(levelPath, level, error)) {
+        std::fprintf(stderr, "%s: %s\n", levelPath, error.c_str());
+        return EXIT_FAILURE;
+    }
+    if (!core::saveChunkFile(chunkPath, level)) {
+        std::fprintf(stderr, "could not write %s\n", chunkPath);
+        return EXIT_FAILURE;
+    }
+    std::printf("%s: %dx%d, %d of %d chunks with tiles\n", chunkPath, level.tiles.GetSideLength(),
+            level.tiles.GetSideLength(), level.tiles.GetNumAllocatedChunks(), level.tiles.GetNumChunks());
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string_view(argv[1]) == "convert") {
+        if (argc != 4) {
+            std::fprintf(stderr, "usage: core-stream-bench convert <level.txt> <out.chunks>\n");
+            return EXIT_FAILURE;
+        }
+        return convert(argv[2], argv[3]);
+    }
+
+    const int sideLength = argc > 1 ? std::atoi(argv[1]) : 4096;
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 2.0;
+    const int radius = argc > 3 ? std::atoi(argv[3]) : 3;
+    const std::string path = (std::filesystem::temp_directory_path() / "core-stream-bench.chunks").string();
+
+    // every tile is there, a third of them dark, so every roll lands and a lot of them
+    // change a chunk that then has to be written back
+    {
+        LevelState level = core::makeLevelState(sideLength);
+        for (int i = 0; i < level.tiles.GetNumTiles(); i++)
+            level.tiles.Set(i, (i % 3 == 0) ? TileType::DARK_TILE : TileType::GROUND_TILE);
+        if (!core::saveChunkFile(path, level)) {
+            std::fprintf(stderr, "could not write %s\n", path.c_str());
+            return EXIT_FAILURE;
+        }
+        std::printf("level:       %dx%d, %d chunks, %.1f MB on disk\n", sideLength, sideLength,
+                level.tiles.GetNumChunks(), std::filesystem::file_size(path) / (1024.0 * 1024.0));
+    }
+    std::printf("radius:      %d chunks, 60 frames/s, page cache dropped before every run\n", radius);
+    std::printf("latency:     ms from the request to the chunk read (read) and in the grid (grid)\n\n");
+    std::printf("%9s  %8s  %8s  %7s  %7s  %7s  %7s  %9s  %9s  %9s  %8s  %8s\n", "rolls/s", "rolls", "blocked",
+            "stalls", "loads", "evicted", "written", "read avg", "read max", "grid max", "resident", "grid MB");
+
+    static constexpr double frameTime = 1.0 / 60.0;
+    for (int speed : { 8, 60, 480, 3840 }) {
+        dropFromPageCache(path);
+
+        LevelState state;
+        core::ChunkStreamer streamer;
+        std::string error;
+        if (!streamer.Open(path, state, error)) {
+            std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+            return EXIT_FAILURE;
+        }
+        streamer.SetConfig({ radius, 1 });
+        streamer.Prefetch(state.tiles, state.player.x, state.player.z);
+        streamer.ResetStats();
+
+        // long straight runs, which is what runs ahead of the loaded area the most
+        uint32_t rng = 0x9E3779B9u;
+        int direction = 0;
+        int runLeft = 0;
+        long rolls = 0;
+        long blocked = 0; // frames where the next roll had to wait for a chunk
+        const int edge = sideLength / 2 - 2;
+
+        auto start = std::chrono::steady_clock::now();
+        for (long frame = 0; frame * frameTime < seconds; frame++) {
+            streamer.Update(state.tiles, state.player.x, state.player.z);
+            streamer.TakeEvents();
+
+            const long due = (long)(frame * frameTime * speed);
+            while (rolls < due) {
+                if (runLeft == 0) {
+                    rng ^= rng << 13;
+                    rng ^= rng >> 17;
+                    rng ^= rng << 5;
+                    direction = rng & 3;
+                    runLeft = 32 + (int)((rng >> 2) & 255);
+                }
+                const int x = state.player.x + core::rollDx[direction];
+                const int z = state.player.z + core::rollDz[direction];
+                if (x < -edge || x > edge || z < -edge || z > edge) {
+                    runLeft = 0;
+                    continue;
+                }
+                if (!streamer.IsReady(state.tiles, x, z)) {
+                    blocked++;
+                    break;
+                }
+                core::step(state, static_cast<Rotation>(direction));
+                runLeft--;
+                rolls++;
+            }
+
+            std::this_thread::sleep_until(start + std::chrono::duration<double>((frame + 1) * frameTime));
+        }
+
+        const core::StreamStats& stats = streamer.GetStats();
+        std::printf("%9d  %8ld  %8ld  %7lld  %7lld  %7lld  %7lld  %9.3f  %9.3f  %9.3f  %8d  %8.2f\n", speed, rolls,
+                blocked, (long long)stats.stalls, (long long)stats.loads, (long long)stats.evictions,
+                (long long)stats.writeBacks, stats.readLatency.Average() * 1000.0, stats.readLatency.max * 1000.0,
+                stats.loadLatency.max * 1000.0, stats.maxResident, state.tiles.GetMemoryUsage() / (1024.0 * 1024.0));
+        if (stats.ioErrors > 0)
+            std::printf("           %lld chunks could not be read\n", (long long)stats.ioErrors);
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
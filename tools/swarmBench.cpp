@@ -0,0 +1,81 @@
+// core::CubeSwarm stepping many cubes on one level, independently and all together
+// usage: core-swarm-bench [cube steps per run] [side length]
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "core/cubeSwarm.h"
+#include "core/rules.h"
+
+using Clock = std::chrono::steady_clock;
+
+static uint32_t nextRandom(uint32_t& rng) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+// ground and dark tiles with a wall every 16 tiles, so cubes bump into things
+static LevelState makeBenchLevel(int sideLength) {
+    LevelState level = core::makeLevelState(sideLength);
+    for (int i = 0; i < level.tiles.GetNumTiles(); i++)
+        level.tiles.Set(i, (i % 3 == 0) ? TileType::DARK_TILE : TileType::GROUND_TILE);
+    const int low = -(sideLength / 2);
+    for (int z = low; z < low + sideLength; z += 16) {
+        for (int x = low; x < low + sideLength; x++) {
+            if (x % 8 != 0)
+                level.voxels.Set(x, 0, z, VoxelType::BLOCK);
+        }
+    }
+    return level;
+}
+
+static void fill(core::CubeSwarm& swarm, LevelState& level, int numCubes, uint32_t& rng) {
+    swarm.Clear(level);
+    const int side = level.tiles.GetSideLength();
+    const int low = -(side / 2);
+    while (swarm.GetNumCubes() < numCubes) {
+        const CubePose pose = { (int16_t)(low + nextRandom(rng) % side), (int16_t)(low + nextRandom(rng) % side), 0 };
+        swarm.Add(level, pose);
+    }
+}
+
+int main(int argc, char** argv) {
+    const long totalSteps = argc > 1 ? std::atol(argv[1]) : 20'000'000;
+    const int sideLength = argc > 2 ? std::atoi(argv[2]) : 1024;
+    uint32_t rng = 0x9E3779B9u;
+
+    std::printf("grid %dx%d, %ld cube steps per run\n", sideLength, sideLength, totalSteps);
+    std::printf("%10s  %16s  %10s  %16s  %10s\n", "cubes", "steps/sec each", "moved", "steps/sec all", "moved");
+    for (int n = 1; n <= 100000 && n <= sideLength * sideLength / 4; n *= 10) {
+        LevelState level = makeBenchLevel(sideLength);
+        core::CubeSwarm swarm;
+        fill(swarm, level, n, rng);
+
+        static constexpr int numBatches = 16;
+        std::vector<uint8_t> actions((size_t)n * numBatches);
+        for (uint8_t& action : actions)
+            action = nextRandom(rng) & 3;
+
+        const long numCalls = std::max(16L, totalSteps / n);
+        long moved = 0;
+        auto start = Clock::now();
+        for (long i = 0; i < numCalls; i++)
+            moved += swarm.Step(level, actions.data() + (size_t)(i % numBatches) * n);
+        const double each = std::chrono::duration<double>(Clock::now() - start).count();
+        const double eachMoved = (double)moved / ((double)numCalls * n);
+
+        // everyone the same way, back and forth so the rows don't pile up at a wall
+        moved = 0;
+        start = Clock::now();
+        for (long i = 0; i < numCalls; i++)
+            moved += swarm.StepAll(level, (i / 8) % 2 ? Rotation::LEFT : Rotation::RIGHT);
+        const double all = std::chrono::duration<double>(Clock::now() - start).count();
+        const double allMoved = (double)moved / ((double)numCalls * n);
+
+        std::printf("%10d  %16.0f  %9.1f%%  %16.0f  %9.1f%%\n", n, numCalls * (double)n / each, 100.0 * eachMoved,
+                numCalls * (double)n / all, 100.0 * allMoved);
+    }
+}
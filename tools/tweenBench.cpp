@@ -0,0 +1,60 @@
+// core::TweenSystem with many tweens at once, every finished one starts the next from its callback
+// usage: core-tween-bench [frames per run]
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+#include "core/tweens.h"
+
+using Clock = std::chrono::steady_clock;
+
+static uint32_t nextRandom(uint32_t& rng) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+int main(int argc, char** argv) {
+    const int numFrames = argc > 1 ? std::atoi(argv[1]) : 600;
+    static constexpr float frameTime = 1.0f / 60.0f;
+    static constexpr double frameBudget = 1.0 / 60.0;
+    uint32_t rng = 0x9E3779B9u;
+
+    std::printf("%d frames of %.1f ms per run, tweens of 0.1 to 1 s\n", numFrames, frameTime * 1000.0f);
+    std::printf("%10s  %14s  %12s  %14s  %12s\n", "tweens", "ns/tween", "us/frame", "finished/frame", "of budget");
+    for (int n = 1000; n <= 1000000; n *= 10) {
+        core::TweenSystem tweens;
+        long numFinished = 0;
+        double checksum = 0.0;
+        // the game's chains (wandering cubes, ghosts) look just like this
+        std::function<void()> restart = [&] {
+            const float duration = 0.1f + (nextRandom(rng) % 1000) * 0.0009f;
+            tweens.Start(0.0f, 1.0f, duration, static_cast<core::Ease>(nextRandom(rng) % 5), 0.0f, restart);
+        };
+        std::vector<core::TweenId> ids;
+        for (int i = 0; i < n; i++) {
+            // staggered like a level's tiles coming in, so they don't all finish on the same frame
+            const float delay = (nextRandom(rng) % 1000) * 0.001f;
+            ids.push_back(tweens.Start(0.0f, 1.0f, 0.5f, core::Ease::OUT_CUBIC, delay, restart));
+        }
+
+        const auto start = Clock::now();
+        for (int frame = 0; frame < numFrames; frame++) {
+            numFinished += tweens.Update(frameTime);
+            // what a renderer would read, the ones started first are long gone by now
+            checksum += tweens.Get(ids[frame % n], 1.0f);
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        const double perFrame = seconds / numFrames;
+
+        if (tweens.GetNumActive() != n) {
+            std::printf("%d tweens running instead of %d\n", tweens.GetNumActive(), n);
+            return EXIT_FAILURE;
+        }
+        std::printf("%10d  %14.2f  %12.1f  %14.0f  %11.2f%%  (%.0f)\n", n, perFrame * 1e9 / n, perFrame * 1e6,
+                (double)numFinished / numFrames, 100.0 * perFrame / frameBudget, checksum);
+    }
+}